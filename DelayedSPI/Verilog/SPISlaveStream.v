@@ -0,0 +1,242 @@
+/* ********************************************************************************************* */
+/* * SPI Slave Module with byte stream interface                                               * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+module SPISlaveStream#(
+		/* Data lines on each direction (1, 2 or 4) */
+		parameter LANES = 1,
+		/* 1 to transfer data on both edges of s_sclk */
+		parameter DDR = 0
+	) (
+		rst_n,
+
+		s_sclk,
+		s_mosi,
+		s_miso,
+
+		p_rx,
+		p_rx_toggle,
+		p_tx,
+		p_sync
+	);
+
+	/* ************************************************************* */
+	/* Timing diagram (SPI mode 0, MSB first, LANES = 1, DDR = 0):   */
+	/*                                                               */
+	/* s_sclk:      ____--__--__--__--__--__--__--__--__--__--__--__ */
+	/* counter:     <0 ><1 ><2 ><3 ><4 ><5 ><6 ><7 ><0 ><1 ><2 ><3  */
+	/* s_mosi:      <b7><b6><b5><b4><b3><b2><b1><b0><b7><b6><b5><b4  */
+	/* s_miso:      <t7><t6><t5><t4><t3><t2><t1><t0><n7><n6><n5><n4  */
+	/* p_rx:        <        previous byte         ><  b7...b0       */
+	/* p_rx_toggle: ______________________________------------------ */
+	/* p_tx:        <    n    ><                 don't care          */
+	/*                                                               */
+	/* p_rx is stable for 8 s_sclk cycles after p_rx_toggle changes. */
+	/* p_tx is sampled on the 4th rising edge of a byte and is sent  */
+	/* during the following byte. Hence a byte decided after         */
+	/* p_rx_toggle changes is sent two bytes later.                  */
+	/*                                                               */
+	/* With several lanes, each beat carries LANES bits of the byte, */
+	/* the most significant one on the highest lane (b7 to b4 on     */
+	/* s_mosi[3:0] first, for instance). A byte takes 8 / LANES      */
+	/* beats, sampled on rising edges. With DDR, beats are sampled   */
+	/* on both edges (rising first), so a byte takes 4 / LANES       */
+	/* s_sclk cycles. p_tx is sampled half a byte after p_rx_toggle  */
+	/* changes (DDR: on the last rising edge of the following byte), */
+	/* and the byte order above holds in all modes. The manager      */
+	/* needs some SYS_CLK cycles to answer in between, which limits  */
+	/* s_sclk for short bytes.                                       */
+	/*                                                               */
+	/* Bytes are only framed by counting beats from reset, so a      */
+	/* stray s_sclk edge shifts all the following ones. While p_sync */
+	/* is high, a beat with all lanes low that follows one with all  */
+	/* lanes high starts a byte (DDR: on a rising edge), and the     */
+	/* bits before it are dropped. The other side sends a run of     */
+	/* 0xFF and then 0x00 bytes to realign (see Manager). With DDR,  */
+	/* a slip of a single edge is thus not undone. With 4 lanes and  */
+	/* DDR, a stray cycle is a whole byte, and bytes stay framed.    */
+	/* ************************************************************* */
+
+	/* Beats per byte and s_sclk cycles per byte */
+	localparam BEATS = 8 / LANES;
+	localparam CYCLES = DDR? (BEATS / 2) : BEATS;
+
+	/* Reset input (assert on low) */
+	input rst_n;
+
+	/* SPI: SCLK */
+	input s_sclk;
+	/* SPI: MOSI lanes */
+	input [LANES-1:0] s_mosi;
+	/* SPI: MISO lanes */
+	output [LANES-1:0] s_miso;
+
+	/* Parallel: last byte received */
+	output [7:0] p_rx;
+	/* Toggles every time a byte is received */
+	output p_rx_toggle;
+	/* Parallel: byte to be sent */
+	input [7:0] p_tx;
+	/* Parallel: realignment allowed (asynchronous) */
+	input p_sync;
+
+	reg [2:0] counter;
+	reg [7:0] rxShift;
+	reg [7:0] rx;
+	reg rxToggle;
+	reg [7:0] txNext;
+	reg [7:0] tx;
+	/* p_sync, synchronised to s_sclk */
+	reg [1:0] syncPrev;
+
+	assign p_rx = rx;
+	assign p_rx_toggle = rxToggle;
+
+	generate
+		if(!DDR) begin: sdr
+			/* Previous beat had all lanes high */
+			reg onesPrev;
+			/* Received bits so far, last beat included */
+			wire [(8+LANES)-1:0] rxWord = {rxShift, s_mosi};
+			/* Beat starts a byte, whatever the count says */
+			wire align = syncPrev[1] && onesPrev && !(|s_mosi);
+			wire [2:0] beat = align? 'h0 : counter;
+
+			assign s_miso = tx[7-:LANES];
+
+			always @(posedge s_sclk or negedge rst_n) begin
+				if(!rst_n) begin
+					counter <= 'h0;
+					rxToggle <= 'b0;
+					txNext <= 'h0;
+					tx <= 'h0;
+					syncPrev <= 'h0;
+					onesPrev <= 'b0;
+				end
+				else begin
+					syncPrev <= {syncPrev[0], p_sync};
+					onesPrev <= &s_mosi;
+
+					/* SPI MOSI Register Feeder. Byte is made available on the last beat */
+					if((CYCLES - 1) == beat) begin
+						rx <= rxWord[7:0];
+						rxToggle <= !rxToggle;
+					end
+					else begin
+						rxShift <= rxWord[7:0];
+					end
+
+					/* Parallel MISO is sampled away from byte boundaries, where the other side changes it */
+					if(((CYCLES / 2) - 1) == beat)
+						txNext <= p_tx;
+
+					/* SPI MISO Register Feeder */
+					tx <= ((CYCLES - 1) == beat)? txNext : (tx << LANES);
+
+					counter <= ((CYCLES - 1) == beat)? 'h0 : (beat + 'h1);
+				end
+			end
+		end
+		else begin: ddr
+			reg [2:0] txCounter;
+			/* Beat sampled on the rising edge */
+			reg [LANES-1:0] rxRise;
+			/* Beat sampled on the last falling edge had all lanes high */
+			reg onesFall;
+			/* Rising edge of this cycle started a byte */
+			reg alignRise;
+			/* Beats sent while s_sclk is high and low */
+			reg [(2*LANES)-1:0] txPair;
+			/* Received bits so far, both beats of the cycle included */
+			wire [(8+(2*LANES))-1:0] rxWord = {rxShift, rxRise, s_mosi};
+			/* Rising edge starts a byte, whatever the count says. A slip of half a cycle is not undone */
+			wire align = syncPrev[1] && onesFall && !(|s_mosi);
+			wire [2:0] beat = alignRise? 'h0 : counter;
+			wire [2:0] txBeat = align? 'h0 : txCounter;
+
+			/* Each beat is set on the edge before the one where the other side samples it */
+			assign s_miso = s_sclk? txPair[(2*LANES)-1:LANES] : txPair[LANES-1:0];
+
+			always @(posedge s_sclk)
+				rxRise <= s_mosi;
+
+			always @(posedge s_sclk or negedge rst_n) begin
+				if(!rst_n) begin
+					syncPrev <= 'h0;
+					alignRise <= 'b0;
+				end
+				else begin
+					syncPrev <= {syncPrev[0], p_sync};
+					alignRise <= align;
+				end
+			end
+
+			/* SPI MOSI Register Feeder. Byte is made available on the last falling edge */
+			always @(negedge s_sclk or negedge rst_n) begin
+				if(!rst_n) begin
+					counter <= 'h0;
+					rxToggle <= 'b0;
+					onesFall <= 'b0;
+				end
+				else begin
+					onesFall <= &s_mosi;
+
+					if((CYCLES - 1) == beat) begin
+						rx <= rxWord[7:0];
+						rxToggle <= !rxToggle;
+					end
+					else begin
+						rxShift <= rxWord[7:0];
+					end
+
+					counter <= ((CYCLES - 1) == beat)? 'h0 : (beat + 'h1);
+				end
+			end
+
+			/* SPI MISO Register Feeder. Next byte is taken from p_tx on the last rising edge, as its first beat goes */
+			/* out right after the last falling edge */
+			always @(posedge s_sclk or negedge rst_n) begin
+				if(!rst_n) begin
+					txCounter <= 'h0;
+					tx <= 'h0;
+					txPair <= 'h0;
+				end
+				else begin
+					if((CYCLES - 1) == txBeat) begin
+						tx <= p_tx;
+						txPair <= {tx[LANES-1:0], p_tx[7-:LANES]};
+					end
+					else begin
+						txPair <= {tx[(7-(2*LANES*txBeat)-LANES)-:LANES], tx[(7-(2*LANES*(txBeat+1)))-:LANES]};
+					end
+
+					txCounter <= ((CYCLES - 1) == txBeat)? 'h0 : (txBeat + 'h1);
+				end
+			end
+		end
+	endgenerate
+
+endmodule
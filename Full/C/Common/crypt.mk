@@ -0,0 +1,82 @@
+#  *********************************************************************************************
+#  * Simple Cryptography Library (Makefile fragment)                                           *
+#  * Authors:                                                                                  *
+#  *     André Bannwart Perina                                                                 *
+#  *     Luciano Falqueto                                                                      *
+#  *     Wallison de Oliveira                                                                  *
+#  *********************************************************************************************
+#  * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             *
+#  *                                                                                           *
+#  * Permission is hereby granted, free of charge, to any person obtaining a copy of this      *
+#  * software and associated documentation files (the "Software"), to deal in the Software     *
+#  * without restriction, including without limitation the rights to use, copy, modify,        *
+#  * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        *
+#  * permit persons to whom the Software is furnished to do so, subject to the following       *
+#  * conditions:                                                                               *
+#  *                                                                                           *
+#  * The above copyright notice and this permission notice shall be included in all copies     *
+#  * or substantial portions of the Software.                                                  *
+#  *                                                                                           *
+#  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       *
+#  * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  *
+#  * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE *
+#  * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+#  * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    *
+#  * DEALINGS IN THE SOFTWARE.                                                                 *
+#  *********************************************************************************************
+
+# This fragment is included by the platform Makefiles. COMMON must point to this folder.
+# Hardware backends are compiled with WITH_BCM2835=1 and/or WITH_MRAA=1.
+# WITH_VERILATOR=1 adds a backend simulating the Quartus project (Verilator 5 must be installed).
+# Parameters of TOP.v may be set with VERILATOR_PARAMS (e.g. VERILATOR_PARAMS="-GCORES=8 -GPIPELINED=1").
+
+CRYPT_HEADERS=$(COMMON)/include/common.h $(COMMON)/include/crypt.h $(COMMON)/include/crypt_backend.h $(COMMON)/include/sha256.h $(COMMON)/include/sha256_mb_template.h \
+	$(COMMON)/include/aes256.h $(COMMON)/include/aes256_bs_template.h
+CRYPT_OBJS=obj/crypt.o obj/fpga.o obj/backend_software.o obj/backend_spidev.o obj/backend_sim.o obj/sha256.o obj/sha256_shani.o obj/sha256_armv8.o \
+	obj/sha256_mb_sse2.o obj/sha256_mb_avx2.o obj/sha256_mb_avx512.o obj/sha256_mb_neon.o \
+	obj/aes256.o obj/aes256_aesni.o obj/aes256_armv8.o obj/aes256_bs_ssse3.o obj/aes256_bs_neon.o
+CRYPT_CCFLAGS=-O2
+CRYPT_LDFLAGS=-lgcrypt
+
+ifeq ($(WITH_BCM2835),1)
+CRYPT_OBJS+=obj/backend_bcm2835.o
+CRYPT_CCFLAGS+=-DCRYPT_WITH_BCM2835
+CRYPT_LDFLAGS+=-lbcm2835
+endif
+
+ifeq ($(WITH_MRAA),1)
+CRYPT_OBJS+=obj/backend_mraa.o
+CRYPT_CCFLAGS+=-DCRYPT_WITH_MRAA
+CRYPT_LDFLAGS+=-lmraa
+endif
+
+ifeq ($(WITH_VERILATOR),1)
+VERILATOR?=verilator
+VERILATOR_ROOT?=$(shell $(VERILATOR) --getenv VERILATOR_ROOT)
+VERILATOR_PARAMS?=
+# Same sources as the Quartus project
+CRYPT_VERILOG=$(COMMON)/../../../DelayedSPI/Verilog/SPISlaveStream.v $(COMMON)/../../Verilog/sha256_w_mem.v \
+	$(COMMON)/../../Verilog/sha256_k_constants.v $(COMMON)/../../Verilog/sha256_core.v $(COMMON)/../../Verilog/sha256_pipe.v $(COMMON)/../../Verilog/Manager.v \
+	$(COMMON)/../../Verilog/BlockFIFO.v $(COMMON)/../../Verilog/AES256Enc.v $(COMMON)/../../Verilog/ActivityLED.v $(COMMON)/../../Quartus/TOP.v
+CRYPT_HEADERS+=$(COMMON)/include/verilator_top.h
+CRYPT_OBJS+=obj/backend_verilator.o obj/verilator_top.o obj/verilator/libVTOP.a obj/verilator/libverilated.a
+CRYPT_CCFLAGS+=-DCRYPT_WITH_VERILATOR
+CRYPT_LDFLAGS+=-lstdc++ -pthread
+
+# Pattern rules, so that none of these becomes the default goal of the including Makefile
+.PRECIOUS: obj/verilator/V%.mk obj/verilator/lib%.a
+
+obj/verilator/V%.mk: $(CRYPT_VERILOG)
+	$(VERILATOR) --cc -Wno-fatal --top-module $* -Mdir obj/verilator $(VERILATOR_PARAMS) $(CRYPT_VERILOG)
+
+obj/verilator/lib%.a: obj/verilator/VTOP.mk
+	$(MAKE) -C obj/verilator -f VTOP.mk OPT_FAST=-O2 lib$*.a
+
+obj/%_top.o: $(COMMON)/src/%_top.cpp $(CRYPT_HEADERS) obj/verilator/libVTOP.a
+	@mkdir -p obj
+	$(CXX) -c $< -o $@ $(CCFLAGS) $(CRYPT_CCFLAGS) -Iobj/verilator -I$(VERILATOR_ROOT)/include -I$(VERILATOR_ROOT)/include/vltstd
+endif
+
+obj/%.o: $(COMMON)/src/%.c $(CRYPT_HEADERS)
+	@mkdir -p obj
+	$(CC) -c $< -o $@ $(CCFLAGS) $(CRYPT_CCFLAGS)
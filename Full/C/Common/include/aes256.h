@@ -0,0 +1,157 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (AES-256 Kernels)                                             * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef AES256_H
+#define AES256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Expanded AES-256 key, in the layouts used by the kernels.
+ */
+typedef struct {
+	/* Encryption round keys */
+	uint8_t enc[15][16] __attribute__((aligned(16)));
+	/* Equivalent inverse cipher round keys (InvMixColumns applied to rounds 1 to 13), in decryption order */
+	uint8_t dec[15][16] __attribute__((aligned(16)));
+	/* Encryption round keys as eight bit planes, each byte 0x00 or 0xff (see aes256_bs_template.h) */
+	uint8_t bs[15][8][16] __attribute__((aligned(16)));
+} aes256_key_t;
+
+/**
+ * @brief Block function. Ciphers or deciphers independent 16-byte blocks in place (i.e. ECB).
+ * @param key Expanded key.
+ * @param blocks Blocks.
+ * @param nBlocks Number of blocks in @p blocks.
+ */
+typedef void (*aes256_blocks_t)(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+
+/* Block functions in use, set by aes256_select(). NULL if AES is left to libgcrypt */
+extern aes256_blocks_t aes256_enc_blocks;
+extern aes256_blocks_t aes256_dec_blocks;
+
+/* Fewest blocks per call for which the block functions beat libgcrypt: 1 with AES instructions, a full set of */
+/* planes with bitsliced kernels (which cost the same for one block as for all of them) */
+extern size_t aes256_min_blocks;
+
+/**
+ * @brief Portable bitsliced block functions, eight blocks at a time.
+ */
+void aes256_enc_blocks_bs(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+void aes256_dec_blocks_bs(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief Block functions using AES-NI, eight blocks interleaved.
+ */
+void aes256_enc_blocks_aesni(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+void aes256_dec_blocks_aesni(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+
+/**
+ * @brief Bitsliced block functions on SSSE3, eight blocks at a time.
+ */
+void aes256_enc_blocks_ssse3(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+void aes256_dec_blocks_ssse3(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+#endif
+
+#if defined(__aarch64__)
+/**
+ * @brief Block functions using ARMv8 Cryptography Extensions, eight blocks interleaved.
+ */
+void aes256_enc_blocks_armv8(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+void aes256_dec_blocks_armv8(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+#endif
+
+#if defined(__aarch64__) || defined(__arm__)
+/**
+ * @brief Bitsliced block functions on NEON, eight blocks at a time (e.g. Cortex-A53 on Raspberry Pi 3, which has
+ *        no AES instructions).
+ */
+void aes256_enc_blocks_neon(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+void aes256_dec_blocks_neon(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks);
+#endif
+
+/**
+ * @brief Select the fastest block functions supported by this CPU.
+ * @note Environment variable CRYPT_AES may be set to "bitsliced" to skip AES instructions, or to "gcrypt" to leave
+ *       all ciphering to libgcrypt.
+ */
+void aes256_select(void);
+
+/**
+ * @brief Get name of block functions in use.
+ * @return Kernel name.
+ */
+const char *aes256_kernel_name(void);
+
+/**
+ * @brief Expand a key for all kernels. Uses no secret-dependent table lookups.
+ * @param key Expanded key.
+ * @param secretKey Key. Must be 32 bytes.
+ */
+void aes256_expand_key(aes256_key_t *key, const uint8_t *secretKey);
+
+/**
+ * @brief Erase an expanded key.
+ * @param key Expanded key.
+ */
+void aes256_wipe_key(aes256_key_t *key);
+
+/**
+ * @brief Cipher a buffer using AES-256 with CBC.
+ * @param key Expanded key.
+ * @param inBuffer Input buffer.
+ * @param encBuffer Ciphered buffer. May be the same as @p inBuffer.
+ * @param buffLen Buffer sizes. Must be a multiple of 16.
+ * @param iniVector Initialisation vector. Must be 16 bytes.
+ */
+void aes256_cbc_enc(const aes256_key_t *key, const uint8_t *inBuffer, uint8_t *encBuffer, size_t buffLen, const uint8_t *iniVector);
+
+/**
+ * @brief Decipher a buffer using AES-256 with CBC. Blocks are deciphered in parallel.
+ * @param key Expanded key.
+ * @param encBuffer Ciphered buffer.
+ * @param outBuffer Output buffer. May be the same as @p encBuffer.
+ * @param buffLen Buffer sizes. Must be a multiple of 16.
+ * @param iniVector Initialisation vector. Must be 16 bytes.
+ */
+void aes256_cbc_dec(const aes256_key_t *key, const uint8_t *encBuffer, uint8_t *outBuffer, size_t buffLen, const uint8_t *iniVector);
+
+/**
+ * @brief Cipher several independent buffers of the same size using AES-256 with CBC. The CBC chains are
+ *        interleaved, so each step of all of them is done with one call to aes256_enc_blocks.
+ * @param key Expanded key.
+ * @param inBuffers Input buffers.
+ * @param encBuffers Ciphered buffers.
+ * @param buffLen Size of each buffer. Must be a multiple of 16.
+ * @param n Number of buffers.
+ * @param iniVector Initialisation vector, the same for all buffers. Must be 16 bytes.
+ */
+void aes256_cbc_enc_batch(const aes256_key_t *key, const uint8_t **inBuffers, uint8_t **encBuffers, size_t buffLen, size_t n, const uint8_t *iniVector);
+
+#endif
@@ -0,0 +1,423 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (AES-256 Bitsliced Kernel Template)                           * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+/* This file is included once per instruction set. Before including it, define AES256_BS_ENC and AES256_BS_DEC, */
+/* the names of the generated block functions. Eight blocks are ciphered at once, bitsliced as in Kasper and */
+/* Schwabe: plane b holds bit b of every byte, and in byte p of a plane, bit k belongs to block k. ShiftRows and */
+/* the row rotations of MixColumns are then byte shuffles of each plane (PSHUFB, VTBL/TBL). The S-box is computed */
+/* with logic gates (Boyar-Peralta circuit), so there are no secret-dependent lookups. */
+/* GCC vector extensions are lowered to whatever vector unit the including file enabled. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "aes256.h"
+
+typedef uint8_t aes256_bs_t __attribute__((vector_size(16)));
+typedef uint64_t aes256_bs64_t __attribute__((vector_size(16)));
+
+#define AES256_BS_BLOCKS 8
+
+/* Byte shuffles, byte p = 4 * column + row as in the AES state */
+#define BS_SHIFT_ROWS ((aes256_bs_t) {0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11})
+#define BS_INV_SHIFT_ROWS ((aes256_bs_t) {0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3})
+#define BS_ROT1 ((aes256_bs_t) {1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12})
+#define BS_ROT2 ((aes256_bs_t) {2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13})
+
+/* Swap the bits selected by mask in b with the bits n positions above in a. Masks keep bits within bytes */
+#define BS_SWAPMOVE(a, b, mask, n) {\
+	aes256_bs64_t t = ((((aes256_bs64_t) (a)) >> (n)) ^ ((aes256_bs64_t) (b))) & (mask);\
+	(b) ^= (aes256_bs_t) t;\
+	(a) ^= (aes256_bs_t) (t << (n));\
+}
+
+/**
+ * @brief Transpose the 8x8 bit matrix at each byte position of eight registers (bit j of register i swaps with
+ *        bit i of register j). Turns eight blocks into eight planes and back.
+ */
+static inline void bs_ortho(aes256_bs_t *q) {
+	BS_SWAPMOVE(q[0], q[1], 0x5555555555555555ULL, 1);
+	BS_SWAPMOVE(q[2], q[3], 0x5555555555555555ULL, 1);
+	BS_SWAPMOVE(q[4], q[5], 0x5555555555555555ULL, 1);
+	BS_SWAPMOVE(q[6], q[7], 0x5555555555555555ULL, 1);
+	BS_SWAPMOVE(q[0], q[2], 0x3333333333333333ULL, 2);
+	BS_SWAPMOVE(q[1], q[3], 0x3333333333333333ULL, 2);
+	BS_SWAPMOVE(q[4], q[6], 0x3333333333333333ULL, 2);
+	BS_SWAPMOVE(q[5], q[7], 0x3333333333333333ULL, 2);
+	BS_SWAPMOVE(q[0], q[4], 0x0f0f0f0f0f0f0f0fULL, 4);
+	BS_SWAPMOVE(q[1], q[5], 0x0f0f0f0f0f0f0f0fULL, 4);
+	BS_SWAPMOVE(q[2], q[6], 0x0f0f0f0f0f0f0f0fULL, 4);
+	BS_SWAPMOVE(q[3], q[7], 0x0f0f0f0f0f0f0f0fULL, 4);
+}
+
+/**
+ * @brief AES S-box on eight planes (Boyar-Peralta, 113 gates). Plane 0 holds the least significant bits.
+ */
+static inline void bs_sbox(aes256_bs_t *q) {
+	aes256_bs_t x0, x1, x2, x3, x4, x5, x6, x7;
+	aes256_bs_t y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11, y12, y13, y14, y15, y16, y17, y18, y19, y20, y21;
+	aes256_bs_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9, z10, z11, z12, z13, z14, z15, z16, z17;
+	aes256_bs_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+	aes256_bs_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29, t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+	aes256_bs_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49, t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+	aes256_bs_t t60, t61, t62, t63, t64, t65, t66, t67;
+	aes256_bs_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+	x0 = q[7];
+	x1 = q[6];
+	x2 = q[5];
+	x3 = q[4];
+	x4 = q[3];
+	x5 = q[2];
+	x6 = q[1];
+	x7 = q[0];
+
+	/* Top linear transformation */
+	y14 = x3 ^ x5;
+	y13 = x0 ^ x6;
+	y9 = x0 ^ x3;
+	y8 = x0 ^ x5;
+	t0 = x1 ^ x2;
+	y1 = t0 ^ x7;
+	y4 = y1 ^ x3;
+	y12 = y13 ^ y14;
+	y2 = y1 ^ x0;
+	y5 = y1 ^ x6;
+	y3 = y5 ^ y8;
+	t1 = x4 ^ y12;
+	y15 = t1 ^ x5;
+	y20 = t1 ^ x1;
+	y6 = y15 ^ x7;
+	y10 = y15 ^ t0;
+	y11 = y20 ^ y9;
+	y7 = x7 ^ y11;
+	y17 = y10 ^ y11;
+	y19 = y10 ^ y8;
+	y16 = t0 ^ y11;
+	y21 = y13 ^ y16;
+	y18 = x0 ^ y16;
+
+	/* Non-linear section (inversion in GF(2^8)) */
+	t2 = y12 & y15;
+	t3 = y3 & y6;
+	t4 = t3 ^ t2;
+	t5 = y4 & x7;
+	t6 = t5 ^ t2;
+	t7 = y13 & y16;
+	t8 = y5 & y1;
+	t9 = t8 ^ t7;
+	t10 = y2 & y7;
+	t11 = t10 ^ t7;
+	t12 = y9 & y11;
+	t13 = y14 & y17;
+	t14 = t13 ^ t12;
+	t15 = y8 & y10;
+	t16 = t15 ^ t12;
+	t17 = t4 ^ t14;
+	t18 = t6 ^ t16;
+	t19 = t9 ^ t14;
+	t20 = t11 ^ t16;
+	t21 = t17 ^ y20;
+	t22 = t18 ^ y19;
+	t23 = t19 ^ y21;
+	t24 = t20 ^ y18;
+
+	t25 = t21 ^ t22;
+	t26 = t21 & t23;
+	t27 = t24 ^ t26;
+	t28 = t25 & t27;
+	t29 = t28 ^ t22;
+	t30 = t23 ^ t24;
+	t31 = t22 ^ t26;
+	t32 = t31 & t30;
+	t33 = t32 ^ t24;
+	t34 = t23 ^ t33;
+	t35 = t27 ^ t33;
+	t36 = t24 & t35;
+	t37 = t36 ^ t34;
+	t38 = t27 ^ t36;
+	t39 = t29 & t38;
+	t40 = t25 ^ t39;
+
+	t41 = t40 ^ t37;
+	t42 = t29 ^ t33;
+	t43 = t29 ^ t40;
+	t44 = t33 ^ t37;
+	t45 = t42 ^ t41;
+	z0 = t44 & y15;
+	z1 = t37 & y6;
+	z2 = t33 & x7;
+	z3 = t43 & y16;
+	z4 = t40 & y1;
+	z5 = t29 & y7;
+	z6 = t42 & y11;
+	z7 = t45 & y17;
+	z8 = t41 & y10;
+	z9 = t44 & y12;
+	z10 = t37 & y3;
+	z11 = t33 & y4;
+	z12 = t43 & y13;
+	z13 = t40 & y5;
+	z14 = t29 & y2;
+	z15 = t42 & y9;
+	z16 = t45 & y14;
+	z17 = t41 & y8;
+
+	/* Bottom linear transformation */
+	t46 = z15 ^ z16;
+	t47 = z10 ^ z11;
+	t48 = z5 ^ z13;
+	t49 = z9 ^ z10;
+	t50 = z2 ^ z12;
+	t51 = z2 ^ z5;
+	t52 = z7 ^ z8;
+	t53 = z0 ^ z3;
+	t54 = z6 ^ z7;
+	t55 = z16 ^ z17;
+	t56 = z12 ^ t48;
+	t57 = t50 ^ t53;
+	t58 = z4 ^ t46;
+	t59 = z3 ^ t54;
+	t60 = t46 ^ t57;
+	t61 = z14 ^ t57;
+	t62 = t52 ^ t58;
+	t63 = t49 ^ t58;
+	t64 = z4 ^ t59;
+	t65 = t61 ^ t62;
+	t66 = z1 ^ t63;
+	s0 = t59 ^ t63;
+	s6 = t56 ^ ~t62;
+	s7 = t48 ^ ~t60;
+	t67 = t64 ^ t65;
+	s3 = t53 ^ t66;
+	s4 = t51 ^ t66;
+	s5 = t47 ^ t65;
+	s1 = t64 ^ ~s3;
+	s2 = t55 ^ ~t67;
+
+	q[7] = s0;
+	q[6] = s1;
+	q[5] = s2;
+	q[4] = s3;
+	q[3] = s4;
+	q[2] = s5;
+	q[1] = s6;
+	q[0] = s7;
+}
+
+/**
+ * @brief Inverse affine transformation of the S-box, in place (b_i = b_(i+2) ^ b_(i+5) ^ b_(i+7) ^ 0x05).
+ */
+static inline void bs_inv_affine(aes256_bs_t *q) {
+	int i;
+	aes256_bs_t t[8];
+
+	for(i = 0; i < 8; i++)
+		t[i] = q[(i + 2) & 7] ^ q[(i + 5) & 7] ^ q[(i + 7) & 7];
+
+	for(i = 0; i < 8; i++)
+		q[i] = t[i];
+
+	q[0] = ~q[0];
+	q[2] = ~q[2];
+}
+
+/**
+ * @brief Inverse AES S-box. Inversion is an involution, so it is the forward circuit wrapped in inverse affines.
+ */
+static inline void bs_inv_sbox(aes256_bs_t *q) {
+	bs_inv_affine(q);
+	bs_sbox(q);
+	bs_inv_affine(q);
+}
+
+/**
+ * @brief ShiftRows: row r is rotated by r columns.
+ */
+static inline void bs_shift_rows(aes256_bs_t *q) {
+	int i;
+
+	for(i = 0; i < 8; i++)
+		q[i] = __builtin_shuffle(q[i], BS_SHIFT_ROWS);
+}
+
+/**
+ * @brief Inverse of bs_shift_rows().
+ */
+static inline void bs_inv_shift_rows(aes256_bs_t *q) {
+	int i;
+
+	for(i = 0; i < 8; i++)
+		q[i] = __builtin_shuffle(q[i], BS_INV_SHIFT_ROWS);
+}
+
+/**
+ * @brief Multiply eight planes by x in GF(2^8).
+ */
+static inline void bs_xtime(aes256_bs_t *out, const aes256_bs_t *in) {
+	out[0] = in[7];
+	out[1] = in[0] ^ in[7];
+	out[2] = in[1];
+	out[3] = in[2] ^ in[7];
+	out[4] = in[3] ^ in[7];
+	out[5] = in[4];
+	out[6] = in[5];
+	out[7] = in[6];
+}
+
+/**
+ * @brief MixColumns. With rot(a) bringing row r + 1 of each column to row r and b = a ^ rot(a),
+ *        2a ^ 3rot(a) ^ rot2(a) ^ rot3(a) = 2b ^ rot(a) ^ rot2(b).
+ */
+static inline void bs_mix_columns(aes256_bs_t *q) {
+	int i;
+	aes256_bs_t a1[8], b[8], b2[8];
+
+	for(i = 0; i < 8; i++) {
+		a1[i] = __builtin_shuffle(q[i], BS_ROT1);
+		b[i] = q[i] ^ a1[i];
+	}
+
+	bs_xtime(b2, b);
+
+	for(i = 0; i < 8; i++)
+		q[i] = b2[i] ^ a1[i] ^ __builtin_shuffle(b[i], BS_ROT2);
+}
+
+/**
+ * @brief InvMixColumns, as MixColumns of a ^ 4(a ^ rot2(a)).
+ */
+static inline void bs_inv_mix_columns(aes256_bs_t *q) {
+	int i;
+	aes256_bs_t d[8], d2[8], d4[8];
+
+	for(i = 0; i < 8; i++)
+		d[i] = q[i] ^ __builtin_shuffle(q[i], BS_ROT2);
+
+	bs_xtime(d2, d);
+	bs_xtime(d4, d2);
+
+	for(i = 0; i < 8; i++)
+		q[i] ^= d4[i];
+
+	bs_mix_columns(q);
+}
+
+/**
+ * @brief Round key addition. Bytes of round key planes are 0x00 or 0xff, i.e. the same bit for every block.
+ */
+static inline void bs_add_round_key(aes256_bs_t *q, const uint8_t (*rk)[16]) {
+	int i;
+
+	for(i = 0; i < 8; i++)
+		q[i] ^= *(const aes256_bs_t *) rk[i];
+}
+
+/**
+ * @brief Load up to AES256_BS_BLOCKS blocks as planes. Missing blocks are left as zero.
+ */
+static inline void bs_load(aes256_bs_t *q, const uint8_t *blocks, size_t nBlocks) {
+	size_t k;
+
+	for(k = 0; k < AES256_BS_BLOCKS; k++) {
+		if(k < nBlocks)
+			memcpy(&q[k], &blocks[16 * k], 16);
+		else
+			q[k] = (aes256_bs_t) {0};
+	}
+
+	bs_ortho(q);
+}
+
+/**
+ * @brief Store the first @p nBlocks blocks held in planes.
+ */
+static inline void bs_store(uint8_t *blocks, aes256_bs_t *q, size_t nBlocks) {
+	size_t k;
+
+	bs_ortho(q);
+
+	for(k = 0; k < nBlocks; k++)
+		memcpy(&blocks[16 * k], &q[k], 16);
+}
+
+/**
+ * @brief Cipher independent blocks in place, AES256_BS_BLOCKS at a time.
+ */
+void AES256_BS_ENC(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks) {
+	int r;
+	size_t n;
+	aes256_bs_t q[8];
+
+	for(; nBlocks; nBlocks -= n, blocks += 16 * n) {
+		n = (nBlocks < AES256_BS_BLOCKS)? nBlocks : AES256_BS_BLOCKS;
+
+		bs_load(q, blocks, n);
+
+		bs_add_round_key(q, key->bs[0]);
+		for(r = 1; r < 14; r++) {
+			bs_sbox(q);
+			bs_shift_rows(q);
+			bs_mix_columns(q);
+			bs_add_round_key(q, key->bs[r]);
+		}
+		bs_sbox(q);
+		bs_shift_rows(q);
+		bs_add_round_key(q, key->bs[14]);
+
+		bs_store(blocks, q, n);
+	}
+}
+
+/**
+ * @brief Decipher independent blocks in place, AES256_BS_BLOCKS at a time.
+ */
+void AES256_BS_DEC(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks) {
+	int r;
+	size_t n;
+	aes256_bs_t q[8];
+
+	for(; nBlocks; nBlocks -= n, blocks += 16 * n) {
+		n = (nBlocks < AES256_BS_BLOCKS)? nBlocks : AES256_BS_BLOCKS;
+
+		bs_load(q, blocks, n);
+
+		bs_add_round_key(q, key->bs[14]);
+		for(r = 13; r > 0; r--) {
+			bs_inv_shift_rows(q);
+			bs_inv_sbox(q);
+			bs_add_round_key(q, key->bs[r]);
+			bs_inv_mix_columns(q);
+		}
+		bs_inv_shift_rows(q);
+		bs_inv_sbox(q);
+		bs_add_round_key(q, key->bs[0]);
+
+		bs_store(blocks, q, n);
+	}
+}
@@ -0,0 +1,476 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library                                                               * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef CRYPT_H
+#define CRYPT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Backend descriptor (see crypt_backend.h) */
+struct crypt_backend_s;
+
+/**
+ * @brief SPI bus statistics, counted by the FPGA protocol for every backend with a transfer function.
+ */
+typedef struct {
+	/* SPI transfers issued */
+	uint64_t transfers;
+	/* SPI clock cycles (8 per byte on a single lane bus, divided by busLanes and by 2 with busDdr) */
+	uint64_t sclkCycles;
+	/* Digests computed by the FPGA */
+	uint64_t digests;
+	/* FPGA system clock cycles elapsed during transfers. Only counted by the verilator backend */
+	uint64_t sysclkCycles;
+	/* CRC mode only: responses received with a bad CRC, times the FPGA reported commands dropped on a bad CRC, and */
+	/* requests (or transactions) sent again because of either */
+	uint64_t crcErrors;
+	uint64_t frameErrors;
+	uint64_t retries;
+} crypt_bus_stats_t;
+
+/**
+ * @brief FPGA performance counters, counted by the FPGA itself from its last reset (see crypt_get_device_stats()).
+ */
+typedef struct {
+	/* FPGA system clock cycles */
+	uint64_t cycles;
+	/* Cycles SHA-256 cores spent hashing and cycles they spent idle (waiting for SPI), summed over all cores */
+	uint64_t busyCycles;
+	uint64_t idleCycles;
+	/* Commands taken (NOPs excluded, each BATCH entry counted), and commands dropped on a bad CRC */
+	uint64_t transactions;
+	uint64_t frameErrors;
+	/* Longest hash of a block, in cycles from its start until its digest is valid */
+	uint64_t maxLatency;
+} crypt_device_stats_t;
+
+/**
+ * @brief Multi-block digest state (see crypt_digest_init()).
+ */
+typedef struct {
+	/* Intermediate hash value, only used by backends that hash in software (and by crypt_digest_resume()) */
+	uint32_t h[8];
+	/* Bytes not yet compressed (always less than a block) */
+	uint8_t buffer[64];
+	/* Message size so far, in bytes */
+	uint64_t length;
+	/* True until first block is compressed */
+	bool first;
+	/* True if h was set by crypt_digest_resume() and is yet to be loaded into the FPGA */
+	bool load;
+} crypt_digest_state_t;
+
+/* Prefix midstates kept by each context (see crypt_digest_prefixed()) */
+#define CRYPT_MIDSTATE_CACHE 8
+
+/**
+ * @brief Cached midstate of a message prefix.
+ */
+typedef struct {
+	/* Whole blocks of the prefix, NULL if entry is free */
+	uint8_t *prefix;
+	/* Prefix size, in bytes (multiple of 64) */
+	unsigned int prefixLen;
+	/* Intermediate hash value after the prefix (H0 to H7, big endian) */
+	uint8_t midstate[32];
+} crypt_midstate_t;
+
+/**
+ * @brief Context structure.
+ */
+typedef struct {
+	/* True if library was initiliased */
+	bool initialised;
+	/* For test purposes, the key is not hidden elsewhere... */
+	char secretKey[32];
+	/* AES-256-CBC cipher handle with expanded key (gcry_cipher_hd_t), set by crypt_set_key() */
+	void *cipher;
+	/* Expanded key for the native AES-256 kernels (aes256_key_t), set by crypt_set_key() */
+	void *aesKey;
+	/* Digest backend selected on initialisation */
+	const struct crypt_backend_s *backend;
+	/* Backend private data. Pointer to void so that computers with no mraa.h (or similar) can use this include */
+	void *spi;
+	/* SPI bus statistics since crypt_initialise() or last crypt_reset_bus_stats() */
+	crypt_bus_stats_t busStats;
+	/* Number of SHA-256 cores of the FPGA, 0 until queried, its features (CRYPT_FPGA_FEATURE_*) and BATCH FIFO size */
+	unsigned int deviceCores;
+	uint8_t deviceFeatures;
+	unsigned int deviceFifo;
+	/* NOPs between the last command of core 0 and READ, raised whenever READ finds the digest not done yet */
+	unsigned int readGap;
+	/* HMAC key midstates (hash value after key ^ ipad and key ^ opad), set by crypt_set_hmac_key() */
+	bool hmacKey;
+	uint8_t hmacIpad[32];
+	uint8_t hmacOpad[32];
+	/* True once HMAC key midstates are loaded into the FPGA */
+	bool hmacLoaded;
+	/* True once the AES-256 key is loaded into the FPGA, along with signIv */
+	bool signLoaded;
+	uint8_t signIv[16];
+	/* SPI data lines on each direction (1, 2 or 4) and transfers on both clock edges. Must match LANES and DDR of TOP.v */
+	unsigned int busLanes;
+	bool busDdr;
+	/* SPI clock in Hz, 0 for backends with no clock to set (see crypt_calibrate()) */
+	uint32_t busHz;
+	/* True if CRC-protected frames are requested. Used only if the FPGA has them (CRYPT_FPGA_FEATURE_CRC) */
+	bool busCrc;
+	/* Commands the FPGA has counted in the status byte (CRYPT_FPGA_STATUS_COUNT), as of the last good READ */
+	unsigned int busCount;
+	/* Prefix midstate cache and next entry to be replaced */
+	crypt_midstate_t midstates[CRYPT_MIDSTATE_CACHE];
+	unsigned int midstateNext;
+} crypt_context_t;
+
+/* Return values */
+#define CRYPT_OK 0
+#define CRYPT_FAILED -1
+
+/* Digest backends */
+#define CRYPT_BACKEND_AUTO 0
+#define CRYPT_BACKEND_SOFTWARE 1
+#define CRYPT_BACKEND_BCM2835 2
+#define CRYPT_BACKEND_MRAA 3
+#define CRYPT_BACKEND_SPIDEV 4
+#define CRYPT_BACKEND_SIM 5
+#define CRYPT_BACKEND_VERILATOR 6
+
+/**
+ * @brief Initialise a context.
+ * @param context Context structure.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note Backend is selected automatically (see crypt_initialise_backend()), unless environment variable
+ *       CRYPT_BACKEND is set to one of "software", "bcm2835", "mraa", "spidev", "sim" or "verilator".
+ */
+int crypt_initialise(crypt_context_t *context);
+
+/**
+ * @brief Initialise a context with a specific digest backend.
+ * @param context Context structure.
+ * @param backend One of CRYPT_BACKEND_*. With CRYPT_BACKEND_AUTO, the first backend that can be opened is used,
+ *        in this order: bcm2835, mraa, spidev, software. SPI backends are only used if an FPGA answers on the bus
+ *        (see crypt_fpga_check()), so that software is the last resort.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note SPI bus width is read from environment variables CRYPT_SPI_LANES (1, 2 or 4, default 1) and CRYPT_SPI_DDR
+ *       (0 or 1, default 0), and must match the bitstream. Wide buses are supported by the spidev and verilator
+ *       backends only. CRC-protected frames are requested with CRYPT_SPI_CRC=1: corrupted requests are then sent
+ *       again transparently, and counted in the bus statistics. With an FPGA backend, the FPGA is resynchronised
+ *       first (see crypt_fpga_resync()), so that it need not be reset between runs.
+ */
+int crypt_initialise_backend(crypt_context_t *context, int backend);
+
+/**
+ * @brief Get backend in use by a context.
+ * @param context Context structure.
+ * @return One of CRYPT_BACKEND_* or CRYPT_FAILED.
+ */
+int crypt_get_backend(crypt_context_t *context);
+
+/**
+ * @brief Get name of backend in use by a context.
+ * @param context Context structure.
+ * @return Backend name or NULL.
+ */
+const char *crypt_get_backend_name(crypt_context_t *context);
+
+/**
+ * @brief Get number of SHA-256 cores of the FPGA in use by a context.
+ * @param context Context structure.
+ * @return Number of cores, 0 for backends with no FPGA or CRYPT_FAILED.
+ * @note crypt_digest_batch() keeps up to this many 32-byte requests in flight. Bitstreams with no INFO command
+ *       are taken as having a single core.
+ */
+int crypt_get_device_cores(crypt_context_t *context);
+
+/**
+ * @brief Get SPI bus statistics of a context.
+ * @param context Context structure.
+ * @param stats Statistics structure to be filled.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note Counters stay at zero for backends with no FPGA. Dividing sclkCycles by digests gives bus cycles per hash.
+ *       crcErrors, frameErrors and retries count link errors caught in CRC mode.
+ */
+int crypt_get_bus_stats(crypt_context_t *context, crypt_bus_stats_t *stats);
+
+/**
+ * @brief Reset SPI bus statistics of a context.
+ * @param context Context structure.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_reset_bus_stats(crypt_context_t *context);
+
+/**
+ * @brief Get the performance counters of the FPGA in use by a context.
+ * @param context Context structure.
+ * @param stats Statistics structure to be filled.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note Counters stay at zero for backends with no FPGA and bitstreams with no STATS command. They run from the FPGA
+ *       reset on (cycle counters wrap after 2^48, the others after 2^32), so the difference between two calls covers
+ *       what was done in between. Busy cycles over busy and idle ones tell how much of the time the cores hash: the
+ *       bus holds the host back when it is low, the cores when it is close to 1.
+ */
+int crypt_get_device_stats(crypt_context_t *context, crypt_device_stats_t *stats);
+
+/**
+ * @brief Get SPI clock of a context.
+ * @param context Context structure.
+ * @return Clock in Hz, 0 for backends with no clock to set, or CRYPT_FAILED.
+ */
+int crypt_get_bus_clock(crypt_context_t *context);
+
+/**
+ * @brief Calibrate SPI clock: clocks are swept from slowest to fastest, each checked against known-answer SHA-256
+ *        vectors, and the fastest reliable one is kept (one step down from the fastest passing, if a faster one
+ *        fails).
+ * @param context Context structure.
+ * @param profile Profile file (one per host and FPGA) or NULL. If it holds a clock for the backend and bus width of
+ *        @p context that still passes the check, the sweep is skipped. Otherwise, the calibrated clock is saved to it.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note Called by crypt_initialise() if environment variable CRYPT_SPI_PROFILE is set. The sweep resynchronises the
+ *       FPGA after a failing clock, and errors printed along the way are expected.
+ */
+int crypt_calibrate(crypt_context_t *context, const char *profile);
+
+/**
+ * @brief Set secret key. The AES-256 key schedule is expanded here and kept until crypt_terminate().
+ * @param context Context structure.
+ * @param secretKey String containing secret key.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_set_key(crypt_context_t *context, char *secretKey);
+
+/**
+ * @brief Decipher a buffer using AES-256 with CBC.
+ * @param context Context structure.
+ * @param encBuffer Ciphered buffer.
+ * @param outBuffer Output buffer.
+ * @param buffLen Buffer sizes (both @p encBuffer and @p outBuffer). Must be a multiple of 16.
+ * @param iniVector Initialisation vector for CBC. Must be 16 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note Blocks are deciphered in parallel by the native AES kernel (see aes256.h).
+ */
+int crypt_aes_dec(crypt_context_t *context, char *encBuffer, char *outBuffer, unsigned int buffLen, char *iniVector);
+
+/**
+ * @brief Cipher a buffer using AES-256 with CBC.
+ * @param context Context structure.
+ * @param inBuffer Input buffer.
+ * @param encBuffer Ciphered buffer.
+ * @param buffLen Buffer sizes (both @p encBuffer and @p outBuffer). Must be a multiple of 16.
+ * @param iniVector Initialisation vector for CBC. Must be 16 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note Uses AES instructions when available, libgcrypt otherwise. For many small buffers, crypt_sign_batch()
+ *       interleaves them and is faster.
+ */
+int crypt_aes_enc(crypt_context_t *context, char *inBuffer, char *encBuffer, unsigned int buffLen, char *iniVector);
+
+/**
+ * @brief Digest a buffer using SHA-256.
+ * @param context Context structure.
+ * @param inBuffer Input buffer.
+ * @param inBufferLen @p inBuffer size.
+ * @param digest Digest buffer. Must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_digest(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest);
+
+/**
+ * @brief Start a multi-block digest using SHA-256.
+ * @param context Context structure.
+ * @param state Digest state.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note FPGA backends keep the intermediate hash value in the FPGA, so only one multi-block digest may be in progress
+ *       per context and no other digest function may be called before crypt_digest_final().
+ */
+int crypt_digest_init(crypt_context_t *context, crypt_digest_state_t *state);
+
+/**
+ * @brief Add data to a multi-block digest. Whole blocks are compressed (or sent to the FPGA) right away.
+ * @param context Context structure.
+ * @param state Digest state.
+ * @param inBuffer Input buffer.
+ * @param inBufferLen @p inBuffer size.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_digest_update(crypt_context_t *context, crypt_digest_state_t *state, char *inBuffer, int inBufferLen);
+
+/**
+ * @brief Pad and finish a multi-block digest.
+ * @param context Context structure.
+ * @param state Digest state.
+ * @param digest Digest buffer. Must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_digest_final(crypt_context_t *context, crypt_digest_state_t *state, char *digest);
+
+/**
+ * @brief Get the intermediate hash value (midstate) of a multi-block digest. The digest may go on afterwards.
+ * @param context Context structure.
+ * @param state Digest state. Message size so far must be a multiple of 64 bytes.
+ * @param midstate Midstate buffer (H0 to H7, big endian). Must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_digest_midstate(crypt_context_t *context, crypt_digest_state_t *state, char *midstate);
+
+/**
+ * @brief Start a multi-block digest from a midstate, as if the message it was taken from had been added.
+ * @param context Context structure.
+ * @param state Digest state.
+ * @param midstate Midstate (see crypt_digest_midstate()). Must be 32 bytes.
+ * @param length Message size hashed into @p midstate, in bytes. Must be a multiple of 64.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note FPGA backends load @p midstate into the core along with the next block. Same restrictions as
+ *       crypt_digest_init() apply.
+ */
+int crypt_digest_resume(crypt_context_t *context, crypt_digest_state_t *state, char *midstate, uint64_t length);
+
+/**
+ * @brief Digest a buffer preceded by a prefix using SHA-256.
+ * @param context Context structure.
+ * @param prefix Prefix buffer.
+ * @param prefixLen @p prefix size.
+ * @param inBuffer Input buffer, hashed after @p prefix.
+ * @param inBufferLen @p inBuffer size.
+ * @param digest Digest buffer. Must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note Midstate after the whole blocks of @p prefix is kept in the context (up to CRYPT_MIDSTATE_CACHE prefixes),
+ *       so later calls with the same prefix only compress (or send to the FPGA) the blocks after it.
+ */
+int crypt_digest_prefixed(crypt_context_t *context, char *prefix, int prefixLen, char *inBuffer, int inBufferLen, char *digest);
+
+/**
+ * @brief Digest several independent buffers using SHA-256.
+ * @param context Context structure.
+ * @param inBuffers Input buffers.
+ * @param inBufferLens Sizes of each of @p inBuffers.
+ * @param n Number of buffers.
+ * @param digests Digest buffers. Each must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note Software backend hashes up to 16 buffers in parallel using SIMD, so this is much faster than calling
+ *       crypt_digest() @p n times. FPGAs with a BATCH FIFO take up to 120 32-byte buffers in a single SPI transfer,
+ *       with their digests streamed back in the same transfer.
+ */
+int crypt_digest_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests);
+
+/**
+ * @brief Digest and sign several independent buffers. Each signature is the 32-byte digest ciphered with AES-256
+ *        in CBC mode (as crypt_digest() followed by crypt_aes_enc() with the same @p iniVector for every buffer).
+ * @param context Context structure.
+ * @param readings Input buffers.
+ * @param readingLens Sizes of each of @p readings.
+ * @param n Number of buffers.
+ * @param digests Digest buffers. Each must be 32 bytes.
+ * @param signatures Signature buffers. Each must be 32 bytes.
+ * @param iniVector Initialisation vector for CBC. Must be 16 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note FPGAs with an AES-256 core sign 32-byte buffers themselves. Otherwise, buffers are processed in chunks small
+ *       enough to stay in cache between hashing and ciphering. Within a chunk, the CBC chains of all records are
+ *       interleaved, so the AES kernel works on several blocks at once. Key must be set with crypt_set_key().
+ */
+int crypt_sign_batch(crypt_context_t *context, char **readings, int *readingLens, unsigned int n, char **digests, char **signatures, char *iniVector);
+
+/**
+ * @brief Set the HMAC-SHA256 key. Only its midstates are kept.
+ * @param context Context structure.
+ * @param key Key buffer. Keys longer than 64 bytes are hashed first.
+ * @param keyLen @p key size.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_set_hmac_key(crypt_context_t *context, char *key, int keyLen);
+
+/**
+ * @brief HMAC-SHA256 of a buffer, with the key set by crypt_set_hmac_key().
+ * @param context Context structure.
+ * @param inBuffer Input buffer.
+ * @param inBufferLen @p inBuffer size.
+ * @param mac MAC buffer. Must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_hmac(crypt_context_t *context, char *inBuffer, int inBufferLen, char *mac);
+
+/**
+ * @brief HMAC-SHA256 of several independent buffers, with the key set by crypt_set_hmac_key().
+ * @param context Context structure.
+ * @param inBuffers Input buffers.
+ * @param inBufferLens Sizes of each of @p inBuffers.
+ * @param n Number of buffers.
+ * @param macs MAC buffers. Each must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note FPGAs with HMAC support hash 32-byte buffers with both HMAC passes on chip, one request per core in
+ *       flight, so a MAC costs a single request on the bus and no host cryptography.
+ */
+int crypt_hmac_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **macs);
+
+/**
+ * @brief SHA-256d of a buffer, that is, SHA-256 of its SHA-256 digest.
+ * @param context Context structure.
+ * @param inBuffer Input buffer.
+ * @param inBufferLen @p inBuffer size.
+ * @param digest Digest buffer. Must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_digest_double(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest);
+
+/**
+ * @brief SHA-256d of several independent buffers.
+ * @param context Context structure.
+ * @param inBuffers Input buffers.
+ * @param inBufferLens Sizes of each of @p inBuffers.
+ * @param n Number of buffers.
+ * @param digests Digest buffers. Each must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note FPGAs with SHA-256d support hash 32-byte buffers twice on chip, the intermediate digest never crossing the
+ *       bus, so a result costs half the bus traffic of two chained digests.
+ */
+int crypt_digest_double_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests);
+
+/**
+ * @brief Search the nonce of a proof of work: the first one, from the nonce in the buffer on, that makes the digest
+ *        of the buffer start with some zero bits.
+ * @param context Context structure.
+ * @param inBuffer Input buffer, with the first nonce to try. The winning one is left in it.
+ * @param inBufferLen @p inBuffer size.
+ * @param nonceOffset Offset of the nonce (32 bits, big endian) in @p inBuffer.
+ * @param zeroBits Leading zero bits of the digest (0 to 255).
+ * @param digest Digest buffer. Must be 32 bytes.
+ * @param attempts Number of digests computed.
+ * @return CRYPT_OK or CRYPT_FAILED (also if none of the 2^32 nonces wins).
+ * @note FPGAs with SEARCH try the nonces on all their cores, and only send the result back, so that the search runs
+ *       at the speed of the cores rather than of the bus. That takes the nonce to be in the last block of the buffer.
+ *       The software backend hashes the blocks before the nonce once, unless it has multi-buffer kernels.
+ */
+int crypt_digest_search(crypt_context_t *context, char *inBuffer, int inBufferLen, int nonceOffset, int zeroBits, char *digest, uint64_t *attempts);
+
+/**
+ * @brief Terminate a context.
+ * @param context Context structure.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_terminate(crypt_context_t *context);
+
+#endif
@@ -0,0 +1,487 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (Backend Interface)                                           * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef CRYPT_BACKEND_H
+#define CRYPT_BACKEND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "crypt.h"
+
+/**
+ * @brief Digest backend descriptor.
+ */
+typedef struct crypt_backend_s {
+	/* One of CRYPT_BACKEND_* */
+	int id;
+	/* Name, as used by CRYPT_BACKEND environment variable */
+	const char *name;
+	/* True if this backend may be picked by automatic selection */
+	bool autoSelect;
+
+	/**
+	 * @brief Open backend. Called by crypt_initialise().
+	 * @param context Context structure.
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*open)(crypt_context_t *context);
+
+	/**
+	 * @brief Digest a buffer using SHA-256.
+	 * @param context Context structure.
+	 * @param inBuffer Input buffer.
+	 * @param inBufferLen @p inBuffer size.
+	 * @param digest Digest buffer. Must be 32 bytes.
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*digest)(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest);
+
+	/**
+	 * @brief Digest several independent buffers using SHA-256. NULL if backend has no batch support.
+	 * @param context Context structure.
+	 * @param inBuffers Input buffers.
+	 * @param inBufferLens Sizes of each of @p inBuffers.
+	 * @param n Number of buffers.
+	 * @param digests Digest buffers. Each must be 32 bytes.
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*digestBatch)(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests);
+
+	/**
+	 * @brief Compress whole blocks of a multi-block digest. NULL if backend hashes those in software.
+	 * @param context Context structure.
+	 * @param state Digest state. If state->first is set, the first block of @p blocks starts the message. If state->load
+ *        is set, it is chained to state->h instead.
+	 * @param blocks Input blocks (64 bytes each).
+	 * @param nBlocks Number of blocks.
+	 * @param digest Digest buffer (32 bytes) if @p blocks are the last (padded) ones, NULL otherwise.
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*digestBlocks)(crypt_context_t *context, crypt_digest_state_t *state, const uint8_t *blocks, unsigned int nBlocks, char *digest);
+
+	/**
+	 * @brief HMAC-SHA256 of several independent buffers, with the key set by crypt_set_hmac_key(). NULL if backend
+	 *        computes those through the digest functions (see crypt_hmac_chained()).
+	 * @param context Context structure.
+	 * @param inBuffers Input buffers.
+	 * @param inBufferLens Sizes of each of @p inBuffers.
+	 * @param n Number of buffers.
+	 * @param macs MAC buffers. Each must be 32 bytes.
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*hmacBatch)(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **macs);
+
+	/**
+	 * @brief SHA-256d (SHA-256 of the SHA-256) of several independent buffers. NULL if backend computes those through
+	 *        the digest functions (see crypt_digest_double_chained()).
+	 * @param context Context structure.
+	 * @param inBuffers Input buffers.
+	 * @param inBufferLens Sizes of each of @p inBuffers.
+	 * @param n Number of buffers.
+	 * @param digests Digest buffers. Each must be 32 bytes.
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*doubleBatch)(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests);
+
+	/**
+	 * @brief Search the nonce of a proof of work (see crypt_digest_search()). NULL if backend digests candidate
+	 *        nonces through the digest functions (see crypt_digest_search_chained()).
+	 * @param context Context structure.
+	 * @param inBuffer Input buffer, with the first nonce to try. The winning one is left in it.
+	 * @param inBufferLen @p inBuffer size.
+	 * @param nonceOffset Offset of the nonce (32 bits, big endian) in @p inBuffer.
+	 * @param zeroBits Leading zero bits of the digest.
+	 * @param digest Digest buffer. Must be 32 bytes.
+	 * @param attempts Number of digests computed.
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*search)(crypt_context_t *context, char *inBuffer, int inBufferLen, int nonceOffset, int zeroBits, char *digest, uint64_t *attempts);
+
+	/**
+	 * @brief Digest and sign several independent buffers (see crypt_sign_batch()). NULL if backend ciphers the
+	 *        digests on the host (see crypt_sign_batch_chained()).
+	 * @param context Context structure.
+	 * @param readings Input buffers.
+	 * @param readingLens Sizes of each of @p readings.
+	 * @param n Number of buffers.
+	 * @param digests Digest buffers. Each must be 32 bytes.
+	 * @param signatures Signature buffers. Each must be 32 bytes.
+	 * @param iniVector Initialisation vector (16 bytes).
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*signBatch)(crypt_context_t *context, char **readings, int *readingLens, unsigned int n, char **digests, char **signatures, char *iniVector);
+
+	/**
+	 * @brief Full-duplex SPI transfer with the FPGA. NULL for backends with no FPGA.
+	 * @param context Context structure.
+	 * @param writeData Data to be sent.
+	 * @param readData Data received.
+	 * @param len Transfer size (both @p writeData and @p readData).
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*transfer)(crypt_context_t *context, uint8_t *writeData, uint8_t *readData, unsigned int len);
+
+	/**
+	 * @brief Wait for the completion interrupt of the FPGA (see Manager.v). NULL for backends with no interrupt line.
+	 * @param context Context structure.
+	 * @return CRYPT_OK once the line is high, on timeout or if no line is configured, CRYPT_FAILED on errors.
+	 */
+	int (*waitIrq)(crypt_context_t *context);
+
+	/**
+	 * @brief Set the SPI clock. NULL for backends with no clock to set.
+	 * @param context Context structure.
+	 * @param hz Clock, in Hz. Backends with coarser settings pick the fastest one not above it, kept in
+	 *        context->busHz.
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*setClock)(crypt_context_t *context, uint32_t hz);
+
+	/**
+	 * @brief Close backend. Called by crypt_terminate().
+	 * @param context Context structure.
+	 * @return CRYPT_OK or CRYPT_FAILED.
+	 */
+	int (*close)(crypt_context_t *context);
+} crypt_backend_t;
+
+/* Commands of the FPGA protocol (see Manager.v) */
+#define CRYPT_FPGA_CMD_NOP 0x00
+#define CRYPT_FPGA_CMD_SHORT 0x01
+#define CRYPT_FPGA_CMD_INIT 0x02
+#define CRYPT_FPGA_CMD_NEXT 0x03
+#define CRYPT_FPGA_CMD_DIGEST 0x04
+#define CRYPT_FPGA_CMD_TSHORT 0x05
+#define CRYPT_FPGA_CMD_INFO 0x06
+#define CRYPT_FPGA_CMD_LOAD 0x07
+#define CRYPT_FPGA_CMD_HKEY 0x08
+#define CRYPT_FPGA_CMD_THMAC 0x09
+#define CRYPT_FPGA_CMD_BATCH 0x0A
+#define CRYPT_FPGA_CMD_READ 0x0B
+#define CRYPT_FPGA_CMD_CRC 0x0C
+#define CRYPT_FPGA_CMD_TDOUBLE 0x0D
+#define CRYPT_FPGA_CMD_SEARCH 0x0E
+#define CRYPT_FPGA_CMD_RESULT 0x0F
+#define CRYPT_FPGA_CMD_AKEY 0x10
+#define CRYPT_FPGA_CMD_SIGN 0x11
+#define CRYPT_FPGA_CMD_STATS 0x12
+/* Arms bit realignment: a run of SYNC bytes followed by NOPs makes the first NOP start a byte, whatever whole SCLK */
+/* cycles a stray edge added (not half a cycle with DDR). Older bitstreams ignore it */
+#define CRYPT_FPGA_CMD_SYNC 0xFF
+/* Bytes between the last byte of a SHORT, DIGEST or INFO command and the first byte of its response */
+#define CRYPT_FPGA_DELAY 5
+/* Bytes between READ and its response (status byte and digest) */
+#define CRYPT_FPGA_READ_DELAY 1
+/* NOPs before READ at first, so that READ is picked as late as a DELAY response would be */
+#define CRYPT_FPGA_READ_GAP (CRYPT_FPGA_DELAY - CRYPT_FPGA_READ_DELAY - 1)
+/* Command sizes, command byte included */
+#define CRYPT_FPGA_SHORT_LEN (1 + 32)
+#define CRYPT_FPGA_TSHORT_LEN (1 + 1 + 32)
+#define CRYPT_FPGA_BLOCK_LEN (1 + 64)
+#define CRYPT_FPGA_DIGEST_LEN 1
+#define CRYPT_FPGA_INFO_LEN 1
+#define CRYPT_FPGA_LOAD_LEN (1 + 32)
+#define CRYPT_FPGA_HKEY_LEN (1 + 64)
+#define CRYPT_FPGA_THMAC_LEN (1 + 1 + 32)
+#define CRYPT_FPGA_TDOUBLE_LEN (1 + 1 + 32)
+/* BATCH header (command, first tag, count), followed by count times 32 bytes */
+#define CRYPT_FPGA_BATCH_LEN (1 + 1 + 1)
+/* Set in the first tag of BATCH for entries digested twice, as TDOUBLE */
+#define CRYPT_FPGA_BATCH_DOUBLE 0x80
+#define CRYPT_FPGA_READ_LEN 1
+/* SEARCH (command, nonce offset, zero bits, limit and block) and RESULT */
+#define CRYPT_FPGA_SEARCH_LEN (1 + 1 + 1 + 4 + 64)
+#define CRYPT_FPGA_RESULT_LEN 1
+/* Set in the nonce offset of SEARCH to chain the block to the hash value of core 0 (see LOAD), rather than to H0 */
+#define CRYPT_FPGA_SEARCH_CHAIN 0x80
+#define CRYPT_FPGA_SEARCH_OFFSET 0x3F
+/* AKEY (command, AES-256 key and IV). SIGN has the same header as BATCH */
+#define CRYPT_FPGA_AKEY_LEN (1 + 32 + 16)
+#define CRYPT_FPGA_STATS_LEN 1
+/* CRC command (command, mode, CRC), whatever the mode. It clears the status error flag and count too */
+#define CRYPT_FPGA_CRC_CMD_LEN (1 + 1 + 2)
+#define CRYPT_FPGA_CRC_MODE_ON 0x01
+/* CRC-16 of CRC mode (CCITT polynomial, initial value, big endian), after commands with payload, BATCH entries and */
+/* responses */
+#define CRYPT_FPGA_CRC_LEN 2
+#define CRYPT_FPGA_CRC_POLY 0x1021
+#define CRYPT_FPGA_CRC_INIT 0xFFFF
+/* Feature bits of INFO byte 1 (byte 2 is the size of the BATCH FIFO) */
+#define CRYPT_FPGA_FEATURE_HMAC 0x01
+#define CRYPT_FPGA_FEATURE_BATCH 0x02
+#define CRYPT_FPGA_FEATURE_STATUS 0x04
+#define CRYPT_FPGA_FEATURE_CRC 0x08
+#define CRYPT_FPGA_FEATURE_DOUBLE 0x10
+#define CRYPT_FPGA_FEATURE_SEARCH 0x20
+#define CRYPT_FPGA_FEATURE_SIGN 0x40
+#define CRYPT_FPGA_FEATURE_STATS 0x80
+/* Status byte, sent whenever MISO carries no response (and first in READ responses) */
+#define CRYPT_FPGA_STATUS_FLAG 0x40
+#define CRYPT_FPGA_STATUS_DONE 0x01
+#define CRYPT_FPGA_STATUS_PENDING 0x02
+#define CRYPT_FPGA_STATUS_IDLE 0x04
+/* Set by a command that failed its CRC, and SHORT, INIT, NEXT, LOAD, HKEY, SEARCH and AKEY commands taken modulo 4, */
+/* both until CRC */
+#define CRYPT_FPGA_STATUS_ERROR 0x08
+#define CRYPT_FPGA_STATUS_COUNT 0x30
+#define CRYPT_FPGA_STATUS_COUNT_SHIFT 4
+/* Tagged response: header (CRYPT_FPGA_RESP_FLAG | tag) and digest */
+#define CRYPT_FPGA_RESP_LEN (1 + 32)
+/* Tagged response to SIGN: header, digest and signature */
+#define CRYPT_FPGA_SIGN_RESP_LEN (1 + 32 + 32)
+/* RESULT response: status byte, digest, nonce and attempts (big endian) */
+#define CRYPT_FPGA_RESULT_RESP_LEN (1 + 32 + 4 + 4)
+/* STATS response: status byte, cycles, busy and idle core cycles (48 bits each), commands taken and dropped (32 bits */
+/* each) and longest hash (16 bits), big endian */
+#define CRYPT_FPGA_STATS_RESP_LEN (1 + 6 + 6 + 6 + 4 + 4 + 2)
+#define CRYPT_FPGA_RESP_FLAG 0x80
+#define CRYPT_FPGA_TAGS 128
+/* Bytes to be clocked after a SHORT or DIGEST command until its digest is out. Digest is in the last 32 */
+#define CRYPT_FPGA_TAIL_LEN (CRYPT_FPGA_DELAY + 32)
+
+/* Available backends. Hardware ones are only compiled when the respective CRYPT_WITH_* is defined */
+extern const crypt_backend_t crypt_backend_software;
+#ifdef CRYPT_WITH_BCM2835
+extern const crypt_backend_t crypt_backend_bcm2835;
+#endif
+#ifdef CRYPT_WITH_MRAA
+extern const crypt_backend_t crypt_backend_mraa;
+#endif
+extern const crypt_backend_t crypt_backend_spidev;
+extern const crypt_backend_t crypt_backend_sim;
+#ifdef CRYPT_WITH_VERILATOR
+extern const crypt_backend_t crypt_backend_verilator;
+#endif
+
+/**
+ * @brief SPI transfer through the backend transfer function, accounted in the context bus statistics.
+ * @param context Context structure.
+ * @param writeData Data to be sent.
+ * @param readData Data received.
+ * @param len Transfer size (both @p writeData and @p readData).
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_fpga_transfer(crypt_context_t *context, uint8_t *writeData, uint8_t *readData, unsigned int len);
+
+/**
+ * @brief CRC-16 of the FPGA protocol, as sent after frames in CRC mode.
+ * @param crc CRC so far (CRYPT_FPGA_CRC_INIT to start).
+ * @param data Data.
+ * @param len @p data size.
+ * @return CRC after @p data. Zero over a frame followed by its (big endian) CRC.
+ */
+uint16_t crypt_fpga_crc(uint16_t crc, const uint8_t *data, unsigned int len);
+
+/**
+ * @brief Get number of SHA-256 cores of the FPGA attached to the backend transfer function.
+ * @param context Context structure.
+ * @return Number of cores (queried once and kept in the context) or CRYPT_FAILED.
+ * @note CRC mode is set along with the query, if the FPGA has it (see crypt_initialise_backend()).
+ */
+int crypt_fpga_cores(crypt_context_t *context);
+
+/**
+ * @brief Get the performance counters of the FPGA attached to the backend transfer function.
+ * @param context Context structure.
+ * @param stats Statistics structure to be filled. Left at zero if the FPGA has no STATS.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_fpga_device_stats(crypt_context_t *context, crypt_device_stats_t *stats);
+
+/**
+ * @brief Check the FPGA attached to the backend transfer function against known-answer vectors, at the current clock.
+ * @param context Context structure.
+ * @return CRYPT_OK if all digests match (with no CRC error along the way), CRYPT_FAILED otherwise.
+ */
+int crypt_fpga_check(crypt_context_t *context);
+
+/**
+ * @brief Bring the FPGA attached to the backend transfer function back to a byte and command boundary, after a stray
+ *        SCLK edge or a failing clock: SYNC bytes end any command half-received (a full BATCH at most) and realign
+ *        bytes, a search they started is ended by LOAD, and the responses they started are drained. Device
+ *        information is queried again.
+ * @param context Context structure.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ * @note Called by crypt_initialise_backend(), so that the FPGA need not be reset before a run.
+ * @note Only slips of whole SCLK cycles are undone. With a DDR bus, bytes start on rising edges, so that the FPGA
+ *       must be reset after a slip of half a cycle. With 4 lanes and DDR, a cycle is a whole byte and bytes stay
+ *       framed: only the SYNC bytes are needed.
+ */
+int crypt_fpga_resync(crypt_context_t *context);
+
+/**
+ * @brief Sweep the SPI clocks of the backend, from slowest to fastest, and set the fastest one that passes
+ *        crypt_fpga_check() repeatedly. When a faster clock fails, the one below the fastest passing is kept, as margin.
+ * @param context Context structure.
+ * @return CRYPT_OK or CRYPT_FAILED (even the slowest clock fails).
+ */
+int crypt_fpga_calibrate(crypt_context_t *context);
+
+/**
+ * @brief HMAC-SHA256 of a buffer through the digest functions of the backend, resuming the key midstates.
+ * @param context Context structure.
+ * @param inBuffer Input buffer.
+ * @param inBufferLen @p inBuffer size.
+ * @param mac MAC buffer. Must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_hmac_chained(crypt_context_t *context, char *inBuffer, int inBufferLen, char *mac);
+
+/**
+ * @brief SHA-256d of a buffer through the digest functions of the backend, the digest being digested again.
+ * @param context Context structure.
+ * @param inBuffer Input buffer.
+ * @param inBufferLen @p inBuffer size.
+ * @param digest Digest buffer. Must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_digest_double_chained(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest);
+
+/**
+ * @brief Search the nonce of a proof of work through the digest functions of the backend, digesting candidate
+ *        nonces in batches.
+ * @param context Context structure.
+ * @param inBuffer Input buffer, with the first nonce to try. The winning one is left in it.
+ * @param inBufferLen @p inBuffer size.
+ * @param nonceOffset Offset of the nonce (32 bits, big endian) in @p inBuffer.
+ * @param zeroBits Leading zero bits of the digest.
+ * @param digest Digest buffer. Must be 32 bytes.
+ * @param attempts Number of digests computed.
+ * @return CRYPT_OK or CRYPT_FAILED (no nonce found).
+ */
+int crypt_digest_search_chained(crypt_context_t *context, char *inBuffer, int inBufferLen, int nonceOffset, int zeroBits, char *digest, uint64_t *attempts);
+
+/**
+ * @brief Digest and sign several independent buffers through the digest functions of the backend, the digests
+ *        being ciphered on the host.
+ * @param context Context structure.
+ * @param readings Input buffers.
+ * @param readingLens Sizes of each of @p readings.
+ * @param n Number of buffers.
+ * @param digests Digest buffers. Each must be 32 bytes.
+ * @param signatures Signature buffers. Each must be 32 bytes.
+ * @param iniVector Initialisation vector (16 bytes).
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_sign_batch_chained(crypt_context_t *context, char **readings, int *readingLens, unsigned int n, char **digests, char **signatures, char *iniVector);
+
+/**
+ * @brief Count the leading zero bits of a digest.
+ * @param digest Digest (32 bytes).
+ * @return Number of leading zero bits (256 for an all-zero digest).
+ */
+int crypt_zero_bits(const char *digest);
+
+/**
+ * @brief Digest a buffer using the FPGA attached to the backend transfer function.
+ * @param context Context structure.
+ * @param inBuffer Input buffer. Buffers that are not 32 bytes long are sent as multi-block messages.
+ * @param inBufferLen @p inBuffer size.
+ * @param digest Digest buffer. Must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_fpga_digest(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest);
+
+/**
+ * @brief Digest several independent buffers using the FPGA attached to the backend transfer function.
+ * @param context Context structure.
+ * @param inBuffers Input buffers. Runs of 32-byte buffers are pipelined: data of a buffer is sent while the digest
+ *        of the previous one is received. With several cores, up to one request per core is kept in flight.
+ * @param inBufferLens Sizes of each of @p inBuffers.
+ * @param n Number of buffers.
+ * @param digests Digest buffers. Each must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_fpga_digest_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests);
+
+/**
+ * @brief Compress whole blocks of a multi-block digest using the FPGA attached to the backend transfer function.
+ * @param context Context structure.
+ * @param state Digest state.
+ * @param blocks Input blocks (64 bytes each).
+ * @param nBlocks Number of blocks.
+ * @param digest Digest buffer (32 bytes) if @p blocks are the last (padded) ones, NULL otherwise.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_fpga_digest_blocks(crypt_context_t *context, crypt_digest_state_t *state, const uint8_t *blocks, unsigned int nBlocks, char *digest);
+
+/**
+ * @brief HMAC-SHA256 of several independent buffers using the FPGA attached to the backend transfer function.
+ * @param context Context structure.
+ * @param inBuffers Input buffers. 32-byte buffers are sent as THMAC requests, the key midstates being loaded once
+ *        per key. Other sizes, and FPGAs with no HMAC support, go through crypt_hmac_chained().
+ * @param inBufferLens Sizes of each of @p inBuffers.
+ * @param n Number of buffers.
+ * @param macs MAC buffers. Each must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_fpga_hmac_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **macs);
+
+/**
+ * @brief SHA-256d of several independent buffers using the FPGA attached to the backend transfer function.
+ * @param context Context structure.
+ * @param inBuffers Input buffers. 32-byte buffers are sent as TDOUBLE requests (or BATCH frames), only the final
+ *        digest coming back. Other sizes, and FPGAs with no SHA-256d support, go through crypt_digest_double_chained().
+ * @param inBufferLens Sizes of each of @p inBuffers.
+ * @param n Number of buffers.
+ * @param digests Digest buffers. Each must be 32 bytes.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_fpga_double_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests);
+
+/**
+ * @brief Search the nonce of a proof of work using the FPGA attached to the backend transfer function.
+ * @param context Context structure.
+ * @param inBuffer Input buffer, with the first nonce to try. The winning one is left in it. When the nonce is in
+ *        the last block (along with the padding), SEARCH commands try the nonces on all cores of the FPGA, the blocks
+ *        before being hashed once. Other layouts, and FPGAs with no SEARCH, go through crypt_digest_search_chained().
+ * @param inBufferLen @p inBuffer size.
+ * @param nonceOffset Offset of the nonce (32 bits, big endian) in @p inBuffer.
+ * @param zeroBits Leading zero bits of the digest.
+ * @param digest Digest buffer. Must be 32 bytes.
+ * @param attempts Number of digests computed.
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_fpga_search(crypt_context_t *context, char *inBuffer, int inBufferLen, int nonceOffset, int zeroBits, char *digest, uint64_t *attempts);
+
+/**
+ * @brief Digest and sign several independent buffers using the FPGA attached to the backend transfer function.
+ * @param context Context structure.
+ * @param readings Input buffers. 32-byte buffers are sent in SIGN frames, the key and IV being loaded once (until
+ *        either changes): digest and signature come back together. Other sizes, and FPGAs with no SIGN, go through
+ *        crypt_sign_batch_chained().
+ * @param readingLens Sizes of each of @p readings.
+ * @param n Number of buffers.
+ * @param digests Digest buffers. Each must be 32 bytes.
+ * @param signatures Signature buffers. Each must be 32 bytes.
+ * @param iniVector Initialisation vector (16 bytes).
+ * @return CRYPT_OK or CRYPT_FAILED.
+ */
+int crypt_fpga_sign_batch(crypt_context_t *context, char **readings, int *readingLens, unsigned int n, char **digests, char **signatures, char *iniVector);
+
+#endif
@@ -0,0 +1,148 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (SHA-256 Kernels)                                             * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief SHA-256 compression function. Updates @p state with @p nBlocks consecutive 64-byte blocks.
+ * @param state Hash state (8 words, host endianness).
+ * @param blocks Input blocks.
+ * @param nBlocks Number of blocks in @p blocks.
+ */
+typedef void (*sha256_compress_t)(uint32_t *state, const uint8_t *blocks, size_t nBlocks);
+
+/* SHA-256 initial hash value and round constants */
+extern const uint32_t sha256_h0[8];
+extern const uint32_t sha256_k[64];
+
+/* Compression function in use, set by sha256_select() */
+extern sha256_compress_t sha256_compress;
+
+/**
+ * @brief Portable compression function.
+ */
+void sha256_compress_scalar(uint32_t *state, const uint8_t *blocks, size_t nBlocks);
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief Compression function using x86 SHA extensions. Requires SHA, SSSE3 and SSE4.1.
+ */
+void sha256_compress_shani(uint32_t *state, const uint8_t *blocks, size_t nBlocks);
+#endif
+
+#if defined(__aarch64__)
+/**
+ * @brief Compression function using ARMv8 Cryptography Extensions.
+ */
+void sha256_compress_armv8(uint32_t *state, const uint8_t *blocks, size_t nBlocks);
+#endif
+
+/**
+ * @brief Multi-buffer compression function. Compresses one block for each of its lanes.
+ * @param state Hash states, SoA and vector aligned (see sha256_mb_template.h).
+ * @param blocks Blocks, SoA and vector aligned (see sha256_mb_template.h).
+ */
+typedef void (*sha256_mb_compress_t)(uint32_t *state, const uint32_t *blocks);
+
+/* Largest lane count among multi-buffer kernels */
+#define SHA256_MB_MAX_LANES 16
+
+#if defined(__x86_64__) || defined(__i386__)
+void sha256_mb_compress_sse2(uint32_t *state, const uint32_t *blocks);
+void sha256_mb_compress_avx2(uint32_t *state, const uint32_t *blocks);
+void sha256_mb_compress_avx512(uint32_t *state, const uint32_t *blocks);
+#endif
+
+#if defined(__aarch64__) || defined(__arm__)
+void sha256_mb_compress_neon(uint32_t *state, const uint32_t *blocks);
+#endif
+
+/**
+ * @brief Select the fastest compression function supported by this CPU.
+ * @note Environment variable CRYPT_SHA256 may be set to "scalar" to force the portable kernel. Multi-buffer kernels
+ *       are only used along with the portable kernel, unless CRYPT_SHA256_MB names the one to use ("avx512", "avx2",
+ *       "sse2" or "neon", if the CPU has it; anything else for none).
+ */
+void sha256_select(void);
+
+/**
+ * @brief Get name of compression function in use.
+ * @return Kernel name.
+ */
+const char *sha256_kernel_name(void);
+
+/**
+ * @brief Get the lane count of the widest multi-buffer kernel in use.
+ * @return Lanes, or 0 if sha256_digest_batch() hashes buffers one by one.
+ */
+size_t sha256_mb_lanes(void);
+
+/* Largest message that fits in a single block along with its padding */
+#define SHA256_SHORT_MAX 55
+
+/**
+ * @brief Digest a buffer using SHA-256.
+ * @param inBuffer Input buffer.
+ * @param inBufferLen @p inBuffer size.
+ * @param digest Digest buffer. Must be 32 bytes.
+ * @note Buffers up to SHA256_SHORT_MAX bytes go to sha256_digest_short(), the others to sha256_digest_generic().
+ */
+void sha256_digest(const uint8_t *inBuffer, size_t inBufferLen, uint8_t *digest);
+
+/**
+ * @brief Digest a buffer of any size using SHA-256.
+ * @param inBuffer Input buffer.
+ * @param inBufferLen @p inBuffer size.
+ * @param digest Digest buffer. Must be 32 bytes.
+ */
+void sha256_digest_generic(const uint8_t *inBuffer, size_t inBufferLen, uint8_t *digest);
+
+/**
+ * @brief Digest a buffer that fits in a single block using SHA-256. With the portable kernel, buffers of up to
+ *        32 bytes use a compression function specialised at compile time (constant padding words and schedule).
+ *        With SHA-256 instructions, the only saving is the padding of a single block, and hashing is about as
+ *        fast as with sha256_digest_generic().
+ * @param inBuffer Input buffer.
+ * @param inBufferLen @p inBuffer size. Must not exceed SHA256_SHORT_MAX.
+ * @param digest Digest buffer. Must be 32 bytes.
+ */
+void sha256_digest_short(const uint8_t *inBuffer, size_t inBufferLen, uint8_t *digest);
+
+/**
+ * @brief Digest several independent buffers using SHA-256, hashing them in parallel with the multi-buffer kernels.
+ * @param inBuffers Input buffers.
+ * @param inBufferLens Sizes of each of @p inBuffers.
+ * @param n Number of buffers.
+ * @param digests Digest buffers. Each must be 32 bytes.
+ */
+void sha256_digest_batch(const uint8_t **inBuffers, const size_t *inBufferLens, size_t n, uint8_t **digests);
+
+#endif
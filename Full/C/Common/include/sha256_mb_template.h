@@ -0,0 +1,97 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (SHA-256 Multi-buffer Kernel Template)                        * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+/* This file is included by the sha256_mb_*.c files, one per instruction set. Before including it, define: */
+/* - SHA256_MB_LANES: number of messages hashed in parallel (vector width in 32-bit words); */
+/* - SHA256_MB_NAME: name of the generated function. */
+/* GCC vector extensions are lowered to whatever vector unit the including file enabled. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sha256.h"
+
+typedef uint32_t sha256_mb_vec_t __attribute__((vector_size(4 * SHA256_MB_LANES)));
+
+#define MB_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define MB_S0(x) (MB_ROTR(x, 2) ^ MB_ROTR(x, 13) ^ MB_ROTR(x, 22))
+#define MB_S1(x) (MB_ROTR(x, 6) ^ MB_ROTR(x, 11) ^ MB_ROTR(x, 25))
+#define MB_s0(x) (MB_ROTR(x, 7) ^ MB_ROTR(x, 18) ^ ((x) >> 3))
+#define MB_s1(x) (MB_ROTR(x, 17) ^ MB_ROTR(x, 19) ^ ((x) >> 10))
+#define MB_CH(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MB_MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+
+#define MB_ROUND(a, b, c, d, e, f, g, h, i) {\
+	sha256_mb_vec_t t1 = h + MB_S1(e) + MB_CH(e, f, g) + sha256_k[i] + w[(i) & 15];\
+	d += t1;\
+	h = t1 + MB_S0(a) + MB_MAJ(a, b, c);\
+}
+
+#define MB_SCHEDULE(i) (w[(i) & 15] += MB_s1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] + MB_s0(w[((i) - 15) & 15]))
+
+/**
+ * @brief Multi-buffer compression function.
+ * @param state Hash states, SoA: word i of lane l is at state[(i * SHA256_MB_LANES) + l]. Must be vector aligned.
+ * @param blocks One block per lane, SoA and already in host endianness: word i of lane l is at
+ *        blocks[(i * SHA256_MB_LANES) + l]. Must be vector aligned.
+ */
+void SHA256_MB_NAME(uint32_t *state, const uint32_t *blocks) {
+	int i;
+	sha256_mb_vec_t w[16];
+	sha256_mb_vec_t *vState = (sha256_mb_vec_t *) state;
+	const sha256_mb_vec_t *vBlocks = (const sha256_mb_vec_t *) blocks;
+	sha256_mb_vec_t a = vState[0], b = vState[1], c = vState[2], d = vState[3];
+	sha256_mb_vec_t e = vState[4], f = vState[5], g = vState[6], h = vState[7];
+
+	for(i = 0; i < 16; i++)
+		w[i] = vBlocks[i];
+
+	for(i = 0; i < 64; i += 8) {
+		if(i >= 16) {
+			MB_SCHEDULE(i + 0); MB_SCHEDULE(i + 1); MB_SCHEDULE(i + 2); MB_SCHEDULE(i + 3);
+			MB_SCHEDULE(i + 4); MB_SCHEDULE(i + 5); MB_SCHEDULE(i + 6); MB_SCHEDULE(i + 7);
+		}
+
+		MB_ROUND(a, b, c, d, e, f, g, h, i + 0);
+		MB_ROUND(h, a, b, c, d, e, f, g, i + 1);
+		MB_ROUND(g, h, a, b, c, d, e, f, i + 2);
+		MB_ROUND(f, g, h, a, b, c, d, e, i + 3);
+		MB_ROUND(e, f, g, h, a, b, c, d, i + 4);
+		MB_ROUND(d, e, f, g, h, a, b, c, i + 5);
+		MB_ROUND(c, d, e, f, g, h, a, b, i + 6);
+		MB_ROUND(b, c, d, e, f, g, h, a, i + 7);
+	}
+
+	vState[0] += a;
+	vState[1] += b;
+	vState[2] += c;
+	vState[3] += d;
+	vState[4] += e;
+	vState[5] += f;
+	vState[6] += g;
+	vState[7] += h;
+}
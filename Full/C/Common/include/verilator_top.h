@@ -0,0 +1,84 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (Verilator Model of TOP.v)                                    * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef VERILATOR_TOP_H
+#define VERILATOR_TOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the Verilator model of TOP.v and reset it through PB[1].
+ * @param sclkHz Simulated SPI clock, in Hz. SYS_CLK is simulated at 50 MHz.
+ * @param lanes SPI data lines on each direction (1, 2 or 4), must match LANES of TOP.v.
+ * @param ddr Transfer on both SCLK edges, must match DDR of TOP.v.
+ * @return Model handle or NULL.
+ */
+void *verilator_top_open(uint32_t sclkHz, unsigned int lanes, bool ddr);
+
+/**
+ * @brief Change the simulated SPI clock.
+ * @param top Model handle.
+ * @param sclkHz SPI clock, in Hz.
+ * @return False if @p sclkHz is zero.
+ */
+bool verilator_top_set_sclk(void *top, uint32_t sclkHz);
+
+/**
+ * @brief Full-duplex SPI transfer (mode 0, MSB first) with the model, through I2C_SCL, I2C_SDA and GPIO_A (and
+ *        GPIO_01 to GPIO_06 on wide buses, see SPISlaveStream.v).
+ * @param top Model handle.
+ * @param writeData Data to be sent.
+ * @param readData Data received.
+ * @param len Transfer size (both @p writeData and @p readData).
+ * @return SYS_CLK cycles elapsed during the transfer.
+ */
+uint64_t verilator_top_transfer(void *top, const uint8_t *writeData, uint8_t *readData, unsigned int len);
+
+/**
+ * @brief Advance simulated time until the completion interrupt (GPIO_07) is high.
+ * @param top Model handle.
+ * @param maxCycles Give up after this many SYS_CLK cycles.
+ * @return SYS_CLK cycles elapsed.
+ */
+uint64_t verilator_top_wait_irq(void *top, uint64_t maxCycles);
+
+/**
+ * @brief Destroy the model.
+ * @param top Model handle.
+ */
+void verilator_top_close(void *top);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,323 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (AES-256 Kernels)                                             * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/aes256.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#if defined(__aarch64__) || defined(__arm__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+/* Portable bitsliced kernel. Its S-box circuit is also used for the key schedule */
+#define AES256_BS_ENC aes256_enc_blocks_bs
+#define AES256_BS_DEC aes256_dec_blocks_bs
+
+#include "../include/aes256_bs_template.h"
+
+/* Blocks ciphered per kernel call by the CBC functions */
+#define AES256_CHUNK 16
+
+aes256_blocks_t aes256_enc_blocks = NULL;
+aes256_blocks_t aes256_dec_blocks = NULL;
+size_t aes256_min_blocks = 8;
+static const char *kernelName = "gcrypt";
+
+/**
+ * @brief Select the fastest block functions supported by this CPU.
+ */
+void aes256_select(void) {
+	char *forced = getenv("CRYPT_AES");
+	bool bitsliced = forced && !strcmp(forced, "bitsliced");
+
+	aes256_enc_blocks = NULL;
+	aes256_dec_blocks = NULL;
+	aes256_min_blocks = 8;
+	kernelName = "gcrypt";
+
+	if(forced && !strcmp(forced, "gcrypt"))
+		return;
+
+	/* Without vector byte shuffles the bitsliced kernel is slower than libgcrypt tables, so it is only used if asked */
+	if(bitsliced) {
+		aes256_enc_blocks = aes256_enc_blocks_bs;
+		aes256_dec_blocks = aes256_dec_blocks_bs;
+		kernelName = "bitsliced";
+	}
+
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("ssse3")) {
+		aes256_enc_blocks = aes256_enc_blocks_ssse3;
+		aes256_dec_blocks = aes256_dec_blocks_ssse3;
+		kernelName = "bitsliced-ssse3";
+	}
+
+	{
+		unsigned int eax, ebx, ecx, edx;
+
+		/* AES-NI is ecx bit 25 */
+		if(!bitsliced && __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 25))) {
+			aes256_enc_blocks = aes256_enc_blocks_aesni;
+			aes256_dec_blocks = aes256_dec_blocks_aesni;
+			aes256_min_blocks = 1;
+			kernelName = "aesni";
+		}
+	}
+#endif
+
+#if defined(__aarch64__)
+	aes256_enc_blocks = aes256_enc_blocks_neon;
+	aes256_dec_blocks = aes256_dec_blocks_neon;
+	kernelName = "bitsliced-neon";
+
+	if(!bitsliced && (getauxval(AT_HWCAP) & HWCAP_AES)) {
+		aes256_enc_blocks = aes256_enc_blocks_armv8;
+		aes256_dec_blocks = aes256_dec_blocks_armv8;
+		aes256_min_blocks = 1;
+		kernelName = "armv8";
+	}
+#endif
+
+#if defined(__arm__)
+	if(getauxval(AT_HWCAP) & HWCAP_NEON) {
+		aes256_enc_blocks = aes256_enc_blocks_neon;
+		aes256_dec_blocks = aes256_dec_blocks_neon;
+		kernelName = "bitsliced-neon";
+	}
+#endif
+}
+
+/**
+ * @brief Get name of block functions in use.
+ */
+const char *aes256_kernel_name(void) {
+	return kernelName;
+}
+
+/**
+ * @brief Multiply by x in GF(2^8), without branches.
+ */
+static inline uint8_t xtime(uint8_t x) {
+	return (x << 1) ^ (0x1b & -(x >> 7));
+}
+
+/**
+ * @brief Apply the S-box to each byte of a word.
+ */
+static void sub_word(uint8_t *word) {
+	int i, b;
+	aes256_bs_t q[8];
+
+	/* Bytes of the word in the first positions of the planes, as block 0 */
+	for(b = 0; b < 8; b++) {
+		q[b] = (aes256_bs_t) {0};
+		for(i = 0; i < 4; i++)
+			q[b][i] = (word[i] >> b) & 1;
+	}
+
+	bs_sbox(q);
+
+	for(i = 0; i < 4; i++) {
+		word[i] = 0;
+		for(b = 0; b < 8; b++)
+			word[i] |= (q[b][i] & 1) << b;
+	}
+}
+
+/**
+ * @brief InvMixColumns on a round key.
+ */
+static void inv_mix_columns(uint8_t *out, const uint8_t *in) {
+	int c, r;
+
+	for(c = 0; c < 4; c++) {
+		const uint8_t *a = &in[4 * c];
+
+		for(r = 0; r < 4; r++) {
+			uint8_t a0 = a[r], a1 = a[(r + 1) & 3], a2 = a[(r + 2) & 3], a3 = a[(r + 3) & 3];
+			uint8_t x2, x4, x8;
+
+			/* 14 * a0 ^ 11 * a1 ^ 13 * a2 ^ 9 * a3 */
+			x2 = xtime(a0 ^ a1);
+			x4 = xtime(xtime(a0 ^ a2));
+			x8 = xtime(xtime(xtime(a0 ^ a1 ^ a2 ^ a3)));
+			out[(4 * c) + r] = x8 ^ x4 ^ x2 ^ a1 ^ a2 ^ a3;
+		}
+	}
+}
+
+/**
+ * @brief Expand a key for all kernels.
+ */
+void aes256_expand_key(aes256_key_t *key, const uint8_t *secretKey) {
+	int i, j, b;
+	uint8_t *w = &key->enc[0][0];
+	uint8_t temp[4];
+	uint8_t rcon = 1;
+
+	/* FIPS-197 key expansion, 4 bytes at a time */
+	memcpy(w, secretKey, 32);
+	for(i = 8; i < 60; i++) {
+		memcpy(temp, &w[4 * (i - 1)], 4);
+
+		if(0 == (i & 7)) {
+			uint8_t t = temp[0];
+
+			temp[0] = temp[1];
+			temp[1] = temp[2];
+			temp[2] = temp[3];
+			temp[3] = t;
+			sub_word(temp);
+			temp[0] ^= rcon;
+			rcon = xtime(rcon);
+		}
+		else if(4 == (i & 7)) {
+			sub_word(temp);
+		}
+
+		for(j = 0; j < 4; j++)
+			w[(4 * i) + j] = w[(4 * (i - 8)) + j] ^ temp[j];
+	}
+
+	/* Equivalent inverse cipher keys, for AESDEC/AESD */
+	memcpy(key->dec[0], key->enc[14], 16);
+	for(i = 1; i < 14; i++)
+		inv_mix_columns(key->dec[i], key->enc[14 - i]);
+	memcpy(key->dec[14], key->enc[0], 16);
+
+	/* Bitsliced keys, the same round key bit for the eight blocks of a byte */
+	for(i = 0; i < 15; i++) {
+		for(b = 0; b < 8; b++) {
+			for(j = 0; j < 16; j++)
+				key->bs[i][b][j] = -((key->enc[i][j] >> b) & 1);
+		}
+	}
+}
+
+/**
+ * @brief Erase an expanded key.
+ */
+void aes256_wipe_key(aes256_key_t *key) {
+	size_t i;
+	volatile uint8_t *p = (volatile uint8_t *) key;
+
+	/* Through a volatile pointer so that it is not optimised away before free() */
+	for(i = 0; i < sizeof(aes256_key_t); i++)
+		p[i] = 0;
+}
+
+/**
+ * @brief XOR two 16-byte blocks, a word at a time.
+ */
+static inline void xor_block(uint8_t *out, const uint8_t *a, const uint8_t *b) {
+	uint64_t x[2], y[2];
+
+	memcpy(x, a, 16);
+	memcpy(y, b, 16);
+	x[0] ^= y[0];
+	x[1] ^= y[1];
+	memcpy(out, x, 16);
+}
+
+/**
+ * @brief Cipher a buffer using AES-256 with CBC.
+ */
+void aes256_cbc_enc(const aes256_key_t *key, const uint8_t *inBuffer, uint8_t *encBuffer, size_t buffLen, const uint8_t *iniVector) {
+	size_t i;
+	uint8_t chain[16];
+
+	memcpy(chain, iniVector, 16);
+
+	/* Each block depends on the previous one, so there is nothing to interleave here */
+	for(i = 0; i < buffLen; i += 16) {
+		xor_block(chain, chain, &inBuffer[i]);
+		aes256_enc_blocks(key, chain, 1);
+		memcpy(&encBuffer[i], chain, 16);
+	}
+}
+
+/**
+ * @brief Decipher a buffer using AES-256 with CBC.
+ */
+void aes256_cbc_dec(const aes256_key_t *key, const uint8_t *encBuffer, uint8_t *outBuffer, size_t buffLen, const uint8_t *iniVector) {
+	size_t i, n;
+	uint8_t prev[16], next[16];
+	uint8_t blocks[16 * AES256_CHUNK];
+
+	memcpy(prev, iniVector, 16);
+
+	for(; buffLen; buffLen -= 16 * n, encBuffer += 16 * n, outBuffer += 16 * n) {
+		n = buffLen / 16;
+		if(n > AES256_CHUNK)
+			n = AES256_CHUNK;
+
+		memcpy(blocks, encBuffer, 16 * n);
+		memcpy(next, &encBuffer[16 * (n - 1)], 16);
+		aes256_dec_blocks(key, blocks, n);
+
+		/* Backwards, so that ciphertext of block i - 1 is still there when deciphering in place */
+		for(i = n; i-- > 0;)
+			xor_block(&outBuffer[16 * i], &blocks[16 * i], i? &encBuffer[16 * (i - 1)] : prev);
+
+		memcpy(prev, next, 16);
+	}
+}
+
+/**
+ * @brief Cipher several independent buffers of the same size using AES-256 with CBC.
+ */
+void aes256_cbc_enc_batch(const aes256_key_t *key, const uint8_t **inBuffers, uint8_t **encBuffers, size_t buffLen, size_t n, const uint8_t *iniVector) {
+	size_t i, k, b, chunk;
+	uint8_t blocks[AES256_CHUNK][16];
+
+	for(i = 0; i < n; i += chunk) {
+		chunk = (n - i < AES256_CHUNK)? n - i : AES256_CHUNK;
+
+		for(k = 0; k < chunk; k++)
+			memcpy(blocks[k], iniVector, 16);
+
+		/* Step b of all chains in one call: C_b = E(P_b ^ C_(b-1)) */
+		for(b = 0; b < buffLen; b += 16) {
+			for(k = 0; k < chunk; k++)
+				xor_block(blocks[k], blocks[k], &inBuffers[i + k][b]);
+
+			aes256_enc_blocks(key, &blocks[0][0], chunk);
+
+			for(k = 0; k < chunk; k++)
+				memcpy(&encBuffers[i + k][b], blocks[k], 16);
+		}
+	}
+}
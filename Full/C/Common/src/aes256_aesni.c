@@ -0,0 +1,130 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (AES-256 AES-NI Kernel)                                       * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/aes256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#pragma GCC target("sse2,aes")
+
+#include <stdint.h>
+#include <wmmintrin.h>
+
+/* AESENC has a latency of several cycles but a throughput of one or two per cycle, so eight independent blocks */
+/* are kept in flight */
+#define LOAD8(p) {\
+	b0 = _mm_loadu_si128((const __m128i *) &(p)[0]);\
+	b1 = _mm_loadu_si128((const __m128i *) &(p)[16]);\
+	b2 = _mm_loadu_si128((const __m128i *) &(p)[32]);\
+	b3 = _mm_loadu_si128((const __m128i *) &(p)[48]);\
+	b4 = _mm_loadu_si128((const __m128i *) &(p)[64]);\
+	b5 = _mm_loadu_si128((const __m128i *) &(p)[80]);\
+	b6 = _mm_loadu_si128((const __m128i *) &(p)[96]);\
+	b7 = _mm_loadu_si128((const __m128i *) &(p)[112]);\
+}
+
+#define STORE8(p) {\
+	_mm_storeu_si128((__m128i *) &(p)[0], b0);\
+	_mm_storeu_si128((__m128i *) &(p)[16], b1);\
+	_mm_storeu_si128((__m128i *) &(p)[32], b2);\
+	_mm_storeu_si128((__m128i *) &(p)[48], b3);\
+	_mm_storeu_si128((__m128i *) &(p)[64], b4);\
+	_mm_storeu_si128((__m128i *) &(p)[80], b5);\
+	_mm_storeu_si128((__m128i *) &(p)[96], b6);\
+	_mm_storeu_si128((__m128i *) &(p)[112], b7);\
+}
+
+#define OP8(op, k) {\
+	b0 = op(b0, k);\
+	b1 = op(b1, k);\
+	b2 = op(b2, k);\
+	b3 = op(b3, k);\
+	b4 = op(b4, k);\
+	b5 = op(b5, k);\
+	b6 = op(b6, k);\
+	b7 = op(b7, k);\
+}
+
+/**
+ * @brief Cipher independent blocks in place using AES-NI.
+ */
+void aes256_enc_blocks_aesni(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks) {
+	int r;
+	__m128i rk[15];
+	__m128i b0, b1, b2, b3, b4, b5, b6, b7;
+
+	for(r = 0; r < 15; r++)
+		rk[r] = _mm_load_si128((const __m128i *) key->enc[r]);
+
+	for(; nBlocks >= 8; nBlocks -= 8, blocks += 128) {
+		LOAD8(blocks);
+		OP8(_mm_xor_si128, rk[0]);
+		for(r = 1; r < 14; r++)
+			OP8(_mm_aesenc_si128, rk[r]);
+		OP8(_mm_aesenclast_si128, rk[14]);
+		STORE8(blocks);
+	}
+
+	for(; nBlocks; nBlocks--, blocks += 16) {
+		b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) blocks), rk[0]);
+		for(r = 1; r < 14; r++)
+			b0 = _mm_aesenc_si128(b0, rk[r]);
+		b0 = _mm_aesenclast_si128(b0, rk[14]);
+		_mm_storeu_si128((__m128i *) blocks, b0);
+	}
+}
+
+/**
+ * @brief Decipher independent blocks in place using AES-NI.
+ */
+void aes256_dec_blocks_aesni(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks) {
+	int r;
+	__m128i rk[15];
+	__m128i b0, b1, b2, b3, b4, b5, b6, b7;
+
+	for(r = 0; r < 15; r++)
+		rk[r] = _mm_load_si128((const __m128i *) key->dec[r]);
+
+	for(; nBlocks >= 8; nBlocks -= 8, blocks += 128) {
+		LOAD8(blocks);
+		OP8(_mm_xor_si128, rk[0]);
+		for(r = 1; r < 14; r++)
+			OP8(_mm_aesdec_si128, rk[r]);
+		OP8(_mm_aesdeclast_si128, rk[14]);
+		STORE8(blocks);
+	}
+
+	for(; nBlocks; nBlocks--, blocks += 16) {
+		b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) blocks), rk[0]);
+		for(r = 1; r < 14; r++)
+			b0 = _mm_aesdec_si128(b0, rk[r]);
+		b0 = _mm_aesdeclast_si128(b0, rk[14]);
+		_mm_storeu_si128((__m128i *) blocks, b0);
+	}
+}
+
+#endif
@@ -0,0 +1,139 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (AES-256 ARMv8 Crypto Extensions Kernel)                      * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/aes256.h"
+
+#if defined(__aarch64__)
+
+#pragma GCC target("+crypto")
+
+#include <arm_neon.h>
+#include <stdint.h>
+
+#define LOAD8(p) {\
+	b0 = vld1q_u8(&(p)[0]);\
+	b1 = vld1q_u8(&(p)[16]);\
+	b2 = vld1q_u8(&(p)[32]);\
+	b3 = vld1q_u8(&(p)[48]);\
+	b4 = vld1q_u8(&(p)[64]);\
+	b5 = vld1q_u8(&(p)[80]);\
+	b6 = vld1q_u8(&(p)[96]);\
+	b7 = vld1q_u8(&(p)[112]);\
+}
+
+#define STORE8(p) {\
+	vst1q_u8(&(p)[0], b0);\
+	vst1q_u8(&(p)[16], b1);\
+	vst1q_u8(&(p)[32], b2);\
+	vst1q_u8(&(p)[48], b3);\
+	vst1q_u8(&(p)[64], b4);\
+	vst1q_u8(&(p)[80], b5);\
+	vst1q_u8(&(p)[96], b6);\
+	vst1q_u8(&(p)[112], b7);\
+}
+
+/* AESE/AESD add the round key first, then (Inv)ShiftRows and (Inv)SubBytes. Cores fuse them with the following */
+/* AESMC/AESIMC, so pairs are kept together and eight blocks are interleaved */
+#define ROUND8(op, mc, k) {\
+	b0 = mc(op(b0, k));\
+	b1 = mc(op(b1, k));\
+	b2 = mc(op(b2, k));\
+	b3 = mc(op(b3, k));\
+	b4 = mc(op(b4, k));\
+	b5 = mc(op(b5, k));\
+	b6 = mc(op(b6, k));\
+	b7 = mc(op(b7, k));\
+}
+
+#define LAST8(op, k, kLast) {\
+	b0 = veorq_u8(op(b0, k), kLast);\
+	b1 = veorq_u8(op(b1, k), kLast);\
+	b2 = veorq_u8(op(b2, k), kLast);\
+	b3 = veorq_u8(op(b3, k), kLast);\
+	b4 = veorq_u8(op(b4, k), kLast);\
+	b5 = veorq_u8(op(b5, k), kLast);\
+	b6 = veorq_u8(op(b6, k), kLast);\
+	b7 = veorq_u8(op(b7, k), kLast);\
+}
+
+/**
+ * @brief Cipher independent blocks in place using ARMv8 Cryptography Extensions.
+ */
+void aes256_enc_blocks_armv8(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks) {
+	int r;
+	uint8x16_t rk[15];
+	uint8x16_t b0, b1, b2, b3, b4, b5, b6, b7;
+
+	for(r = 0; r < 15; r++)
+		rk[r] = vld1q_u8(key->enc[r]);
+
+	for(; nBlocks >= 8; nBlocks -= 8, blocks += 128) {
+		LOAD8(blocks);
+		for(r = 0; r < 13; r++)
+			ROUND8(vaeseq_u8, vaesmcq_u8, rk[r]);
+		LAST8(vaeseq_u8, rk[13], rk[14]);
+		STORE8(blocks);
+	}
+
+	for(; nBlocks; nBlocks--, blocks += 16) {
+		b0 = vld1q_u8(blocks);
+		for(r = 0; r < 13; r++)
+			b0 = vaesmcq_u8(vaeseq_u8(b0, rk[r]));
+		b0 = veorq_u8(vaeseq_u8(b0, rk[13]), rk[14]);
+		vst1q_u8(blocks, b0);
+	}
+}
+
+/**
+ * @brief Decipher independent blocks in place using ARMv8 Cryptography Extensions.
+ */
+void aes256_dec_blocks_armv8(const aes256_key_t *key, uint8_t *blocks, size_t nBlocks) {
+	int r;
+	uint8x16_t rk[15];
+	uint8x16_t b0, b1, b2, b3, b4, b5, b6, b7;
+
+	for(r = 0; r < 15; r++)
+		rk[r] = vld1q_u8(key->dec[r]);
+
+	for(; nBlocks >= 8; nBlocks -= 8, blocks += 128) {
+		LOAD8(blocks);
+		for(r = 0; r < 13; r++)
+			ROUND8(vaesdq_u8, vaesimcq_u8, rk[r]);
+		LAST8(vaesdq_u8, rk[13], rk[14]);
+		STORE8(blocks);
+	}
+
+	for(; nBlocks; nBlocks--, blocks += 16) {
+		b0 = vld1q_u8(blocks);
+		for(r = 0; r < 13; r++)
+			b0 = vaesimcq_u8(vaesdq_u8(b0, rk[r]));
+		b0 = veorq_u8(vaesdq_u8(b0, rk[13]), rk[14]);
+		vst1q_u8(blocks, b0);
+	}
+}
+
+#endif
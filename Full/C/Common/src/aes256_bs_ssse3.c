@@ -1,9 +1,11 @@
 /* ********************************************************************************************* */
-/* * Common functions                                                                          * */
+/* * Simple Cryptography Library (AES-256 Bitsliced SSSE3 Kernel)                              * */
 /* * Authors:                                                                                  * */
 /* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
 /* ********************************************************************************************* */
-/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
 /* *                                                                                           * */
 /* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
 /* * software and associated documentation files (the "Software"), to deal in the Software     * */
@@ -23,35 +25,13 @@
 /* * DEALINGS IN THE SOFTWARE.                                                                 * */
 /* ********************************************************************************************* */
 
-#ifndef COMMON_H
-#define COMMON_H
+#if defined(__x86_64__) || defined(__i386__)
 
-/**
- * @brief Assert condition, print if false and jump to error handling (_err).
- * @param cond Condition to be asserted.
- * @param rv Return variable (doesn't need to be a reference).
- * @param val Value to assign to @p rv.
- * @param ... printf arguments (both format and arguments).
- */
-#define ASSERT(cond, rv, val, ...) {\
-	if(!(cond)) {\
-		rv = val;\
-		fprintf(stderr, __VA_ARGS__);\
-		goto _err;\
-	}\
-}
+#pragma GCC target("ssse3")
 
-/**
- * @brief Assert condition and jump to error handling (_err) if false.
- * @param cond Condition to be asserted.
- * @param rv Return variable (doesn't need to be a reference).
- * @param val Value to assign to @p rv.
- */
-#define ASSERT_NOPRINT(cond, rv, val) {\
-	if(!(cond)) {\
-		rv = val;\
-		goto _err;\
-	}\
-}
+#define AES256_BS_ENC aes256_enc_blocks_ssse3
+#define AES256_BS_DEC aes256_dec_blocks_ssse3
+
+#include "../include/aes256_bs_template.h"
 
 #endif
@@ -1,5 +1,5 @@
 /* ********************************************************************************************* */
-/* * Simple Cryptography Library                                                               * */
+/* * Simple Cryptography Library (bcm2835 SPI Backend)                                         * */
 /* * Authors:                                                                                  * */
 /* *     André Bannwart Perina                                                                 * */
 /* *     Luciano Falqueto                                                                      * */
@@ -25,77 +25,95 @@
 /* * DEALINGS IN THE SOFTWARE.                                                                 * */
 /* ********************************************************************************************* */
 
-#ifndef CRYPT_H
-#define CRYPT_H
+#include "../include/common.h"
+#include "../include/crypt.h"
+#include "../include/crypt_backend.h"
 
+#include <bcm2835.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* SPI clock is the core clock divided by an even divider (up to 65536, set as 0) */
+#define BCM2835_CORE_CLOCK 250000000
+#define BCM2835_DIVIDER_MAX 65536
 
 /**
- * @brief Context structure.
+ * @brief Open backend.
  */
-typedef struct {
-	/* True if library was initiliased */
-	bool initialised;
-	/* For test purposes, the key is not hidden elsewhere... */
-	char secretKey[32];
-} crypt_context_t;
+static int bcm2835_open(crypt_context_t *context) {
+	int rv = CRYPT_OK;
 
-/* Return values */
-#define CRYPT_OK 0
-#define CRYPT_FAILED -1
+	ASSERT(bcm2835_init(), rv, CRYPT_FAILED, "bcm2835_open: bcm2835_init failed.\n");
+	/* The SPI0 controller has a single data line on each direction */
+	ASSERT((1 == context->busLanes) && !(context->busDdr), rv, CRYPT_FAILED, "bcm2835_open: Only single lane SPI is supported.\n");
+	ASSERT(bcm2835_spi_begin(), rv, CRYPT_FAILED, "bcm2835_open: bcm2835_spi_begin failed.\n");
+	bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_16);
+	context->busHz = BCM2835_CORE_CLOCK / 16;
 
-/**
- * @brief Initialise a context.
- * @param context Context structure.
- * @return CRYPT_OK or CRYPT_FAILED.
- */
-int crypt_initialise(crypt_context_t *context);
+	return rv;
 
-/**
- * @brief Set secret key.
- * @param context Context structure.
- * @param secretKey String containing secret key.
- * @return CRYPT_OK or CRYPT_FAILED.
- */
-int crypt_set_key(crypt_context_t *context, char *secretKey);
+_err:
+	bcm2835_close();
 
-/**
- * @brief Decipher a buffer using AES-256 with CBC.
- * @param context Context structure.
- * @param encBuffer Ciphered buffer.
- * @param outBuffer Output buffer.
- * @param buffLen Buffer sizes (both @p encBuffer and @p outBuffer).
- * @param iniVector Initialisation vector for CBC. Must be 16 bytes.
- * @return CRYPT_OK or CRYPT_FAILED.
- */
-int crypt_aes_dec(crypt_context_t *context, char *encBuffer, char *outBuffer, unsigned int buffLen, char *iniVector);
+	return rv;
+}
 
 /**
- * @brief Cipher a buffer using AES-256 with CBC.
- * @param context Context structure.
- * @param inBuffer Input buffer.
- * @param encBuffer Ciphered buffer.
- * @param buffLen Buffer sizes (both @p encBuffer and @p outBuffer).
- * @param iniVector Initialisation vector for CBC. Must be 16 bytes.
- * @return CRYPT_OK or CRYPT_FAILED.
+ * @brief Full-duplex SPI transfer with the FPGA.
  */
-int crypt_aes_enc(crypt_context_t *context, char *inBuffer, char *encBuffer, unsigned int buffLen, char *iniVector);
+static int bcm2835_transfer(crypt_context_t *context, uint8_t *writeData, uint8_t *readData, unsigned int len) {
+	bcm2835_spi_transfernb((char *) writeData, (char *) readData, len);
+
+	return CRYPT_OK;
+}
 
 /**
- * @brief Digest a buffer using SHA-256.
- * @param context Context structure.
- * @param inBuffer Input buffer.
- * @param inBufferLen @p inBuffer size.
- * @param digest Digest buffer. Must be 32 bytes.
- * @return CRYPT_OK or CRYPT_FAILED.
+ * @brief Set the SPI clock.
  */
-int crypt_digest(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest);
+static int bcm2835_set_clock(crypt_context_t *context, uint32_t hz) {
+	int rv = CRYPT_OK;
+	uint32_t divider;
+
+	ASSERT(hz, rv, CRYPT_FAILED, "bcm2835_set_clock: Clock must not be zero.\n");
+
+	/* Smallest even divider that does not clock above hz */
+	divider = (BCM2835_CORE_CLOCK + hz - 1) / hz;
+	divider += divider & 1;
+	if(divider > BCM2835_DIVIDER_MAX)
+		divider = BCM2835_DIVIDER_MAX;
+
+	bcm2835_spi_setClockDivider((uint16_t) divider);
+	context->busHz = BCM2835_CORE_CLOCK / divider;
+
+_err:
+	return rv;
+}
 
 /**
- * @brief Terminate a context.
- * @param context Context structure.
- * @return CRYPT_OK or CRYPT_FAILED.
+ * @brief Close backend.
  */
-int crypt_terminate(crypt_context_t *context);
+static int bcm2835_close_backend(crypt_context_t *context) {
+	bcm2835_spi_end();
+	bcm2835_close();
+
+	return CRYPT_OK;
+}
 
-#endif
+const crypt_backend_t crypt_backend_bcm2835 = {
+	.id = CRYPT_BACKEND_BCM2835,
+	.name = "bcm2835",
+	.autoSelect = true,
+	.open = bcm2835_open,
+	.digest = crypt_fpga_digest,
+	.digestBatch = crypt_fpga_digest_batch,
+	.digestBlocks = crypt_fpga_digest_blocks,
+	.hmacBatch = crypt_fpga_hmac_batch,
+	.doubleBatch = crypt_fpga_double_batch,
+	.search = crypt_fpga_search,
+	.signBatch = crypt_fpga_sign_batch,
+	.transfer = bcm2835_transfer,
+	.waitIrq = NULL,
+	.setClock = bcm2835_set_clock,
+	.close = bcm2835_close_backend
+};
@@ -0,0 +1,112 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (mraa SPI Backend)                                            * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/common.h"
+#include "../include/crypt.h"
+#include "../include/crypt_backend.h"
+
+#include <mraa/spi.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Default SPI clock */
+#define MRAA_DEFAULT_SPEED 24000000
+
+/**
+ * @brief Open backend.
+ */
+static int mraa_open(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+
+	ASSERT((1 == context->busLanes) && !(context->busDdr), rv, CRYPT_FAILED, "mraa_open: Only single lane SPI is supported.\n");
+	context->spi = (void *) mraa_spi_init(0);
+	ASSERT(context->spi, rv, CRYPT_FAILED, "mraa_open: mraa_spi_init() failed.\n");
+	ASSERT(MRAA_SUCCESS == mraa_spi_frequency((mraa_spi_context) context->spi, MRAA_DEFAULT_SPEED), rv, CRYPT_FAILED, "mraa_open: mraa_spi_frequency failed.\n");
+	context->busHz = MRAA_DEFAULT_SPEED;
+
+_err:
+	if(CRYPT_OK != rv && context->spi) {
+		mraa_spi_stop((mraa_spi_context) context->spi);
+		context->spi = NULL;
+	}
+
+	return rv;
+}
+
+/**
+ * @brief Full-duplex SPI transfer with the FPGA.
+ */
+static int mraa_transfer(crypt_context_t *context, uint8_t *writeData, uint8_t *readData, unsigned int len) {
+	int rv = CRYPT_OK;
+
+	ASSERT(MRAA_SUCCESS == mraa_spi_transfer_buf((mraa_spi_context) context->spi, writeData, readData, len), rv, CRYPT_FAILED, "mraa_transfer: mraa_spi_transfer_buf failed.\n");
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Set the SPI clock.
+ */
+static int mraa_set_clock(crypt_context_t *context, uint32_t hz) {
+	int rv = CRYPT_OK;
+
+	ASSERT(MRAA_SUCCESS == mraa_spi_frequency((mraa_spi_context) context->spi, hz), rv, CRYPT_FAILED, "mraa_set_clock: mraa_spi_frequency failed.\n");
+	context->busHz = hz;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Close backend.
+ */
+static int mraa_close(crypt_context_t *context) {
+	mraa_spi_stop((mraa_spi_context) context->spi);
+	context->spi = NULL;
+
+	return CRYPT_OK;
+}
+
+const crypt_backend_t crypt_backend_mraa = {
+	.id = CRYPT_BACKEND_MRAA,
+	.name = "mraa",
+	.autoSelect = true,
+	.open = mraa_open,
+	.digest = crypt_fpga_digest,
+	.digestBatch = crypt_fpga_digest_batch,
+	.digestBlocks = crypt_fpga_digest_blocks,
+	.hmacBatch = crypt_fpga_hmac_batch,
+	.doubleBatch = crypt_fpga_double_batch,
+	.search = crypt_fpga_search,
+	.signBatch = crypt_fpga_sign_batch,
+	.transfer = mraa_transfer,
+	.waitIrq = NULL,
+	.setClock = mraa_set_clock,
+	.close = mraa_close
+};
@@ -0,0 +1,726 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (Simulated FPGA Backend)                                      * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/common.h"
+#include "../include/crypt.h"
+#include "../include/crypt_backend.h"
+#include "../include/sha256.h"
+
+#include <gcrypt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Default and maximum number of simulated SHA-256 cores */
+#define SIM_CORES 4
+#define SIM_CORES_MAX 16
+/* Bytes a core takes to hash a block (66 FPGA cycles at 50 MHz, SPI at 20 MHz) */
+#define SIM_CORE_BYTES 4
+/* Entries of the BATCH FIFO */
+#define SIM_FIFO 64
+/* Seed of the bit errors set by CRYPT_SIM_ERRORS, so that runs are repeatable */
+#define SIM_ERROR_SEED 1
+
+/**
+ * @brief Simulated SHA-256 core.
+ */
+typedef struct {
+	/* Intermediate hash value */
+	uint32_t h[8];
+	/* Bytes until block is hashed, and bytes it has taken so far */
+	unsigned int wait;
+	unsigned int run;
+	/* TSHORT, THMAC or TDOUBLE request in the core, not sent back yet */
+	bool busy;
+	/* Digest is done and waiting for MISO */
+	bool pending;
+	/* Tag of TSHORT request, and whether its response carries a signature (SIGN) */
+	uint8_t tag;
+	bool sign;
+	/* SEARCH nonce in the core (left from a search that is over if stale), and the nonce */
+	bool search;
+	bool stale;
+	uint32_t nonce;
+} sim_core_t;
+
+/**
+ * @brief Simulated device state (see Manager.v).
+ */
+typedef struct {
+	/* Command being received */
+	uint8_t cmd;
+	/* Index of next byte within current command (0 is the command byte) */
+	unsigned int count;
+	/* Block register */
+	uint8_t block[64];
+	/* Tag of TSHORT, THMAC or TDOUBLE command being received */
+	uint8_t tag;
+	/* SHA-256 cores. Core 0 is used by SHORT, INIT, NEXT, DIGEST and LOAD */
+	sim_core_t cores[SIM_CORES_MAX];
+	unsigned int nCores;
+	/* Next core for TSHORT, THMAC and TDOUBLE commands */
+	unsigned int rrCore;
+	/* HMAC key midstates, set by HKEY */
+	uint32_t ipad[8];
+	uint32_t opad[8];
+	/* AES-256 key and IV, set by AKEY */
+	gcry_cipher_hd_t cipher;
+	uint8_t iv[16];
+	/* BATCH (or SIGN) entries left to be received, bytes of the current one, its tag and whether entries are digested */
+	/* twice and signed */
+	unsigned int batchLeft;
+	unsigned int batchByte;
+	uint8_t batchTag;
+	bool batchDouble;
+	bool batchSign;
+	/* BATCH FIFO (tag, with CRYPT_FPGA_BATCH_DOUBLE for SHA-256d, sign flag and 32 bytes each), first entry and */
+	/* number of entries */
+	uint8_t fifo[SIM_FIFO][2 + 32];
+	unsigned int fifoFirst;
+	unsigned int fifoCount;
+	/* Bytes until a digest (or INFO, or READ response) starts being sent, and bytes left to be sent */
+	unsigned int outWait;
+	bool outInfo;
+	bool outRead;
+	bool outResult;
+	bool outStats;
+	unsigned int outLeft;
+	/* Response being sent (header byte, if any, digest and CRC in CRC mode) and its size */
+	uint8_t out[CRYPT_FPGA_SIGN_RESP_LEN + CRYPT_FPGA_CRC_LEN];
+	unsigned int outLen;
+	/* CRC mode, CRC of the command (or BATCH entry) being received, commands dropped since last CRC and core 0 (or */
+	/* HKEY) commands taken since then */
+	bool crcMode;
+	uint16_t crcIn;
+	bool frameError;
+	unsigned int cmdCount;
+	/* One in errorRate bytes gets a bit flipped on each direction (0 for none), and random state */
+	unsigned int errorRate;
+	unsigned int errorSeed;
+	/* SEARCH in progress, result of the last one asked for by RESULT (until another core 0 command) and found */
+	bool searching;
+	bool searchMode;
+	bool searchFound;
+	/* SEARCH arguments (nonce offset, zero bits and limit) and block, and hash value of core 0 when it was taken */
+	uint8_t searchArgs[CRYPT_FPGA_SEARCH_LEN - 1 - 64];
+	uint8_t searchBlock[64];
+	uint32_t searchMid[8];
+	/* Nonces left to be started, next nonce, attempts, result (digest and nonce) */
+	uint64_t searchLeft;
+	uint32_t searchNonce;
+	uint32_t searchAttempts;
+	uint32_t searchResult[8 + 1];
+	/* Counters sent by STATS, with bytes for clock cycles */
+	crypt_device_stats_t stats;
+} sim_t;
+
+/**
+ * @brief Open backend.
+ */
+static int sim_open(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+	char *cores = getenv("CRYPT_SIM_CORES");
+	char *errors = getenv("CRYPT_SIM_ERRORS");
+	gcry_error_t gcryError;
+	sim_t *sim = calloc(1, sizeof(sim_t));
+
+	ASSERT(sim, rv, CRYPT_FAILED, "sim_open: Could not allocate memory.\n");
+
+	context->spi = sim;
+
+	/* Core count may be set by CRYPT_SIM_CORES */
+	sim->nCores = cores? atoi(cores) : SIM_CORES;
+	ASSERT((sim->nCores >= 1) && (sim->nCores <= SIM_CORES_MAX), rv, CRYPT_FAILED, "sim_open: CRYPT_SIM_CORES must be between 1 and %d.\n", SIM_CORES_MAX);
+
+	/* Link errors may be injected with CRYPT_SIM_ERRORS, to exercise CRC mode */
+	sim->errorRate = errors? atoi(errors) : 0;
+	sim->errorSeed = SIM_ERROR_SEED;
+
+	/* AES-256 core, keyed by AKEY */
+	gcryError = gcry_cipher_open(&(sim->cipher), GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_CBC, 0);
+	ASSERT(!gcryError, rv, CRYPT_FAILED, "sim_open: %s: %s\n", gcry_strsource(gcryError), gcry_strerror(gcryError));
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Load a response into the MISO feeder: header byte (tag or status) if any, digest (and @p nWords - 8 more
+ *        words, big endian), and CRC in CRC mode.
+ */
+static void sim_respond(sim_t *sim, const uint32_t *h, unsigned int nWords, bool header, uint8_t first) {
+	unsigned int j;
+	uint16_t crc;
+
+	sim->outLen = 0;
+	if(header)
+		sim->out[sim->outLen++] = first;
+	for(j = 0; j < (4 * nWords); j++)
+		sim->out[sim->outLen++] = h[j / 4] >> (24 - (8 * (j % 4)));
+
+	if(sim->crcMode) {
+		crc = crypt_fpga_crc(CRYPT_FPGA_CRC_INIT, sim->out, sim->outLen);
+		sim->out[sim->outLen++] = crc >> 8;
+		sim->out[sim->outLen++] = crc;
+	}
+
+	sim->outLeft = sim->outLen;
+}
+
+/**
+ * @brief Pack the counters sent by STATS: cycles, busy and idle cycles (48 bits each), commands taken and dropped (32
+ *        bits each) and longest hash (16 bits), big endian.
+ */
+static void sim_counters(sim_t *sim, uint32_t *words) {
+	unsigned int i, j, len = 0;
+	uint8_t bytes[CRYPT_FPGA_STATS_RESP_LEN - 1];
+	const uint64_t values[] = {sim->stats.cycles, sim->stats.busyCycles, sim->stats.idleCycles, sim->stats.transactions, sim->stats.frameErrors,
+		sim->stats.maxLatency};
+	const unsigned int sizes[] = {6, 6, 6, 4, 4, 2};
+
+	for(i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); i++) {
+		for(j = 0; j < sizes[i]; j++)
+			bytes[len++] = values[i] >> (8 * (sizes[i] - j - 1));
+	}
+
+	for(i = 0; i < (sizeof(bytes) / 4); i++)
+		words[i] = (bytes[4 * i] << 24) | (bytes[(4 * i) + 1] << 16) | (bytes[(4 * i) + 2] << 8) | bytes[(4 * i) + 3];
+}
+
+/**
+ * @brief Flip a random bit of a byte, once in errorRate bytes.
+ */
+static uint8_t sim_error(sim_t *sim, uint8_t byte) {
+	if(sim->errorRate && !(rand_r(&(sim->errorSeed)) % sim->errorRate))
+		byte ^= 1 << (rand_r(&(sim->errorSeed)) % 8);
+
+	return byte;
+}
+
+/**
+ * @brief Status byte, sent on idle MISO and before the digest on READ.
+ */
+static uint8_t sim_status(sim_t *sim) {
+	unsigned int k;
+	uint8_t status = CRYPT_FPGA_STATUS_FLAG;
+	bool idle = !(sim->fifoCount) && !(sim->batchLeft) && !(sim->searching);
+
+	for(k = 0; k < sim->nCores; k++) {
+		if(sim->cores[k].pending)
+			status |= CRYPT_FPGA_STATUS_PENDING;
+		if(sim->cores[k].busy)
+			idle = false;
+	}
+
+	/* After SEARCH, core 0 is done once the search is over */
+	if(sim->searchMode? !(sim->searching) : !(sim->cores[0].wait))
+		status |= CRYPT_FPGA_STATUS_DONE;
+
+	return status | (idle? CRYPT_FPGA_STATUS_IDLE : 0) |
+		(sim->frameError? CRYPT_FPGA_STATUS_ERROR : 0) | ((sim->cmdCount << CRYPT_FPGA_STATUS_COUNT_SHIFT) & CRYPT_FPGA_STATUS_COUNT);
+}
+
+/**
+ * @brief Load big-endian words from bytes.
+ */
+static void sim_words(uint32_t *h, const uint8_t *bytes) {
+	unsigned int k;
+
+	for(k = 0; k < 8; k++)
+		h[k] = (bytes[4 * k] << 24) | (bytes[(4 * k) + 1] << 16) | (bytes[(4 * k) + 2] << 8) | bytes[(4 * k) + 3];
+}
+
+/**
+ * @brief Hash the digest of a core again as a 32-byte message, padded on chip, twice as long.
+ */
+static void sim_rehash(sim_core_t *core) {
+	unsigned int k;
+	uint8_t block[64] = {0};
+
+	for(k = 0; k < 32; k++)
+		block[k] = core->h[k / 4] >> (24 - (8 * (k % 4)));
+	block[32] = 0x80;
+	block[62] = 0x01;
+	memcpy(core->h, sha256_h0, sizeof(core->h));
+	sha256_compress(core->h, block, 1);
+	core->wait = 2 * SIM_CORE_BYTES;
+}
+
+/**
+ * @brief Start a SHORT-padded block on a free core, with a tagged response. Digest is hashed again if @p twice, and
+ *        signed if @p sign.
+ */
+static void sim_start_tagged(sim_t *sim, const uint8_t *data, uint8_t tag, bool twice, bool sign) {
+	unsigned int k;
+	uint8_t block[64];
+	sim_core_t *core;
+
+	for(k = 0; (k < sim->nCores) && sim->cores[(sim->rrCore + k) % sim->nCores].busy; k++);
+	core = &(sim->cores[(sim->rrCore + k) % sim->nCores]);
+	sim->rrCore = (sim->rrCore + k + 1) % sim->nCores;
+	core->busy = true;
+	core->tag = tag;
+	core->sign = sign;
+
+	memcpy(block, data, 32);
+	memset(&block[32], 0, 32);
+	block[32] = 0x80;
+	block[62] = 0x01;
+	memcpy(core->h, sha256_h0, sizeof(core->h));
+	sha256_compress(core->h, block, 1);
+	core->wait = SIM_CORE_BYTES;
+	if(twice)
+		sim_rehash(core);
+}
+
+/**
+ * @brief Check the SEARCH cores that are done, and start the next nonces on the free ones. Cores finish in the order
+ *        they start, lowest core first, so that the first digest that matches has the lowest nonce.
+ */
+static void sim_search(sim_t *sim) {
+	unsigned int k, j;
+	unsigned int offset = sim->searchArgs[0] & CRYPT_FPGA_SEARCH_OFFSET;
+	bool busy = false;
+	uint8_t block[64];
+	uint8_t digest[32];
+	sim_core_t *core;
+
+	for(k = 0; k < sim->nCores; k++) {
+		core = &(sim->cores[k]);
+		if(!(core->search) || core->wait)
+			continue;
+
+		core->search = false;
+		core->busy = false;
+		if(!(sim->searchFound) && !(core->stale)) {
+			sim->searchAttempts++;
+			for(j = 0; j < 32; j++)
+				digest[j] = core->h[j / 4] >> (24 - (8 * (j % 4)));
+			if(crypt_zero_bits((char *) digest) >= sim->searchArgs[1]) {
+				sim->searchFound = true;
+				memcpy(sim->searchResult, core->h, sizeof(core->h));
+				sim->searchResult[8] = core->nonce;
+			}
+		}
+	}
+
+	for(k = 0; (k < sim->nCores) && sim->searching && !(sim->searchFound) && sim->searchLeft; k++) {
+		core = &(sim->cores[k]);
+		if(core->busy)
+			continue;
+
+		memcpy(block, sim->searchBlock, sizeof(block));
+		for(j = 0; (j < 4) && (offset <= 60); j++)
+			block[offset + j] = sim->searchNonce >> (24 - (8 * j));
+		memcpy(core->h, (sim->searchArgs[0] & CRYPT_FPGA_SEARCH_CHAIN)? sim->searchMid : sha256_h0, sizeof(core->h));
+		sha256_compress(core->h, block, 1);
+		core->wait = SIM_CORE_BYTES;
+		core->busy = true;
+		core->search = true;
+		core->stale = false;
+		core->nonce = (sim->searchNonce)++;
+		sim->searchLeft--;
+	}
+
+	/* Search is over once a digest matches (or all nonces are tried) and its cores are back */
+	for(k = 0; k < sim->nCores; k++)
+		busy |= sim->cores[k].search;
+	if(sim->searching && (sim->searchFound || !(sim->searchLeft)) && !busy) {
+		sim->searching = false;
+		if(!(sim->searchFound))
+			sim->searchResult[8] = sim->searchNonce;
+	}
+}
+
+/**
+ * @brief End the search on a command to core 0. Cores still on it finish, but their digests are dropped.
+ */
+static void sim_search_stop(sim_t *sim) {
+	unsigned int k;
+
+	for(k = 0; k < sim->nCores; k++)
+		sim->cores[k].stale = sim->cores[k].search;
+	sim->searching = false;
+	sim->searchMode = false;
+}
+
+/**
+ * @brief Sign the digest of a core as the AES-256 core does: digest words, followed by the words of its AES-256-CBC
+ *        signature.
+ */
+static int sim_sign(sim_t *sim, const sim_core_t *core, uint32_t *words) {
+	int rv = CRYPT_OK;
+	unsigned int j;
+	uint8_t digest[32];
+	uint8_t signature[32];
+	gcry_error_t gcryError;
+
+	for(j = 0; j < 32; j++)
+		digest[j] = core->h[j / 4] >> (24 - (8 * (j % 4)));
+
+	gcryError = gcry_cipher_setiv(sim->cipher, sim->iv, sizeof(sim->iv));
+	ASSERT(!gcryError, rv, CRYPT_FAILED, "sim_sign: %s: %s\n", gcry_strsource(gcryError), gcry_strerror(gcryError));
+	gcryError = gcry_cipher_encrypt(sim->cipher, signature, sizeof(signature), digest, sizeof(digest));
+	ASSERT(!gcryError, rv, CRYPT_FAILED, "sim_sign: %s: %s\n", gcry_strsource(gcryError), gcry_strerror(gcryError));
+
+	memcpy(words, core->h, sizeof(core->h));
+	sim_words(&words[8], signature);
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Full-duplex SPI transfer with the simulated FPGA.
+ */
+static int sim_transfer(crypt_context_t *context, uint8_t *writeData, uint8_t *readData, unsigned int len) {
+	int rv = CRYPT_OK;
+	unsigned int i, k, cmdLast, payloadLast, offset;
+	sim_t *sim = context->spi;
+	sim_core_t *core;
+	uint32_t info[8] = {0};
+	uint32_t result[8 + 2];
+	uint32_t signedWords[8 + 8];
+	uint32_t counters[(CRYPT_FPGA_STATS_RESP_LEN - 1) / 4];
+	uint8_t cmd, byte;
+	bool tagged, ok;
+	gcry_error_t gcryError;
+
+	for(i = 0; i < len; i++) {
+		byte = sim_error(sim, writeData[i]);
+		cmd = sim->count? sim->cmd : byte;
+		tagged = (CRYPT_FPGA_CMD_TSHORT == cmd) || (CRYPT_FPGA_CMD_THMAC == cmd) || (CRYPT_FPGA_CMD_TDOUBLE == cmd);
+		payloadLast = (CRYPT_FPGA_CMD_SHORT == cmd)? (CRYPT_FPGA_SHORT_LEN - 1) : (CRYPT_FPGA_CMD_LOAD == cmd)? (CRYPT_FPGA_LOAD_LEN - 1) : tagged? (CRYPT_FPGA_TSHORT_LEN - 1) :
+			((CRYPT_FPGA_CMD_INIT == cmd) || (CRYPT_FPGA_CMD_NEXT == cmd) || (CRYPT_FPGA_CMD_HKEY == cmd))? (CRYPT_FPGA_BLOCK_LEN - 1) :
+			((CRYPT_FPGA_CMD_BATCH == cmd) || (CRYPT_FPGA_CMD_SIGN == cmd))? (CRYPT_FPGA_BATCH_LEN - 1) : (CRYPT_FPGA_CMD_CRC == cmd)? (CRYPT_FPGA_CRC_CMD_LEN - CRYPT_FPGA_CRC_LEN - 1) :
+			(CRYPT_FPGA_CMD_SEARCH == cmd)? (CRYPT_FPGA_SEARCH_LEN - 1) : (CRYPT_FPGA_CMD_AKEY == cmd)? (CRYPT_FPGA_AKEY_LEN - 1) : 0;
+		/* Commands with payload end with a CRC in CRC mode, CRC commands always do */
+		cmdLast = payloadLast + (((sim->crcMode && payloadLast) || (CRYPT_FPGA_CMD_CRC == cmd))? CRYPT_FPGA_CRC_LEN : 0);
+
+		/* MISO feeder: digest is sent after the delay stage, whatever command is being received. Status elsewhere */
+		readData[i] = sim_error(sim, sim->outLeft? sim->out[sim->outLen - (sim->outLeft)--] : sim_status(sim));
+
+		/* Cores finish some bytes after they start, busy until then */
+		sim->stats.cycles++;
+		for(k = 0; k < sim->nCores; k++) {
+			core = &(sim->cores[k]);
+			if(!(core->wait)) {
+				sim->stats.idleCycles++;
+				continue;
+			}
+
+			sim->stats.busyCycles++;
+			core->run++;
+			if(!(--(core->wait))) {
+				if(core->run > sim->stats.maxLatency)
+					sim->stats.maxLatency = core->run;
+				core->run = 0;
+				if(core->busy && !(core->search))
+					core->pending = true;
+			}
+		}
+
+		/* Digest is copied once the delay stage is over, so that the core may start the next request. Tagged */
+		/* responses are sent whenever MISO is free, lowest core first */
+		if(sim->outWait) {
+			if(!(--(sim->outWait)) && sim->outRead && sim->outResult) {
+				/* RESULT response is the status byte followed by the digest, nonce and attempts of the last SEARCH */
+				memcpy(result, sim->searchResult, sizeof(sim->searchResult));
+				result[9] = sim->searchAttempts;
+				sim_respond(sim, result, 10, true, sim_status(sim));
+			}
+			else if(!(sim->outWait) && sim->outRead && sim->outStats) {
+				/* STATS response is the status byte followed by the counters */
+				sim_counters(sim, counters);
+				sim_respond(sim, counters, (CRYPT_FPGA_STATS_RESP_LEN - 1) / 4, true, sim_status(sim));
+			}
+			else if(!(sim->outWait) && sim->outRead) {
+				/* READ response is the status byte followed by the digest, whether it is done or not */
+				sim_respond(sim, sim->cores[0].h, 8, true, sim_status(sim));
+			}
+			else if(!(sim->outWait)) {
+				info[0] = (sim->nCores << 24) | ((CRYPT_FPGA_FEATURE_HMAC | CRYPT_FPGA_FEATURE_BATCH | CRYPT_FPGA_FEATURE_STATUS | CRYPT_FPGA_FEATURE_CRC |
+					CRYPT_FPGA_FEATURE_DOUBLE | CRYPT_FPGA_FEATURE_SEARCH | CRYPT_FPGA_FEATURE_SIGN | CRYPT_FPGA_FEATURE_STATS) << 16) | (SIM_FIFO << 8);
+				sim_respond(sim, sim->outInfo? info : sim->cores[0].h, 8, false, 0);
+			}
+		}
+		else if(!(sim->outLeft)) {
+			for(k = 0; (k < sim->nCores) && !(sim->cores[k].pending); k++);
+			if(k < sim->nCores) {
+				/* Signed responses carry the signature after the digest */
+				if(sim->cores[k].sign) {
+					ASSERT(CRYPT_OK == sim_sign(sim, &(sim->cores[k]), signedWords), rv, CRYPT_FAILED, "sim_transfer: Could not sign digest.\n");
+					sim_respond(sim, signedWords, 16, true, CRYPT_FPGA_RESP_FLAG | sim->cores[k].tag);
+				}
+				else {
+					sim_respond(sim, sim->cores[k].h, 8, true, CRYPT_FPGA_RESP_FLAG | sim->cores[k].tag);
+				}
+				sim->cores[k].pending = false;
+				sim->cores[k].busy = false;
+			}
+		}
+
+		/* SEARCH nonces go to free cores */
+		sim_search(sim);
+
+		/* FIFO entries go to free cores */
+		while(sim->fifoCount) {
+			for(k = 0; (k < sim->nCores) && sim->cores[k].busy; k++);
+			if(k == sim->nCores)
+				break;
+			sim_start_tagged(sim, &(sim->fifo[sim->fifoFirst][2]), sim->fifo[sim->fifoFirst][0] & ~CRYPT_FPGA_BATCH_DOUBLE,
+				sim->fifo[sim->fifoFirst][0] & CRYPT_FPGA_BATCH_DOUBLE, sim->fifo[sim->fifoFirst][1]);
+			sim->fifoFirst = (sim->fifoFirst + 1) % SIM_FIFO;
+			sim->fifoCount--;
+		}
+
+		/* BATCH (and SIGN) data has no framing: every 32 bytes (and CRC, in CRC mode) make a FIFO entry (dropped if it is full, */
+		/* or if it fails its CRC) */
+		if(sim->batchLeft) {
+			sim->crcIn = crypt_fpga_crc(sim->batchByte? sim->crcIn : CRYPT_FPGA_CRC_INIT, &byte, 1);
+			if(sim->batchByte < 32)
+				sim->block[sim->batchByte] = byte;
+			if((sim->crcMode? (32 + CRYPT_FPGA_CRC_LEN) : 32) == ++(sim->batchByte)) {
+				if(sim->crcMode && sim->crcIn) {
+					sim->frameError = true;
+					sim->stats.frameErrors++;
+				}
+				else if(sim->fifoCount < SIM_FIFO) {
+					sim->fifo[(sim->fifoFirst + sim->fifoCount) % SIM_FIFO][0] = sim->batchTag | (sim->batchDouble? CRYPT_FPGA_BATCH_DOUBLE : 0);
+					sim->fifo[(sim->fifoFirst + sim->fifoCount) % SIM_FIFO][1] = sim->batchSign;
+					memcpy(&(sim->fifo[(sim->fifoFirst + sim->fifoCount) % SIM_FIFO][2]), sim->block, 32);
+					sim->fifoCount++;
+				}
+				if(!(sim->crcMode && sim->crcIn))
+					sim->stats.transactions++;
+				sim->batchTag = (sim->batchTag + 1) % CRYPT_FPGA_TAGS;
+				sim->batchByte = 0;
+				sim->batchLeft--;
+			}
+			continue;
+		}
+
+		if(!(sim->count))
+			sim->cmd = cmd;
+
+		/* MOSI feeder: payload goes to the block register (tag first for tagged commands), core starts once it is */
+		/* complete and its CRC is good */
+		sim->crcIn = crypt_fpga_crc(sim->count? sim->crcIn : CRYPT_FPGA_CRC_INIT, &byte, 1);
+		ok = (payloadLast == cmdLast) || !(sim->crcIn);
+		if(tagged && (1 == sim->count))
+			sim->tag = byte & ~CRYPT_FPGA_RESP_FLAG;
+		else if((CRYPT_FPGA_CMD_SEARCH == cmd) && sim->count && (sim->count <= sizeof(sim->searchArgs)))
+			sim->searchArgs[sim->count - 1] = byte;
+		else if(sim->count && (sim->count <= payloadLast))
+			sim->block[sim->count - ((CRYPT_FPGA_CMD_SEARCH == cmd)? (sizeof(sim->searchArgs) + 1) : tagged? 2 : 1)] = byte;
+
+		/* Commands of core 0 (and HKEY and AKEY) are counted until CRC */
+		if(sim->count && (sim->count == cmdLast) && ok && !tagged && (CRYPT_FPGA_CMD_BATCH != cmd) && (CRYPT_FPGA_CMD_SIGN != cmd) && (CRYPT_FPGA_CMD_CRC != cmd))
+			sim->cmdCount++;
+
+		/* All commands taken but NOP and SYNC are counted by STATS */
+		if((sim->count == cmdLast) && ok && (CRYPT_FPGA_CMD_NOP != cmd) && (CRYPT_FPGA_CMD_SYNC != cmd))
+			sim->stats.transactions++;
+
+		/* Commands that fail their CRC are dropped */
+		if(sim->count && (sim->count == cmdLast) && !ok) {
+			sim->frameError = true;
+			sim->stats.frameErrors++;
+		}
+		/* CRC sets the mode of the following commands, and clears the error flag and the count */
+		else if(sim->count && (sim->count == cmdLast) && (CRYPT_FPGA_CMD_CRC == cmd)) {
+			sim->crcMode = sim->block[0] & CRYPT_FPGA_CRC_MODE_ON;
+			sim->frameError = false;
+			sim->cmdCount = 0;
+		}
+		/* LOAD sets the hash value of core 0, chained by the following NEXT */
+		else if(sim->count && (sim->count == cmdLast) && (CRYPT_FPGA_CMD_LOAD == cmd)) {
+			sim_words(sim->cores[0].h, sim->block);
+			sim->cores[0].busy = false;
+			sim_search_stop(sim);
+		}
+		/* SEARCH starts from the nonce in the block, chained to the hash value of core 0 if asked to */
+		else if(sim->count && (sim->count == cmdLast) && (CRYPT_FPGA_CMD_SEARCH == cmd)) {
+			offset = sim->searchArgs[0] & CRYPT_FPGA_SEARCH_OFFSET;
+			sim_search_stop(sim);
+			memcpy(sim->searchBlock, sim->block, sizeof(sim->searchBlock));
+			memcpy(sim->searchMid, sim->cores[0].h, sizeof(sim->searchMid));
+			memset(sim->searchResult, 0xFF, sizeof(sim->searchResult));
+			sim->searchLeft = (sim->searchArgs[2] << 24) | (sim->searchArgs[3] << 16) | (sim->searchArgs[4] << 8) | sim->searchArgs[5];
+			if(!(sim->searchLeft))
+				sim->searchLeft = 1ULL << 32;
+			sim->searchNonce = (offset <= 60)? ((sim->block[offset] << 24) | (sim->block[offset + 1] << 16) | (sim->block[offset + 2] << 8) | sim->block[offset + 3]) : 0;
+			sim->searchAttempts = 0;
+			sim->searchFound = false;
+			sim->searching = true;
+			sim->searchMode = true;
+		}
+		/* BATCH (or SIGN) header starts the data */
+		else if(sim->count && (sim->count == cmdLast) && ((CRYPT_FPGA_CMD_BATCH == cmd) || (CRYPT_FPGA_CMD_SIGN == cmd))) {
+			sim->batchTag = sim->block[0] & ~CRYPT_FPGA_BATCH_DOUBLE;
+			sim->batchDouble = sim->block[0] & CRYPT_FPGA_BATCH_DOUBLE;
+			sim->batchSign = (CRYPT_FPGA_CMD_SIGN == cmd);
+			sim->batchLeft = sim->block[1];
+			sim->batchByte = 0;
+		}
+		/* AKEY only sets the key and IV */
+		else if(sim->count && (sim->count == cmdLast) && (CRYPT_FPGA_CMD_AKEY == cmd)) {
+			gcryError = gcry_cipher_setkey(sim->cipher, sim->block, 32);
+			ASSERT(!gcryError, rv, CRYPT_FAILED, "sim_transfer: %s: %s\n", gcry_strsource(gcryError), gcry_strerror(gcryError));
+			memcpy(sim->iv, &(sim->block[32]), sizeof(sim->iv));
+		}
+		/* HKEY only sets the midstates */
+		else if(sim->count && (sim->count == cmdLast) && (CRYPT_FPGA_CMD_HKEY == cmd)) {
+			sim_words(sim->ipad, sim->block);
+			sim_words(sim->opad, &(sim->block[32]));
+		}
+		else if(sim->count && (sim->count == cmdLast)) {
+			if((CRYPT_FPGA_CMD_SHORT == cmd) || tagged) {
+				/* Only 32 bytes are used. The rest is set to standard SHA padding (HMAC hashes follow a key block) */
+				memset(&(sim->block[32]), 0, 32);
+				sim->block[32] = 0x80;
+				sim->block[62] = (CRYPT_FPGA_CMD_THMAC == cmd)? 0x03 : 0x01;
+			}
+
+			/* Tagged commands go to the next free core, others to core 0 */
+			if(tagged) {
+				for(k = 0; (k < sim->nCores) && sim->cores[(sim->rrCore + k) % sim->nCores].busy; k++);
+				core = &(sim->cores[(sim->rrCore + k) % sim->nCores]);
+				sim->rrCore = (sim->rrCore + k + 1) % sim->nCores;
+				core->busy = true;
+				core->tag = sim->tag;
+				core->sign = false;
+			}
+			else {
+				core = &(sim->cores[0]);
+				core->busy = false;
+				sim_search_stop(sim);
+			}
+
+			if(CRYPT_FPGA_CMD_THMAC == cmd) {
+				/* Inner hash, then outer hash of the inner digest, twice as long */
+				memcpy(core->h, sim->ipad, sizeof(core->h));
+				sha256_compress(core->h, sim->block, 1);
+				for(k = 0; k < 32; k++)
+					sim->block[k] = core->h[k / 4] >> (24 - (8 * (k % 4)));
+				memcpy(core->h, sim->opad, sizeof(core->h));
+				sha256_compress(core->h, sim->block, 1);
+				core->wait = 2 * SIM_CORE_BYTES;
+			}
+			else {
+				if(CRYPT_FPGA_CMD_NEXT != cmd)
+					memcpy(core->h, sha256_h0, sizeof(core->h));
+				sha256_compress(core->h, sim->block, 1);
+				core->wait = SIM_CORE_BYTES;
+				/* TDOUBLE hashes its digest again */
+				if(CRYPT_FPGA_CMD_TDOUBLE == cmd)
+					sim_rehash(core);
+			}
+		}
+
+		/* Core finishes well within the delay stage */
+		if((sim->count == cmdLast) && ok && ((CRYPT_FPGA_CMD_SHORT == cmd) || (CRYPT_FPGA_CMD_DIGEST == cmd) || (CRYPT_FPGA_CMD_INFO == cmd))) {
+			sim->outWait = CRYPT_FPGA_DELAY;
+			sim->outInfo = (CRYPT_FPGA_CMD_INFO == cmd);
+			sim->outRead = false;
+		}
+		/* READ (or RESULT, or STATS) takes over MISO right away */
+		else if((CRYPT_FPGA_CMD_READ == cmd) || (CRYPT_FPGA_CMD_RESULT == cmd) || (CRYPT_FPGA_CMD_STATS == cmd)) {
+			sim->outWait = CRYPT_FPGA_READ_DELAY;
+			sim->outRead = true;
+			sim->outResult = (CRYPT_FPGA_CMD_RESULT == cmd);
+			sim->outStats = (CRYPT_FPGA_CMD_STATS == cmd);
+		}
+
+		sim->count = (cmdLast == sim->count)? 0 : (sim->count + 1);
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Wait for the completion interrupt: as time is counted in bytes, cores simply finish.
+ */
+static int sim_wait_irq(crypt_context_t *context) {
+	unsigned int k, skip = 0;
+	sim_t *sim = context->spi;
+
+	/* Counters move on by the bytes skipped, until the last core is done */
+	for(k = 0; k < sim->nCores; k++) {
+		if(sim->cores[k].wait > skip)
+			skip = sim->cores[k].wait;
+	}
+	sim->stats.cycles += skip;
+
+	for(k = 0; k < sim->nCores; k++) {
+		if(sim->cores[k].wait && sim->cores[k].busy && !(sim->cores[k].search))
+			sim->cores[k].pending = true;
+		if(sim->cores[k].wait && ((sim->cores[k].run + sim->cores[k].wait) > sim->stats.maxLatency))
+			sim->stats.maxLatency = sim->cores[k].run + sim->cores[k].wait;
+		sim->stats.busyCycles += sim->cores[k].wait;
+		sim->stats.idleCycles += skip - sim->cores[k].wait;
+		sim->cores[k].wait = 0;
+		sim->cores[k].run = 0;
+	}
+
+	return CRYPT_OK;
+}
+
+/**
+ * @brief Close backend.
+ */
+static int sim_close(crypt_context_t *context) {
+	sim_t *sim = context->spi;
+
+	if(sim->cipher)
+		gcry_cipher_close(sim->cipher);
+	free(context->spi);
+	context->spi = NULL;
+
+	return CRYPT_OK;
+}
+
+const crypt_backend_t crypt_backend_sim = {
+	.id = CRYPT_BACKEND_SIM,
+	.name = "sim",
+	.autoSelect = false,
+	.open = sim_open,
+	.digest = crypt_fpga_digest,
+	.digestBatch = crypt_fpga_digest_batch,
+	.digestBlocks = crypt_fpga_digest_blocks,
+	.hmacBatch = crypt_fpga_hmac_batch,
+	.doubleBatch = crypt_fpga_double_batch,
+	.search = crypt_fpga_search,
+	.signBatch = crypt_fpga_sign_batch,
+	.transfer = sim_transfer,
+	.waitIrq = sim_wait_irq,
+	.setClock = NULL,
+	.close = sim_close
+};
@@ -1,5 +1,5 @@
 /* ********************************************************************************************* */
-/* * Decipher data and display                                                                 * */
+/* * Simple Cryptography Library (Software Backend)                                            * */
 /* * Authors:                                                                                  * */
 /* *     André Bannwart Perina                                                                 * */
 /* *     Luciano Falqueto                                                                      * */
@@ -25,59 +25,76 @@
 /* * DEALINGS IN THE SOFTWARE.                                                                 * */
 /* ********************************************************************************************* */
 
+#include "../include/common.h"
+#include "../include/crypt.h"
+#include "../include/crypt_backend.h"
+#include "../include/sha256.h"
+
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
-#include "../include/crypt.h"
+/* Buffers handed to the multi-buffer kernels at once */
+#define SOFTWARE_BATCH 64
 
-#define MSG_LEN 32
-#define ITERS 128
+/**
+ * @brief Open backend.
+ */
+static int software_open(crypt_context_t *context) {
+	/* There's nothing to open */
+	return CRYPT_OK;
+}
 
-int main(void) {
-	int i, j;
-	FILE *ipf;
-	crypt_context_t context;
-	char readings[MSG_LEN + 1];
-	char hashBuff[41];
-	char encBuff[40];
-	char decBuff[MSG_LEN + 1];
+/**
+ * @brief Digest a buffer using SHA-256.
+ */
+static int software_digest(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest) {
+	sha256_digest((uint8_t *) inBuffer, inBufferLen, (uint8_t *) digest);
 
-	ipf = fopen("data.out", "r");
-	crypt_initialise(&context);
-	/* For test purposes, the key is left wide open here */
-	crypt_set_key(&context, "abcdefghijklmnopqrstuvwxyz012345");
+	return CRYPT_OK;
+}
 
-	for(i = 0; i < MSG_LEN; i++)
-		readings[i] = 0;
+/**
+ * @brief Digest several independent buffers using SHA-256.
+ */
+static int software_digest_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests) {
+	unsigned int i, j;
+	size_t lens[SOFTWARE_BATCH];
 
-	for(i = 0; i < 1024; i++) {
-		/* Read data from file (and convert it to raw when applicable) */
-		fscanf(ipf, "%s\n", (char *) &readings);
-		for(j = 0; j < 32; j++)
-			fscanf(ipf, "%02x", (unsigned int *) &hashBuff[j]);
-		for(j = 0; j < 32; j++)
-			fscanf(ipf, "%02x", (unsigned int *) &encBuff[j]);
+	for(i = 0; i < n; i += SOFTWARE_BATCH) {
+		unsigned int chunk = ((n - i) < SOFTWARE_BATCH)? (n - i) : SOFTWARE_BATCH;
 
-		/* Decipher signature */
-		crypt_aes_dec(&context, encBuff, decBuff, 32, "0123456789abcdef");
+		for(j = 0; j < chunk; j++)
+			lens[j] = inBufferLens[i + j];
 
-		/* Print findings */
-		printf("Signature: ");
-		for(j = 0; j < 32; j++)
-			printf("%02x", encBuff[j] & 0xff);
-		printf("\n");
-		printf("Decoded hash: ");
-		for(j = 0; j < 32; j++)
-			printf("%02x", decBuff[j] & 0xff);
-		printf("\n");
-		printf("Original hash: ");
-		for(j = 0; j < 32; j++)
-			printf("%02x", hashBuff[j] & 0xff);
-		printf("\n");
-		printf("Data: %s\n\n", readings);
+		sha256_digest_batch((const uint8_t **) &inBuffers[i], lens, chunk, (uint8_t **) &digests[i]);
 	}
 
-	crypt_terminate(&context);
-	fclose(ipf);
+	return CRYPT_OK;
+}
 
-	return 0;
+/**
+ * @brief Close backend.
+ */
+static int software_close(crypt_context_t *context) {
+	/* There's nothing to close */
+	return CRYPT_OK;
 }
+
+const crypt_backend_t crypt_backend_software = {
+	.id = CRYPT_BACKEND_SOFTWARE,
+	.name = "software",
+	.autoSelect = true,
+	.open = software_open,
+	.digest = software_digest,
+	.digestBatch = software_digest_batch,
+	.digestBlocks = NULL,
+	.hmacBatch = NULL,
+	.doubleBatch = NULL,
+	.search = NULL,
+	.signBatch = NULL,
+	.transfer = NULL,
+	.waitIrq = NULL,
+	.setClock = NULL,
+	.close = software_close
+};
@@ -0,0 +1,264 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (Linux spidev Backend)                                        * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/common.h"
+#include "../include/crypt.h"
+#include "../include/crypt_backend.h"
+
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <linux/spi/spidev.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+/* Default device, may be overriden through environment variable CRYPT_SPIDEV */
+#define SPIDEV_DEFAULT_DEVICE "/dev/spidev0.0"
+/* Default clock (same as BCM2835_SPI_CLOCK_DIVIDER_16 on a 250 MHz core clock) */
+#define SPIDEV_DEFAULT_SPEED 15625000
+/* Longest wait for the completion interrupt, in milliseconds. The host polls the FPGA after it anyway */
+#define SPIDEV_IRQ_TIMEOUT 10
+
+/**
+ * @brief spidev private data.
+ */
+typedef struct {
+	int fd;
+	uint32_t speed;
+	/* Data lines on each direction */
+	uint8_t nbits;
+	/* Completion interrupt line (GPIO character device line request) and its epoll instance, -1 if unused */
+	int irqFd;
+	int epollFd;
+} spidev_t;
+
+/**
+ * @brief Request the completion interrupt line, set as "chip:offset" (e.g. "/dev/gpiochip0:25").
+ */
+static int spidev_open_irq(spidev_t *spidev, const char *irq) {
+	int rv = CRYPT_OK;
+	int chipFd = -1;
+	char chip[64];
+	char *offset;
+	struct gpio_v2_line_request req;
+	struct epoll_event ev;
+
+	snprintf(chip, sizeof(chip), "%s", irq);
+	offset = strrchr(chip, ':');
+	ASSERT(offset, rv, CRYPT_FAILED, "spidev_open_irq: CRYPT_IRQ_GPIO must be chip:offset.\n");
+	*(offset++) = '\0';
+
+	chipFd = open(chip, O_RDONLY);
+	ASSERT(chipFd >= 0, rv, CRYPT_FAILED, "spidev_open_irq: Could not open %s.\n", chip);
+
+	/* Rising edges are queued, so that an interrupt raised while the host is not waiting is not lost */
+	memset(&req, 0, sizeof(req));
+	req.offsets[0] = strtoul(offset, NULL, 10);
+	req.num_lines = 1;
+	req.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING;
+	snprintf(req.consumer, sizeof(req.consumer), "crypt");
+	ASSERT(ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &req) >= 0, rv, CRYPT_FAILED, "spidev_open_irq: GPIO_V2_GET_LINE_IOCTL failed.\n");
+	spidev->irqFd = req.fd;
+	ASSERT(fcntl(spidev->irqFd, F_SETFL, O_NONBLOCK) >= 0, rv, CRYPT_FAILED, "spidev_open_irq: Could not set line request as non-blocking.\n");
+
+	spidev->epollFd = epoll_create1(0);
+	ASSERT(spidev->epollFd >= 0, rv, CRYPT_FAILED, "spidev_open_irq: epoll_create1 failed.\n");
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ASSERT(epoll_ctl(spidev->epollFd, EPOLL_CTL_ADD, spidev->irqFd, &ev) >= 0, rv, CRYPT_FAILED, "spidev_open_irq: epoll_ctl failed.\n");
+
+_err:
+	if(chipFd >= 0)
+		close(chipFd);
+
+	return rv;
+}
+
+/**
+ * @brief Open backend.
+ */
+static int spidev_open(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+	uint8_t mode = SPI_MODE_0;
+	uint32_t mode32 = SPI_MODE_0;
+	uint8_t bits = 8;
+	char *device = getenv("CRYPT_SPIDEV");
+	char *irq = getenv("CRYPT_IRQ_GPIO");
+	spidev_t *spidev = malloc(sizeof(spidev_t));
+
+	ASSERT(spidev, rv, CRYPT_FAILED, "spidev_open: Could not allocate memory.\n");
+
+	if(!device)
+		device = SPIDEV_DEFAULT_DEVICE;
+
+	spidev->speed = SPIDEV_DEFAULT_SPEED;
+	spidev->irqFd = -1;
+	spidev->epollFd = -1;
+	/* Not finding the device is expected when probing for backends, so this one is not printed */
+	spidev->fd = open(device, O_RDWR);
+	ASSERT_NOPRINT(spidev->fd >= 0, rv, CRYPT_FAILED);
+
+	/* Wide buses need a controller capable of full-duplex dual or quad transfers. spidev has no DDR mode */
+	spidev->nbits = context->busLanes;
+	ASSERT(!(context->busDdr), rv, CRYPT_FAILED, "spidev_open: CRYPT_SPI_DDR is not supported by spidev.\n");
+	if(spidev->nbits > 1) {
+		mode32 |= (4 == spidev->nbits)? (SPI_TX_QUAD | SPI_RX_QUAD) : (SPI_TX_DUAL | SPI_RX_DUAL);
+		ASSERT(ioctl(spidev->fd, SPI_IOC_WR_MODE32, &mode32) >= 0, rv, CRYPT_FAILED, "spidev_open: SPI_IOC_WR_MODE32 failed (%d lanes).\n", spidev->nbits);
+	}
+	else {
+		ASSERT(ioctl(spidev->fd, SPI_IOC_WR_MODE, &mode) >= 0, rv, CRYPT_FAILED, "spidev_open: SPI_IOC_WR_MODE failed.\n");
+	}
+	ASSERT(ioctl(spidev->fd, SPI_IOC_WR_BITS_PER_WORD, &bits) >= 0, rv, CRYPT_FAILED, "spidev_open: SPI_IOC_WR_BITS_PER_WORD failed.\n");
+	ASSERT(ioctl(spidev->fd, SPI_IOC_WR_MAX_SPEED_HZ, &(spidev->speed)) >= 0, rv, CRYPT_FAILED, "spidev_open: SPI_IOC_WR_MAX_SPEED_HZ failed.\n");
+	context->busHz = spidev->speed;
+
+	/* Completion interrupt (GPIO_07 of TOP.v) is optional */
+	if(irq) {
+		ASSERT(CRYPT_OK == spidev_open_irq(spidev, irq), rv, CRYPT_FAILED, "spidev_open: Could not set up CRYPT_IRQ_GPIO.\n");
+	}
+
+	context->spi = spidev;
+
+	return rv;
+
+_err:
+	if(spidev) {
+		if(spidev->fd >= 0)
+			close(spidev->fd);
+		if(spidev->irqFd >= 0)
+			close(spidev->irqFd);
+		if(spidev->epollFd >= 0)
+			close(spidev->epollFd);
+		free(spidev);
+	}
+
+	return rv;
+}
+
+/**
+ * @brief Full-duplex SPI transfer with the FPGA.
+ */
+static int spidev_transfer(crypt_context_t *context, uint8_t *writeData, uint8_t *readData, unsigned int len) {
+	int rv = CRYPT_OK;
+	spidev_t *spidev = context->spi;
+	struct spi_ioc_transfer xfer;
+
+	memset(&xfer, 0, sizeof(xfer));
+	xfer.tx_buf = (unsigned long) writeData;
+	xfer.rx_buf = (unsigned long) readData;
+	xfer.len = len;
+	xfer.speed_hz = spidev->speed;
+	xfer.bits_per_word = 8;
+	xfer.tx_nbits = spidev->nbits;
+	xfer.rx_nbits = spidev->nbits;
+
+	ASSERT(ioctl(spidev->fd, SPI_IOC_MESSAGE(1), &xfer) >= 0, rv, CRYPT_FAILED, "spidev_transfer: SPI_IOC_MESSAGE failed.\n");
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Wait for the completion interrupt.
+ */
+static int spidev_wait_irq(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+	spidev_t *spidev = context->spi;
+	struct gpio_v2_line_event event;
+	struct gpio_v2_line_values values;
+	struct epoll_event ev;
+
+	if(spidev->irqFd < 0)
+		return CRYPT_OK;
+
+	/* Edges queued so far are stale. The line is level-triggered, so it is checked before waiting for an edge */
+	while(read(spidev->irqFd, &event, sizeof(event)) > 0);
+	values.mask = 1;
+	ASSERT(ioctl(spidev->irqFd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) >= 0, rv, CRYPT_FAILED, "spidev_wait_irq: GPIO_V2_LINE_GET_VALUES_IOCTL failed.\n");
+
+	if(!(values.bits & 1)) {
+		ASSERT(epoll_wait(spidev->epollFd, &ev, 1, SPIDEV_IRQ_TIMEOUT) >= 0, rv, CRYPT_FAILED, "spidev_wait_irq: epoll_wait failed.\n");
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Set the SPI clock.
+ */
+static int spidev_set_clock(crypt_context_t *context, uint32_t hz) {
+	int rv = CRYPT_OK;
+	spidev_t *spidev = context->spi;
+
+	ASSERT(ioctl(spidev->fd, SPI_IOC_WR_MAX_SPEED_HZ, &hz) >= 0, rv, CRYPT_FAILED, "spidev_set_clock: SPI_IOC_WR_MAX_SPEED_HZ failed.\n");
+	spidev->speed = hz;
+	context->busHz = hz;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Close backend.
+ */
+static int spidev_close(crypt_context_t *context) {
+	spidev_t *spidev = context->spi;
+
+	if(spidev->irqFd >= 0)
+		close(spidev->irqFd);
+	if(spidev->epollFd >= 0)
+		close(spidev->epollFd);
+	close(spidev->fd);
+	free(spidev);
+	context->spi = NULL;
+
+	return CRYPT_OK;
+}
+
+const crypt_backend_t crypt_backend_spidev = {
+	.id = CRYPT_BACKEND_SPIDEV,
+	.name = "spidev",
+	.autoSelect = true,
+	.open = spidev_open,
+	.digest = crypt_fpga_digest,
+	.digestBatch = crypt_fpga_digest_batch,
+	.digestBlocks = crypt_fpga_digest_blocks,
+	.hmacBatch = crypt_fpga_hmac_batch,
+	.doubleBatch = crypt_fpga_double_batch,
+	.search = crypt_fpga_search,
+	.signBatch = crypt_fpga_sign_batch,
+	.transfer = spidev_transfer,
+	.waitIrq = spidev_wait_irq,
+	.setClock = spidev_set_clock,
+	.close = spidev_close
+};
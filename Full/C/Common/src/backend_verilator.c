@@ -1,5 +1,5 @@
 /* ********************************************************************************************* */
-/* * Signature generator                                                                       * */
+/* * Simple Cryptography Library (Verilator Backend)                                           * */
 /* * Authors:                                                                                  * */
 /* *     André Bannwart Perina                                                                 * */
 /* *     Luciano Falqueto                                                                      * */
@@ -25,84 +25,92 @@
 /* * DEALINGS IN THE SOFTWARE.                                                                 * */
 /* ********************************************************************************************* */
 
-#include <mraa/aio.h>
+#include "../include/common.h"
+#include "../include/crypt.h"
+#include "../include/crypt_backend.h"
+#include "../include/verilator_top.h"
+
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/time.h>
 
-#include "../include/crypt.h"
+/* Default simulated SPI clock, may be overriden through environment variable CRYPT_VERILATOR_SCLK (in Hz) */
+#define VERILATOR_DEFAULT_SCLK 15625000
+/* Longest wait for the completion interrupt, in SYS_CLK cycles */
+#define VERILATOR_IRQ_TIMEOUT 100000
+
+/**
+ * @brief Open backend.
+ */
+static int verilator_open(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+	char *sclk = getenv("CRYPT_VERILATOR_SCLK");
+	uint32_t sclkHz = sclk? strtoul(sclk, NULL, 10) : VERILATOR_DEFAULT_SCLK;
+
+	context->spi = verilator_top_open(sclkHz, context->busLanes, context->busDdr);
+	ASSERT(context->spi, rv, CRYPT_FAILED, "verilator_open: Could not create model (SPI clock is %u Hz, %u lanes).\n", sclkHz, context->busLanes);
+	context->busHz = sclkHz;
 
-#define MSG_LEN 32
-#define ITERS 128
-
-int main(void) {
-	int i, j;
-	struct timeval then, now;
-	suseconds_t totalHash = 0; 
-	suseconds_t totalAes = 0; 
-	FILE *opf;
-	mraa_aio_context aio0;
-	crypt_context_t context;
-	char readings[MSG_LEN + 1];
-	char hashBuff[32];
-	char encBuff[32];
-
-	opf = fopen("data.out", "w");
-	aio0 = mraa_aio_init(0);
-	crypt_initialise(&context);
-	/* For test purposes, the key is left wide open here */
-	crypt_set_key(&context, "abcdefghijklmnopqrstuvwxyz012345");
-
-	/* Wait for FPGA to be programmed or reset to clean any trash that Galileo may have sent to the FPGA */
-	printf("Program or reset FPGA and press any key...");
-	getchar();
-
-	for(i = 0; i < MSG_LEN; i++)
-		readings[i] = 0;
-
-	for(i = 0; i < ITERS; i++) {
-		/* Acquire data from analog input 0 */
-		sprintf(&readings[0], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[4], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[8], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[12], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[16], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[20], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[24], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[28], "%04x", mraa_aio_read(aio0));
-		//sprintf(readings, "abcdefghijklmnopqrstuvwxyz012345");
-
-		/* Digest data */
-		gettimeofday(&then, NULL);
-		crypt_digest(&context, readings, MSG_LEN, hashBuff);
-		gettimeofday(&now, NULL);
-		totalHash += (now.tv_usec - then.tv_usec);
-
-		/* Cipher digest */
-		gettimeofday(&then, NULL);
-		crypt_aes_enc(&context, hashBuff, encBuff, 32, "0123456789abcdef");
-		gettimeofday(&now, NULL);
-		totalAes += (now.tv_usec - then.tv_usec);
-
-		/* Save findings to file */
-		fprintf(opf, "%s\n", readings);
-		for(j = 0; j < 32; j++)
-			fprintf(opf, "%02x", hashBuff[j] & 0xff);
-		fprintf(opf, "\n");
-		for(j = 0; j < 32; j++)
-			fprintf(opf, "%02x", encBuff[j] & 0xff);
-		fprintf(opf, "\n");
-	}
-
-	/* Print statistics */
-	printf("Done. Elapsed hash time: %ld us\n", totalHash);
-	printf("Done. Elapsed hash time per iter: %ld us\n", totalHash / ITERS);
-	printf("Done. Elapsed cipher time: %ld us\n", totalAes);
-	printf("Done. Elapsed total time: %ld us\n", totalHash + totalAes);
-
-	crypt_terminate(&context);
-	mraa_aio_close(aio0);
-	fclose(opf);
-
-	return 0;
+_err:
+	return rv;
 }
+
+/**
+ * @brief Full-duplex SPI transfer with the Verilator model of the FPGA.
+ */
+static int verilator_transfer(crypt_context_t *context, uint8_t *writeData, uint8_t *readData, unsigned int len) {
+	context->busStats.sysclkCycles += verilator_top_transfer(context->spi, writeData, readData, len);
+
+	return CRYPT_OK;
+}
+
+/**
+ * @brief Wait for the completion interrupt (GPIO_07 of the model).
+ */
+static int verilator_wait_irq(crypt_context_t *context) {
+	context->busStats.sysclkCycles += verilator_top_wait_irq(context->spi, VERILATOR_IRQ_TIMEOUT);
+
+	return CRYPT_OK;
+}
+
+/**
+ * @brief Set the simulated SPI clock.
+ */
+static int verilator_set_clock(crypt_context_t *context, uint32_t hz) {
+	int rv = CRYPT_OK;
+
+	ASSERT(verilator_top_set_sclk(context->spi, hz), rv, CRYPT_FAILED, "verilator_set_clock: Clock must not be zero.\n");
+	context->busHz = hz;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Close backend.
+ */
+static int verilator_close(crypt_context_t *context) {
+	verilator_top_close(context->spi);
+	context->spi = NULL;
+
+	return CRYPT_OK;
+}
+
+const crypt_backend_t crypt_backend_verilator = {
+	.id = CRYPT_BACKEND_VERILATOR,
+	.name = "verilator",
+	.autoSelect = false,
+	.open = verilator_open,
+	.digest = crypt_fpga_digest,
+	.digestBatch = crypt_fpga_digest_batch,
+	.digestBlocks = crypt_fpga_digest_blocks,
+	.hmacBatch = crypt_fpga_hmac_batch,
+	.doubleBatch = crypt_fpga_double_batch,
+	.search = crypt_fpga_search,
+	.signBatch = crypt_fpga_sign_batch,
+	.transfer = verilator_transfer,
+	.waitIrq = verilator_wait_irq,
+	.setClock = verilator_set_clock,
+	.close = verilator_close
+};
@@ -0,0 +1,271 @@
+/* ********************************************************************************************* */
+/* * Digest benchmark                                                                          * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../include/aes256.h"
+#include "../include/crypt.h"
+#include "../include/crypt_backend.h"
+#include "../include/sha256.h"
+
+#define MSG_LEN 32
+#define BATCH 128
+#define ITERS 100000
+#define PREFIX_LEN 192
+/* Proof-of-work stamp (nonce in its last 4 bytes), and its difficulty: two zero bytes */
+#define STAMP_LEN 80
+#define SEARCH_BITS 16
+
+/* FPGA counters as of the last bus_report() */
+static crypt_device_stats_t deviceLast;
+
+/**
+ * @brief Print SPI bus usage since last call, for FPGA backends, and how busy the FPGA cores were if it counts it.
+ */
+static void bus_report(crypt_context_t *context, const char *label) {
+	crypt_bus_stats_t stats;
+	crypt_device_stats_t device;
+	uint64_t busy, idle;
+
+	/* STATS goes after the bus statistics are taken, so that it is not counted in them */
+	crypt_get_bus_stats(context, &stats);
+	crypt_get_device_stats(context, &device);
+	crypt_reset_bus_stats(context);
+
+	if(stats.digests) {
+		printf("%s: %llu transfers, %.1f bus cycles/hash", label, (unsigned long long) stats.transfers, (double) stats.sclkCycles / stats.digests);
+		if(stats.sysclkCycles)
+			printf(", %.1f FPGA cycles/hash", (double) stats.sysclkCycles / stats.digests);
+		busy = device.busyCycles - deviceLast.busyCycles;
+		idle = device.idleCycles - deviceLast.idleCycles;
+		if(busy + idle)
+			printf(", cores hashing %.1f%% of the time", (100.0 * busy) / (busy + idle));
+		printf("\n");
+	}
+
+	deviceLast = device;
+}
+
+/**
+ * @brief Get monotonic time in nanoseconds.
+ */
+static double now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (ts.tv_sec * 1e9) + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+	int i, j;
+	uint32_t nonce;
+	uint64_t attempts;
+	int iters = (argc > 1)? atoi(argv[1]) : ITERS;
+	double then;
+	double generic, single, batch;
+	crypt_context_t context;
+	crypt_digest_state_t state;
+	char prefix[PREFIX_LEN];
+	char stamp[STAMP_LEN];
+	char readings[BATCH][MSG_LEN];
+	char hashBuff[BATCH][32];
+	char encBuff[BATCH][32];
+	char *inBuffers[BATCH];
+	char *digests[BATCH];
+	char *signatures[BATCH];
+	int inBufferLens[BATCH];
+
+	if(crypt_initialise(&context) != CRYPT_OK)
+		return 1;
+	if(crypt_set_key(&context, "abcdefghijklmnopqrstuvwxyz012345") != CRYPT_OK)
+		return 1;
+
+	srand(time(NULL));
+	for(i = 0; i < BATCH; i++) {
+		for(j = 0; j < MSG_LEN; j++)
+			readings[i][j] = rand();
+		inBuffers[i] = readings[i];
+		digests[i] = hashBuff[i];
+		signatures[i] = encBuff[i];
+		inBufferLens[i] = MSG_LEN;
+	}
+	for(i = 0; i < PREFIX_LEN; i++)
+		prefix[i] = rand();
+	for(i = 0; i < STAMP_LEN; i++)
+		stamp[i] = rand();
+
+	printf("Backend: %s; SHA-256 kernel: %s (multi-buffer: %zu lanes); AES-256 kernel: %s; message size: %d bytes\n", crypt_get_backend_name(&context), sha256_kernel_name(), sha256_mb_lanes(), aes256_kernel_name(), MSG_LEN);
+	if(crypt_get_device_cores(&context) > 0)
+		printf("FPGA SHA-256 cores: %d; SPI bus: %u lane(s)%s, %d Hz\n", crypt_get_device_cores(&context), context.busLanes, context.busDdr? ", DDR" : "", crypt_get_bus_clock(&context));
+
+	/* Generic software path (padding for any size) */
+	then = now();
+	for(i = 0; i < iters; i++)
+		sha256_digest_generic((uint8_t *) readings[i % BATCH], MSG_LEN, (uint8_t *) hashBuff[i % BATCH]);
+	generic = (now() - then) / iters;
+
+	/* Single-block software path */
+	then = now();
+	for(i = 0; i < iters; i++)
+		sha256_digest_short((uint8_t *) readings[i % BATCH], MSG_LEN, (uint8_t *) hashBuff[i % BATCH]);
+	single = (now() - then) / iters;
+
+	printf("sha256_digest_generic: %.1f ns/digest\n", generic);
+	printf("sha256_digest_short: %.1f ns/digest (%.2fx)\n", single, generic / single);
+
+	/* Whole library path, through the selected backend */
+	crypt_get_device_stats(&context, &deviceLast);
+	crypt_reset_bus_stats(&context);
+	then = now();
+	for(i = 0; i < iters; i++)
+		crypt_digest(&context, readings[i % BATCH], MSG_LEN, hashBuff[i % BATCH]);
+	single = (now() - then) / iters;
+	printf("crypt_digest: %.1f ns/digest\n", single);
+	bus_report(&context, "crypt_digest SPI bus");
+
+	then = now();
+	for(i = 0; i < iters; i += BATCH)
+		crypt_digest_batch(&context, inBuffers, inBufferLens, BATCH, digests);
+	batch = (now() - then) / (((iters + BATCH - 1) / BATCH) * BATCH);
+	printf("crypt_digest_batch: %.1f ns/digest (%.2fx)\n", batch, single / batch);
+	bus_report(&context, "crypt_digest_batch SPI bus");
+
+	/* Messages sharing a prefix, hashed whole and from the cached prefix midstate */
+	then = now();
+	for(i = 0; i < iters; i++) {
+		crypt_digest_init(&context, &state);
+		crypt_digest_update(&context, &state, prefix, PREFIX_LEN);
+		crypt_digest_update(&context, &state, readings[i % BATCH], MSG_LEN);
+		crypt_digest_final(&context, &state, hashBuff[i % BATCH]);
+	}
+	single = (now() - then) / iters;
+	printf("crypt_digest_update (%d-byte prefix): %.1f ns/digest\n", PREFIX_LEN, single);
+	bus_report(&context, "crypt_digest_update SPI bus");
+
+	then = now();
+	for(i = 0; i < iters; i++)
+		crypt_digest_prefixed(&context, prefix, PREFIX_LEN, readings[i % BATCH], MSG_LEN, hashBuff[i % BATCH]);
+	batch = (now() - then) / iters;
+	printf("crypt_digest_prefixed: %.1f ns/digest (%.2fx)\n", batch, single / batch);
+	bus_report(&context, "crypt_digest_prefixed SPI bus");
+
+	/* HMAC, with both passes on the FPGA when supported */
+	then = now();
+	crypt_set_hmac_key(&context, prefix, PREFIX_LEN);
+	printf("crypt_set_hmac_key: %.1f ns\n", now() - then);
+	crypt_reset_bus_stats(&context);
+
+	then = now();
+	for(i = 0; i < iters; i++)
+		crypt_hmac(&context, readings[i % BATCH], MSG_LEN, hashBuff[i % BATCH]);
+	single = (now() - then) / iters;
+	printf("crypt_hmac: %.1f ns/MAC\n", single);
+	bus_report(&context, "crypt_hmac SPI bus");
+
+	then = now();
+	for(i = 0; i < iters; i += BATCH)
+		crypt_hmac_batch(&context, inBuffers, inBufferLens, BATCH, digests);
+	batch = (now() - then) / (((iters + BATCH - 1) / BATCH) * BATCH);
+	printf("crypt_hmac_batch: %.1f ns/MAC (%.2fx)\n", batch, single / batch);
+	bus_report(&context, "crypt_hmac_batch SPI bus");
+
+	/* SHA-256d, with both hashes on the FPGA when supported. Chained, each result takes two requests */
+	then = now();
+	for(i = 0; i < iters; i++) {
+		crypt_digest(&context, readings[i % BATCH], MSG_LEN, hashBuff[i % BATCH]);
+		crypt_digest(&context, hashBuff[i % BATCH], 32, hashBuff[i % BATCH]);
+	}
+	single = (now() - then) / iters;
+	printf("crypt_digest twice: %.1f ns/digest\n", single);
+	bus_report(&context, "crypt_digest twice SPI bus");
+
+	then = now();
+	for(i = 0; i < iters; i += BATCH)
+		crypt_digest_double_batch(&context, inBuffers, inBufferLens, BATCH, digests);
+	batch = (now() - then) / (((iters + BATCH - 1) / BATCH) * BATCH);
+	printf("crypt_digest_double_batch: %.1f ns/digest (%.2fx)\n", batch, single / batch);
+	bus_report(&context, "crypt_digest_double_batch SPI bus");
+
+	/* Proof-of-work nonce search, one digest per nonce and by the library (on the FPGA when supported). Both start */
+	/* from nonce 0, so that they try the same nonces */
+	then = now();
+	for(attempts = 1, nonce = 0; ; attempts++, nonce++) {
+		for(j = 0; j < 4; j++)
+			stamp[STAMP_LEN - 4 + j] = nonce >> (24 - (8 * j));
+		crypt_digest(&context, stamp, STAMP_LEN, hashBuff[0]);
+		if(!hashBuff[0][0] && !hashBuff[0][1])
+			break;
+	}
+	single = (now() - then) / attempts;
+	printf("crypt_digest per nonce: %.1f ns/digest (%llu digests)\n", single, (unsigned long long) attempts);
+	bus_report(&context, "crypt_digest per nonce SPI bus");
+
+	memset(&stamp[STAMP_LEN - 4], 0, 4);
+	then = now();
+	crypt_digest_search(&context, stamp, STAMP_LEN, STAMP_LEN - 4, SEARCH_BITS, hashBuff[0], &attempts);
+	batch = (now() - then) / attempts;
+	printf("crypt_digest_search: %.1f ns/digest (%.2fx)\n", batch, single / batch);
+	bus_report(&context, "crypt_digest_search SPI bus");
+
+	/* Digest followed by cipher, per record and fused. Fused records are ciphered on the host, then by the library */
+	/* (on the FPGA when supported) */
+	then = now();
+	for(i = 0; i < iters; i++) {
+		crypt_digest(&context, readings[i % BATCH], MSG_LEN, hashBuff[i % BATCH]);
+		crypt_aes_enc(&context, hashBuff[i % BATCH], encBuff[i % BATCH], 32, "0123456789abcdef");
+	}
+	single = (now() - then) / iters;
+	printf("crypt_digest + crypt_aes_enc: %.1f ns/record\n", single);
+	bus_report(&context, "crypt_digest + crypt_aes_enc SPI bus");
+
+	then = now();
+	for(i = 0; i < iters; i += BATCH)
+		crypt_sign_batch_chained(&context, inBuffers, inBufferLens, BATCH, digests, signatures, "0123456789abcdef");
+	batch = (now() - then) / (((iters + BATCH - 1) / BATCH) * BATCH);
+	printf("crypt_sign_batch (host cipher): %.1f ns/record (%.2fx)\n", batch, single / batch);
+	bus_report(&context, "crypt_sign_batch (host cipher) SPI bus");
+
+	then = now();
+	for(i = 0; i < iters; i += BATCH)
+		crypt_sign_batch(&context, inBuffers, inBufferLens, BATCH, digests, signatures, "0123456789abcdef");
+	batch = (now() - then) / (((iters + BATCH - 1) / BATCH) * BATCH);
+	printf("crypt_sign_batch: %.1f ns/record (%.2fx)\n", batch, single / batch);
+	bus_report(&context, "crypt_sign_batch SPI bus");
+
+	if(deviceLast.cycles)
+		printf("FPGA: %llu commands taken, %llu dropped, longest hash %llu cycles\n", (unsigned long long) deviceLast.transactions,
+			(unsigned long long) deviceLast.frameErrors, (unsigned long long) deviceLast.maxLatency);
+
+	crypt_terminate(&context);
+
+	return 0;
+}
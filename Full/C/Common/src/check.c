@@ -0,0 +1,271 @@
+/* ********************************************************************************************* */
+/* * Backend conformance check                                                                 * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/crypt.h"
+#include "../include/crypt_backend.h"
+#include "../include/sha256.h"
+
+#define MAX_LEN 200
+#define BATCH 37
+/* Proof-of-work stamp (nonce in its last 4 bytes), and its difficulty */
+#define STAMP_LEN 80
+#define SEARCH_BITS 12
+/* Nonce offset across the two blocks of the stamp */
+#define STAMP_SPLIT 62
+
+/* Checks failed so far */
+static int failures = 0;
+
+/**
+ * @brief Report a check.
+ */
+static void check(const char *label, int pass) {
+	printf("%s: %s\n", pass? "PASS" : "FAIL", label);
+	if(!pass)
+		failures++;
+}
+
+/**
+ * @brief Compare every digest path of a backend with the software backend.
+ * @return Number of failed checks.
+ */
+static int check_paths(crypt_context_t *context, crypt_context_t *reference, const char *pass) {
+	int i, j;
+	int same;
+	uint64_t attempts, refAttempts;
+	char label[64];
+	char messages[BATCH][MAX_LEN];
+	char hashBuff[BATCH][32], refHashBuff[BATCH][32];
+	char encBuff[BATCH][32], refEncBuff[BATCH][32];
+	char stamp[STAMP_LEN], refStamp[STAMP_LEN];
+	char *inBuffers[BATCH];
+	char *digests[BATCH], *refDigests[BATCH];
+	char *signatures[BATCH], *refSignatures[BATCH];
+	int inBufferLens[BATCH];
+	int start = failures;
+
+	for(i = 0; i < BATCH; i++) {
+		for(j = 0; j < MAX_LEN; j++)
+			messages[i][j] = rand();
+		inBuffers[i] = messages[i];
+		digests[i] = hashBuff[i];
+		refDigests[i] = refHashBuff[i];
+		signatures[i] = encBuff[i];
+		refSignatures[i] = refEncBuff[i];
+	}
+
+	/* Single requests of every size up to a few blocks (SHORT, multi-block and padding in an extra block) */
+	for(same = 1, i = 0; i <= MAX_LEN; i++) {
+		same &= CRYPT_OK == crypt_digest(context, messages[0], i, hashBuff[0]);
+		crypt_digest(reference, messages[0], i, refHashBuff[0]);
+		same &= !memcmp(hashBuff[0], refHashBuff[0], 32);
+	}
+	snprintf(label, sizeof(label), "%s crypt_digest", pass);
+	check(label, same);
+
+	/* Batches of mixed sizes, then of 32-byte requests only (tagged path) */
+	for(i = 0; i < BATCH; i++)
+		inBufferLens[i] = (i * 7) % MAX_LEN;
+	same = CRYPT_OK == crypt_digest_batch(context, inBuffers, inBufferLens, BATCH, digests);
+	crypt_digest_batch(reference, inBuffers, inBufferLens, BATCH, refDigests);
+	same &= !memcmp(hashBuff, refHashBuff, sizeof(hashBuff));
+	snprintf(label, sizeof(label), "%s crypt_digest_batch (mixed sizes)", pass);
+	check(label, same);
+
+	for(i = 0; i < BATCH; i++)
+		inBufferLens[i] = 32;
+	same = CRYPT_OK == crypt_digest_batch(context, inBuffers, inBufferLens, BATCH, digests);
+	crypt_digest_batch(reference, inBuffers, inBufferLens, BATCH, refDigests);
+	same &= !memcmp(hashBuff, refHashBuff, sizeof(hashBuff));
+	snprintf(label, sizeof(label), "%s crypt_digest_batch", pass);
+	check(label, same);
+
+	same = CRYPT_OK == crypt_digest_double_batch(context, inBuffers, inBufferLens, BATCH, digests);
+	crypt_digest_double_batch(reference, inBuffers, inBufferLens, BATCH, refDigests);
+	same &= !memcmp(hashBuff, refHashBuff, sizeof(hashBuff));
+	snprintf(label, sizeof(label), "%s crypt_digest_double_batch", pass);
+	check(label, same);
+
+	same = CRYPT_OK == crypt_hmac_batch(context, inBuffers, inBufferLens, BATCH, digests);
+	crypt_hmac_batch(reference, inBuffers, inBufferLens, BATCH, refDigests);
+	same &= !memcmp(hashBuff, refHashBuff, sizeof(hashBuff));
+	snprintf(label, sizeof(label), "%s crypt_hmac_batch", pass);
+	check(label, same);
+
+	same = CRYPT_OK == crypt_sign_batch(context, inBuffers, inBufferLens, BATCH, digests, signatures, "0123456789abcdef");
+	crypt_sign_batch(reference, inBuffers, inBufferLens, BATCH, refDigests, refSignatures, "0123456789abcdef");
+	same &= !memcmp(hashBuff, refHashBuff, sizeof(hashBuff)) && !memcmp(encBuff, refEncBuff, sizeof(encBuff));
+	snprintf(label, sizeof(label), "%s crypt_sign_batch", pass);
+	check(label, same);
+
+	/* Nonce search must find the first winning nonce, however the cores split the nonces. The nonce is in the last */
+	/* block, then across both blocks of the stamp */
+	for(j = 0; j < 2; j++) {
+		int offset = j? STAMP_SPLIT : STAMP_LEN - 4;
+
+		for(i = 0; i < STAMP_LEN; i++)
+			stamp[i] = rand();
+		memset(&stamp[offset], 0, 4);
+		memcpy(refStamp, stamp, STAMP_LEN);
+		same = CRYPT_OK == crypt_digest_search(context, stamp, STAMP_LEN, offset, SEARCH_BITS, hashBuff[0], &attempts);
+		crypt_digest_search(reference, refStamp, STAMP_LEN, offset, SEARCH_BITS, refHashBuff[0], &refAttempts);
+		same &= !memcmp(stamp, refStamp, STAMP_LEN) && !memcmp(hashBuff[0], refHashBuff[0], 32);
+		snprintf(label, sizeof(label), "%s crypt_digest_search%s", pass, j? " across blocks" : "");
+		check(label, same);
+	}
+
+	return failures - start;
+}
+
+/**
+ * @brief Compare each multi-buffer kernel of the CPU with the single-buffer one, over messages of every size up to
+ *        MAX_LEN, so that lanes finish at different blocks. Kernels are forced through CRYPT_SHA256_MB.
+ */
+static void check_mb_kernels(void) {
+	static const char *names[] = {"avx512", "avx2", "sse2", "neon"};
+	static uint8_t buffers[MAX_LEN + 1][MAX_LEN];
+	static uint8_t digestBuffs[MAX_LEN + 1][32];
+	const uint8_t *inBuffers[MAX_LEN + 1];
+	size_t inBufferLens[MAX_LEN + 1];
+	uint8_t *digests[MAX_LEN + 1];
+	uint8_t refDigest[32];
+	char label[64];
+	char *saved = getenv("CRYPT_SHA256_MB");
+	unsigned int i, k;
+	int same;
+
+	saved = saved? strdup(saved) : NULL;
+	for(i = 0; i <= MAX_LEN; i++) {
+		for(k = 0; k < MAX_LEN; k++)
+			buffers[i][k] = rand();
+		inBuffers[i] = buffers[i];
+		inBufferLens[i] = i;
+		digests[i] = digestBuffs[i];
+	}
+
+	for(k = 0; k < sizeof(names) / sizeof(names[0]); k++) {
+		setenv("CRYPT_SHA256_MB", names[k], 1);
+		sha256_select();
+		if(!sha256_mb_lanes())
+			continue;
+
+		sha256_digest_batch(inBuffers, inBufferLens, MAX_LEN + 1, digests);
+		for(i = 0, same = 1; i <= MAX_LEN; i++) {
+			sha256_digest_generic(inBuffers[i], inBufferLens[i], refDigest);
+			same &= !memcmp(digests[i], refDigest, 32);
+		}
+		snprintf(label, sizeof(label), "sha256_digest_batch with %s kernel (%zu lanes)", names[k], sha256_mb_lanes());
+		check(label, same);
+	}
+
+	if(saved)
+		setenv("CRYPT_SHA256_MB", saved, 1);
+	else
+		unsetenv("CRYPT_SHA256_MB");
+	free(saved);
+	sha256_select();
+}
+
+int main(int argc, char *argv[]) {
+	crypt_context_t context, reference;
+	crypt_device_stats_t before, after;
+	uint8_t partial[3] = {CRYPT_FPGA_CMD_SHORT, 0x5A, 0xA5};
+	uint8_t partialRead[3];
+	uint8_t partialSearch[1] = {CRYPT_FPGA_CMD_SEARCH};
+	int fpga;
+	int badLen;
+	char *badBuffer;
+	char *badDigest;
+	char badDigestBuff[32];
+
+	if(crypt_initialise(&context) != CRYPT_OK) {
+		fprintf(stderr, "Could not initialise backend.\n");
+		return 1;
+	}
+	if(crypt_initialise_backend(&reference, CRYPT_BACKEND_SOFTWARE) != CRYPT_OK) {
+		fprintf(stderr, "Could not initialise software backend.\n");
+		return 1;
+	}
+	fpga = context.backend->transfer != NULL;
+
+	printf("Backend: %s\n", crypt_get_backend_name(&context));
+	if(fpga)
+		printf("FPGA SHA-256 cores: %d; SPI bus: %u lane(s)%s, %d Hz\n", crypt_get_device_cores(&context), context.busLanes, context.busDdr? ", DDR" : "", crypt_get_bus_clock(&context));
+
+	srand(1);
+	check_mb_kernels();
+	check("crypt_set_key", CRYPT_OK == crypt_set_key(&context, "abcdefghijklmnopqrstuvwxyz012345") && CRYPT_OK == crypt_set_key(&reference, "abcdefghijklmnopqrstuvwxyz012345"));
+	check("crypt_set_hmac_key", CRYPT_OK == crypt_set_hmac_key(&context, "key", 3) && CRYPT_OK == crypt_set_hmac_key(&reference, "key", 3));
+
+	/* Bad entries are rejected before reaching the backend */
+	badLen = -1;
+	badBuffer = "x";
+	badDigest = badDigestBuff;
+	check("crypt_digest_batch rejects negative sizes", CRYPT_FAILED == crypt_digest_batch(&context, &badBuffer, &badLen, 1, &badDigest) &&
+		CRYPT_FAILED == crypt_digest_batch(&reference, &badBuffer, &badLen, 1, &badDigest));
+	check("crypt_sign_batch rejects negative sizes", CRYPT_FAILED == crypt_sign_batch(&context, &badBuffer, &badLen, 1, &badDigest, &badDigest, "0123456789abcdef") &&
+		CRYPT_FAILED == crypt_sign_batch(&reference, &badBuffer, &badLen, 1, &badDigest, &badDigest, "0123456789abcdef") &&
+		CRYPT_FAILED == crypt_sign_batch_chained(&context, &badBuffer, &badLen, 1, &badDigest, &badDigest, "0123456789abcdef"));
+
+	if(fpga) {
+		check("crypt_fpga_check", CRYPT_OK == crypt_fpga_check(&context));
+		crypt_get_device_stats(&context, &before);
+	}
+
+	check_paths(&context, &reference, "first pass:");
+
+	if(fpga) {
+		/* Counters only grow, and cores cannot be busy and idle longer than the FPGA has been running */
+		crypt_get_device_stats(&context, &after);
+		check("STATS", (after.cycles >= before.cycles) && (after.transactions >= before.transactions) &&
+			((after.busyCycles + after.idleCycles) <= (after.cycles * crypt_get_device_cores(&context))));
+
+		/* A command cut short (as by a host killed mid-transfer) must be flushed by SYNC */
+		crypt_fpga_transfer(&context, partial, partialRead, sizeof(partial));
+		check("crypt_fpga_resync", CRYPT_OK == crypt_fpga_resync(&context) && CRYPT_OK == crypt_fpga_check(&context));
+		check_paths(&context, &reference, "after resync:");
+
+		/* SEARCH cut short takes the SYNC bytes as its arguments: a search of 2^32 nonces for 255 zero bits, that must */
+		/* be ended rather than waited for */
+		if(context.deviceFeatures & CRYPT_FPGA_FEATURE_SEARCH) {
+			crypt_fpga_transfer(&context, partialSearch, partialRead, sizeof(partialSearch));
+			check("crypt_fpga_resync ends a search", CRYPT_OK == crypt_fpga_resync(&context) && CRYPT_OK == crypt_fpga_check(&context));
+		}
+	}
+
+	crypt_terminate(&context);
+	crypt_terminate(&reference);
+
+	printf("%d check(s) failed\n", failures);
+
+	return failures? 1 : 0;
+}
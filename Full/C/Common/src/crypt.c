@@ -0,0 +1,1157 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library                                                               * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/aes256.h"
+#include "../include/common.h"
+#include "../include/crypt.h"
+#include "../include/crypt_backend.h"
+#include "../include/sha256.h"
+
+#include <gcrypt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Records hashed and ciphered together by crypt_sign_batch() */
+#define SIGN_CHUNK 16
+/* Candidate nonces digested together by crypt_digest_search_chained() */
+#define SEARCH_CHUNK 64
+
+/* Backends, in order of preference for automatic selection */
+static const crypt_backend_t *backends[] = {
+#ifdef CRYPT_WITH_BCM2835
+	&crypt_backend_bcm2835,
+#endif
+#ifdef CRYPT_WITH_MRAA
+	&crypt_backend_mraa,
+#endif
+	&crypt_backend_spidev,
+	&crypt_backend_software,
+	&crypt_backend_sim,
+#ifdef CRYPT_WITH_VERILATOR
+	&crypt_backend_verilator,
+#endif
+	NULL
+};
+
+/**
+ * @brief Initialise a context.
+ */
+int crypt_initialise(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+	int i;
+	int backend = CRYPT_BACKEND_AUTO;
+	char *backendName = getenv("CRYPT_BACKEND");
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_initialise: Argument is NULL.\n");
+
+	/* Backend may be forced through environment */
+	if(backendName) {
+		for(i = 0; backends[i]; i++) {
+			if(!strcmp(backends[i]->name, backendName))
+				backend = backends[i]->id;
+		}
+
+		ASSERT(backend != CRYPT_BACKEND_AUTO, rv, CRYPT_FAILED, "crypt_initialise: Backend \"%s\" is not available.\n", backendName);
+	}
+
+	rv = crypt_initialise_backend(context, backend);
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Initialise a context with a specific digest backend.
+ */
+int crypt_initialise_backend(crypt_context_t *context, int backend) {
+	int rv = CRYPT_OK;
+	int i;
+	char *lanes = getenv("CRYPT_SPI_LANES");
+	char *ddr = getenv("CRYPT_SPI_DDR");
+	char *profile = getenv("CRYPT_SPI_PROFILE");
+	char *crc = getenv("CRYPT_SPI_CRC");
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_initialise_backend: Argument is NULL.\n");
+
+	gcry_check_version(GCRYPT_VERSION);
+	gcry_control(GCRYCTL_DISABLE_SECMEM);
+	gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
+
+	/* Pick SHA-256 and AES-256 kernels for this CPU */
+	sha256_select();
+	aes256_select();
+
+	context->backend = NULL;
+	context->spi = NULL;
+	context->cipher = NULL;
+	context->aesKey = NULL;
+	memset(&(context->busStats), 0, sizeof(crypt_bus_stats_t));
+	context->deviceCores = 0;
+	context->deviceFeatures = 0;
+	context->deviceFifo = 0;
+	context->readGap = CRYPT_FPGA_READ_GAP;
+	context->hmacKey = false;
+	context->hmacLoaded = false;
+	context->signLoaded = false;
+	memset(context->midstates, 0, sizeof(context->midstates));
+	context->midstateNext = 0;
+
+	/* Bus width is set by CRYPT_SPI_LANES and CRYPT_SPI_DDR, before backends configure their SPI */
+	context->busLanes = lanes? atoi(lanes) : 1;
+	context->busDdr = ddr && atoi(ddr);
+	context->busHz = 0;
+	context->busCrc = crc && atoi(crc);
+	ASSERT((1 == context->busLanes) || (2 == context->busLanes) || (4 == context->busLanes), rv, CRYPT_FAILED, "crypt_initialise_backend: CRYPT_SPI_LANES must be 1, 2 or 4.\n");
+
+	for(i = 0; backends[i]; i++) {
+		if(CRYPT_BACKEND_AUTO == backend) {
+			/* Pick the first backend that opens successfully. A bus opens with no FPGA on it as well, so that the */
+			/* FPGA must also be resynchronised and pass the known-answer check (through the digest functions, that */
+			/* take initialised contexts only) */
+			if(!backends[i]->autoSelect)
+				continue;
+			if(CRYPT_OK != backends[i]->open(context))
+				continue;
+
+			context->backend = backends[i];
+			context->initialised = true;
+			if(!(backends[i]->transfer) || ((CRYPT_OK == crypt_fpga_resync(context)) && (CRYPT_OK == crypt_fpga_check(context))))
+				break;
+
+			backends[i]->close(context);
+			context->backend = NULL;
+			context->initialised = false;
+			context->deviceCores = 0;
+			context->deviceFeatures = 0;
+			context->deviceFifo = 0;
+		}
+		else if(backends[i]->id == backend) {
+			ASSERT(CRYPT_OK == backends[i]->open(context), rv, CRYPT_FAILED, "crypt_initialise_backend: Failed to open backend \"%s\".\n", backends[i]->name);
+			context->backend = backends[i];
+			break;
+		}
+	}
+
+	ASSERT(context->backend, rv, CRYPT_FAILED, "crypt_initialise_backend: No backend available.\n");
+
+	/* Set initialised */
+	context->initialised = true;
+	context->secretKey[0] = '\0';
+
+	/* FPGA is brought back to a byte and command boundary, whatever a previous run or a stray SCLK edge left (already */
+	/* done while picking a backend automatically) */
+	if(context->backend->transfer) {
+		rv = (CRYPT_BACKEND_AUTO == backend)? CRYPT_OK : crypt_fpga_resync(context);
+		if(rv != CRYPT_OK) {
+			context->backend->close(context);
+			context->initialised = false;
+		}
+		ASSERT(CRYPT_OK == rv, rv, CRYPT_FAILED, "crypt_initialise_backend: Could not resynchronise FPGA.\n");
+		memset(&(context->busStats), 0, sizeof(crypt_bus_stats_t));
+	}
+
+	/* SPI clock is set from a profile (see crypt_calibrate()) */
+	if(profile && context->backend->setClock) {
+		rv = crypt_calibrate(context, profile);
+		if(rv != CRYPT_OK) {
+			context->backend->close(context);
+			context->initialised = false;
+		}
+		ASSERT(CRYPT_OK == rv, rv, CRYPT_FAILED, "crypt_initialise_backend: Could not calibrate SPI clock.\n");
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Get backend in use by a context.
+ */
+int crypt_get_backend(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_get_backend: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_get_backend: Context is not initialised.\n");
+
+	rv = context->backend->id;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Get name of backend in use by a context.
+ */
+const char *crypt_get_backend_name(crypt_context_t *context) {
+	if(!context || !(context->initialised))
+		return NULL;
+
+	return context->backend->name;
+}
+
+/**
+ * @brief Get number of SHA-256 cores of the FPGA in use by a context.
+ */
+int crypt_get_device_cores(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_get_device_cores: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_get_device_cores: Context is not initialised.\n");
+
+	rv = context->backend->transfer? crypt_fpga_cores(context) : 0;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Get SPI bus statistics of a context.
+ */
+int crypt_get_bus_stats(crypt_context_t *context, crypt_bus_stats_t *stats) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context && stats, rv, CRYPT_FAILED, "crypt_get_bus_stats: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_get_bus_stats: Context is not initialised.\n");
+
+	*stats = context->busStats;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Reset SPI bus statistics of a context.
+ */
+int crypt_reset_bus_stats(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_reset_bus_stats: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_reset_bus_stats: Context is not initialised.\n");
+
+	memset(&(context->busStats), 0, sizeof(crypt_bus_stats_t));
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Get the performance counters of the FPGA in use by a context.
+ */
+int crypt_get_device_stats(crypt_context_t *context, crypt_device_stats_t *stats) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context && stats, rv, CRYPT_FAILED, "crypt_get_device_stats: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_get_device_stats: Context is not initialised.\n");
+
+	if(context->backend->transfer) {
+		rv = crypt_fpga_device_stats(context, stats);
+	}
+	else {
+		memset(stats, 0, sizeof(crypt_device_stats_t));
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Get SPI clock of a context.
+ */
+int crypt_get_bus_clock(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_get_bus_clock: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_get_bus_clock: Context is not initialised.\n");
+
+	rv = context->busHz;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Read the SPI clock saved in a profile, if it was calibrated for the backend and bus width of a context.
+ */
+static int profile_load(crypt_context_t *context, const char *profile, uint32_t *hz) {
+	int rv = CRYPT_OK;
+	FILE *f = fopen(profile, "r");
+	char name[32];
+	unsigned int lanes, ddr, clock;
+
+	ASSERT_NOPRINT(f, rv, CRYPT_FAILED);
+	ASSERT_NOPRINT(4 == fscanf(f, "%31s %u %u %u", name, &lanes, &ddr, &clock), rv, CRYPT_FAILED);
+	ASSERT_NOPRINT(!strcmp(name, context->backend->name) && (lanes == context->busLanes) && (ddr == context->busDdr) && clock, rv, CRYPT_FAILED);
+
+	*hz = clock;
+
+_err:
+	if(f)
+		fclose(f);
+
+	return rv;
+}
+
+/**
+ * @brief Save the SPI clock of a context to a profile (backend, lanes, DDR and clock in Hz, in a single line).
+ */
+static int profile_save(crypt_context_t *context, const char *profile) {
+	int rv = CRYPT_OK;
+	FILE *f = fopen(profile, "w");
+
+	ASSERT(f, rv, CRYPT_FAILED, "profile_save: Could not open %s.\n", profile);
+	ASSERT(fprintf(f, "%s %u %u %u\n", context->backend->name, context->busLanes, context->busDdr? 1 : 0, context->busHz) > 0, rv, CRYPT_FAILED, "profile_save: Could not write %s.\n", profile);
+
+_err:
+	if(f && fclose(f))
+		rv = CRYPT_FAILED;
+
+	return rv;
+}
+
+/**
+ * @brief Calibrate SPI clock.
+ */
+int crypt_calibrate(crypt_context_t *context, const char *profile) {
+	int rv = CRYPT_OK;
+	uint32_t hz;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_calibrate: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_calibrate: Context is not initialised.\n");
+	ASSERT(context->backend->setClock, rv, CRYPT_FAILED, "crypt_calibrate: Backend has no SPI clock to set.\n");
+
+	/* Saved clock skips the sweep while it passes the known-answer check (cables and boards may have changed) */
+	if(profile && (CRYPT_OK == profile_load(context, profile, &hz))) {
+		ASSERT(CRYPT_OK == context->backend->setClock(context, hz), rv, CRYPT_FAILED, "crypt_calibrate: Could not set SPI clock.\n");
+		if(CRYPT_OK == crypt_fpga_check(context))
+			return rv;
+	}
+
+	ASSERT(CRYPT_OK == crypt_fpga_calibrate(context), rv, CRYPT_FAILED, "crypt_calibrate: No reliable SPI clock.\n");
+	if(profile) {
+		ASSERT(CRYPT_OK == profile_save(context, profile), rv, CRYPT_FAILED, "crypt_calibrate: Could not save profile.\n");
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Set secret key.
+ */
+int crypt_set_key(crypt_context_t *context, char *secretKey) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_set_key: Argument is NULL.\n");
+	ASSERT(secretKey, rv, CRYPT_FAILED, "crypt_set_key: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_set_key: Context is not initialised.\n");
+
+	gcry_error_t gcryError;
+	gcry_cipher_hd_t gcryCipherHd = NULL;
+	void *aesKey = NULL;
+	size_t keyLength = gcry_cipher_get_algo_keylen(GCRY_CIPHER_AES256);
+
+	memcpy(context->secretKey, secretKey, 32);
+
+	/* Key schedule is expanded once here and kept in the context for all (de)cipher calls */
+	if(context->cipher) {
+		gcry_cipher_close((gcry_cipher_hd_t) context->cipher);
+		context->cipher = NULL;
+	}
+	if(context->aesKey) {
+		aes256_wipe_key((aes256_key_t *) context->aesKey);
+		free(context->aesKey);
+		context->aesKey = NULL;
+	}
+
+	gcryError = gcry_cipher_open(&gcryCipherHd, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_CBC, 0);
+	ASSERT(!gcryError, rv, CRYPT_FAILED, "crypt_set_key: %s: %s\n", gcry_strsource(gcryError), gcry_strerror(gcryError));
+
+	gcryError = gcry_cipher_setkey(gcryCipherHd, context->secretKey, keyLength);
+	ASSERT(!gcryError, rv, CRYPT_FAILED, "crypt_set_key: %s: %s\n", gcry_strsource(gcryError), gcry_strerror(gcryError));
+
+	/* Same key for the native kernels, in all their layouts */
+	ASSERT(!posix_memalign(&aesKey, 64, sizeof(aes256_key_t)), rv, CRYPT_FAILED, "crypt_set_key: Out of memory.\n");
+	aes256_expand_key((aes256_key_t *) aesKey, (uint8_t *) context->secretKey);
+
+	context->cipher = gcryCipherHd;
+	context->aesKey = aesKey;
+	context->signLoaded = false;
+	gcryCipherHd = NULL;
+
+_err:
+	if(gcryCipherHd)
+		gcry_cipher_close(gcryCipherHd);
+
+	return rv;
+}
+
+/**
+ * @brief Decipher a buffer using AES-256 with CBC.
+ */
+int crypt_aes_dec(crypt_context_t *context, char *encBuffer, char *outBuffer, unsigned int buffLen, char *iniVector) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_aes_dec: Argument is NULL.\n");
+	ASSERT(encBuffer, rv, CRYPT_FAILED, "crypt_aes_dec: Argument is NULL.\n");
+	ASSERT(outBuffer, rv, CRYPT_FAILED, "crypt_aes_dec: Argument is NULL.\n");
+	ASSERT(iniVector, rv, CRYPT_FAILED, "crypt_aes_dec: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_aes_dec: Context is not initialised.\n");
+	ASSERT(context->cipher, rv, CRYPT_FAILED, "crypt_aes_dec: Key is not set.\n");
+
+	/* Blocks of a CBC decryption are independent, so they are deciphered in parallel by the native kernel */
+	if(aes256_dec_blocks && (buffLen / 16) >= aes256_min_blocks) {
+		ASSERT(0 == (buffLen % 16), rv, CRYPT_FAILED, "crypt_aes_dec: Buffer size is not a multiple of 16.\n");
+		aes256_cbc_dec((aes256_key_t *) context->aesKey, (uint8_t *) encBuffer, (uint8_t *) outBuffer, buffLen, (uint8_t *) iniVector);
+	}
+	else {
+		gcry_error_t gcryError;
+		gcry_cipher_hd_t gcryCipherHd = (gcry_cipher_hd_t) context->cipher;
+		size_t blkLength = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+
+		/* Handle is kept open with the expanded key, only IV is reset */
+		gcryError = gcry_cipher_setiv(gcryCipherHd, iniVector, blkLength);
+		ASSERT(!gcryError, rv, CRYPT_FAILED, "crypt_aes_dec: %s: %s\n", gcry_strsource(gcryError), gcry_strerror(gcryError));
+
+		gcryError = gcry_cipher_decrypt(gcryCipherHd, outBuffer, buffLen, encBuffer, buffLen);
+		ASSERT(!gcryError, rv, CRYPT_FAILED, "crypt_aes_dec: %s: %s\n", gcry_strsource(gcryError), gcry_strerror(gcryError));
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Cipher a buffer using AES-256 with CBC.
+ */
+int crypt_aes_enc(crypt_context_t *context, char *inBuffer, char *encBuffer, unsigned int buffLen, char *iniVector) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_aes_enc: Argument is NULL.\n");
+	ASSERT(inBuffer, rv, CRYPT_FAILED, "crypt_aes_enc: Argument is NULL.\n");
+	ASSERT(encBuffer, rv, CRYPT_FAILED, "crypt_aes_enc: Argument is NULL.\n");
+	ASSERT(iniVector, rv, CRYPT_FAILED, "crypt_aes_enc: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_aes_enc: Context is not initialised.\n");
+	ASSERT(context->cipher, rv, CRYPT_FAILED, "crypt_aes_enc: Key is not set.\n");
+
+	/* A single CBC encryption is serial, which only AES instructions do faster than libgcrypt */
+	if(aes256_enc_blocks && 1 == aes256_min_blocks) {
+		ASSERT(0 == (buffLen % 16), rv, CRYPT_FAILED, "crypt_aes_enc: Buffer size is not a multiple of 16.\n");
+		aes256_cbc_enc((aes256_key_t *) context->aesKey, (uint8_t *) inBuffer, (uint8_t *) encBuffer, buffLen, (uint8_t *) iniVector);
+	}
+	else {
+		gcry_error_t gcryError;
+		gcry_cipher_hd_t gcryCipherHd = (gcry_cipher_hd_t) context->cipher;
+		size_t blkLength = gcry_cipher_get_algo_blklen(GCRY_CIPHER_AES256);
+
+		/* Handle is kept open with the expanded key, only IV is reset */
+		gcryError = gcry_cipher_setiv(gcryCipherHd, iniVector, blkLength);
+		ASSERT(!gcryError, rv, CRYPT_FAILED, "crypt_aes_enc: %s: %s\n", gcry_strsource(gcryError), gcry_strerror(gcryError));
+
+		gcryError = gcry_cipher_encrypt(gcryCipherHd, encBuffer, buffLen, inBuffer, buffLen);
+		ASSERT(!gcryError, rv, CRYPT_FAILED, "crypt_aes_enc: %s: %s\n", gcry_strsource(gcryError), gcry_strerror(gcryError));
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest a buffer using SHA-256.
+ */
+int crypt_digest(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_digest: Argument is NULL.\n");
+	ASSERT(inBuffer, rv, CRYPT_FAILED, "crypt_digest: Argument is NULL.\n");
+	ASSERT(digest, rv, CRYPT_FAILED, "crypt_digest: Argument is NULL.\n");
+	ASSERT(inBufferLen >= 0, rv, CRYPT_FAILED, "crypt_digest: Negative buffer size.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_digest: Context is not initialised.\n");
+
+	rv = context->backend->digest(context, inBuffer, inBufferLen, digest);
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Compress whole blocks of a multi-block digest, in the backend or in software.
+ */
+static int digest_blocks(crypt_context_t *context, crypt_digest_state_t *state, const uint8_t *blocks, unsigned int nBlocks, char *digest) {
+	int rv = CRYPT_OK;
+	int i;
+
+	if(context->backend->digestBlocks) {
+		rv = context->backend->digestBlocks(context, state, blocks, nBlocks, digest);
+	}
+	else {
+		sha256_compress(state->h, blocks, nBlocks);
+
+		if(digest) {
+			for(i = 0; i < 8; i++) {
+				digest[(4 * i)] = state->h[i] >> 24;
+				digest[(4 * i) + 1] = state->h[i] >> 16;
+				digest[(4 * i) + 2] = state->h[i] >> 8;
+				digest[(4 * i) + 3] = state->h[i];
+			}
+		}
+	}
+
+	state->first = false;
+	state->load = false;
+
+	return rv;
+}
+
+/**
+ * @brief Start a multi-block digest using SHA-256.
+ */
+int crypt_digest_init(crypt_context_t *context, crypt_digest_state_t *state) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_digest_init: Argument is NULL.\n");
+	ASSERT(state, rv, CRYPT_FAILED, "crypt_digest_init: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_digest_init: Context is not initialised.\n");
+
+	memcpy(state->h, sha256_h0, sizeof(state->h));
+	state->length = 0;
+	state->first = true;
+	state->load = false;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Add data to a multi-block digest.
+ */
+int crypt_digest_update(crypt_context_t *context, crypt_digest_state_t *state, char *inBuffer, int inBufferLen) {
+	int rv = CRYPT_OK;
+	unsigned int fill, len;
+	const uint8_t *in = (const uint8_t *) inBuffer;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_digest_update: Argument is NULL.\n");
+	ASSERT(state, rv, CRYPT_FAILED, "crypt_digest_update: Argument is NULL.\n");
+	ASSERT(inBuffer || !inBufferLen, rv, CRYPT_FAILED, "crypt_digest_update: Argument is NULL.\n");
+	ASSERT(inBufferLen >= 0, rv, CRYPT_FAILED, "crypt_digest_update: Negative buffer size.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_digest_update: Context is not initialised.\n");
+
+	fill = state->length % 64;
+	state->length += inBufferLen;
+
+	/* Complete pending block first */
+	if(fill) {
+		len = ((64 - fill) < (unsigned int) inBufferLen)? (64 - fill) : (unsigned int) inBufferLen;
+		memcpy(&(state->buffer[fill]), in, len);
+		in += len;
+		inBufferLen -= len;
+
+		if(64 == (fill + len)) {
+			ASSERT(CRYPT_OK == digest_blocks(context, state, state->buffer, 1, NULL), rv, CRYPT_FAILED, "crypt_digest_update: Could not compress block.\n");
+		}
+	}
+
+	/* Whole blocks go straight from input buffer */
+	if(inBufferLen >= 64) {
+		ASSERT(CRYPT_OK == digest_blocks(context, state, in, inBufferLen / 64, NULL), rv, CRYPT_FAILED, "crypt_digest_update: Could not compress block.\n");
+		in += inBufferLen & ~63;
+		inBufferLen &= 63;
+	}
+
+	memcpy(state->buffer, in, inBufferLen);
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Pad and finish a multi-block digest.
+ */
+int crypt_digest_final(crypt_context_t *context, crypt_digest_state_t *state, char *digest) {
+	int rv = CRYPT_OK;
+	int i;
+	unsigned int fill, nBlocks;
+	uint8_t pad[128];
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_digest_final: Argument is NULL.\n");
+	ASSERT(state, rv, CRYPT_FAILED, "crypt_digest_final: Argument is NULL.\n");
+	ASSERT(digest, rv, CRYPT_FAILED, "crypt_digest_final: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_digest_final: Context is not initialised.\n");
+
+	/* Standard SHA padding: 0x80, zeroes and message size in bits (big endian) */
+	fill = state->length % 64;
+	nBlocks = (fill < 56)? 1 : 2;
+	memset(pad, 0, sizeof(pad));
+	memcpy(pad, state->buffer, fill);
+	pad[fill] = 0x80;
+	for(i = 0; i < 8; i++)
+		pad[(64 * nBlocks) - 1 - i] = (state->length * 8) >> (8 * i);
+
+	ASSERT(CRYPT_OK == digest_blocks(context, state, pad, nBlocks, digest), rv, CRYPT_FAILED, "crypt_digest_final: Could not compress block.\n");
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Get the intermediate hash value of a multi-block digest.
+ */
+int crypt_digest_midstate(crypt_context_t *context, crypt_digest_state_t *state, char *midstate) {
+	int rv = CRYPT_OK;
+	int i;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_digest_midstate: Argument is NULL.\n");
+	ASSERT(state, rv, CRYPT_FAILED, "crypt_digest_midstate: Argument is NULL.\n");
+	ASSERT(midstate, rv, CRYPT_FAILED, "crypt_digest_midstate: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_digest_midstate: Context is not initialised.\n");
+	ASSERT(!(state->length % 64), rv, CRYPT_FAILED, "crypt_digest_midstate: Message size is not a multiple of 64.\n");
+
+	/* Nothing compressed yet (or nothing since crypt_digest_resume()): h is up to date on any backend */
+	if(state->first || state->load) {
+		for(i = 0; i < 8; i++) {
+			midstate[(4 * i)] = state->h[i] >> 24;
+			midstate[(4 * i) + 1] = state->h[i] >> 16;
+			midstate[(4 * i) + 2] = state->h[i] >> 8;
+			midstate[(4 * i) + 3] = state->h[i];
+		}
+	}
+	else {
+		/* Same as the last blocks of a message, with no blocks */
+		ASSERT(CRYPT_OK == digest_blocks(context, state, NULL, 0, midstate), rv, CRYPT_FAILED, "crypt_digest_midstate: Could not read hash value.\n");
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Start a multi-block digest from a midstate.
+ */
+int crypt_digest_resume(crypt_context_t *context, crypt_digest_state_t *state, char *midstate, uint64_t length) {
+	int rv = CRYPT_OK;
+	int i;
+	const uint8_t *m = (const uint8_t *) midstate;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_digest_resume: Argument is NULL.\n");
+	ASSERT(state, rv, CRYPT_FAILED, "crypt_digest_resume: Argument is NULL.\n");
+	ASSERT(midstate, rv, CRYPT_FAILED, "crypt_digest_resume: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_digest_resume: Context is not initialised.\n");
+	ASSERT(!(length % 64), rv, CRYPT_FAILED, "crypt_digest_resume: Message size is not a multiple of 64.\n");
+
+	for(i = 0; i < 8; i++)
+		state->h[i] = (m[4 * i] << 24) | (m[(4 * i) + 1] << 16) | (m[(4 * i) + 2] << 8) | m[(4 * i) + 3];
+	state->length = length;
+	state->first = false;
+	state->load = true;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest a buffer preceded by a prefix, caching the prefix midstate.
+ */
+int crypt_digest_prefixed(crypt_context_t *context, char *prefix, int prefixLen, char *inBuffer, int inBufferLen, char *digest) {
+	int rv = CRYPT_OK;
+	unsigned int i;
+	unsigned int whole = (prefixLen > 0)? (prefixLen & ~63) : 0;
+	crypt_digest_state_t state;
+	crypt_midstate_t *entry = NULL;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_digest_prefixed: Argument is NULL.\n");
+	ASSERT(prefix || !prefixLen, rv, CRYPT_FAILED, "crypt_digest_prefixed: Argument is NULL.\n");
+	ASSERT(prefixLen >= 0, rv, CRYPT_FAILED, "crypt_digest_prefixed: Negative buffer size.\n");
+	ASSERT(digest, rv, CRYPT_FAILED, "crypt_digest_prefixed: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_digest_prefixed: Context is not initialised.\n");
+
+	/* Prefixes shorter than a block have nothing to save */
+	for(i = 0; whole && (i < CRYPT_MIDSTATE_CACHE); i++) {
+		if((context->midstates[i].prefixLen == whole) && !memcmp(context->midstates[i].prefix, prefix, whole))
+			entry = &(context->midstates[i]);
+	}
+
+	if(entry) {
+		ASSERT(CRYPT_OK == crypt_digest_resume(context, &state, (char *) entry->midstate, whole), rv, CRYPT_FAILED, "crypt_digest_prefixed: Could not resume digest.\n");
+	}
+	else {
+		ASSERT(CRYPT_OK == crypt_digest_init(context, &state), rv, CRYPT_FAILED, "crypt_digest_prefixed: Could not start digest.\n");
+
+		if(whole) {
+			ASSERT(CRYPT_OK == crypt_digest_update(context, &state, prefix, whole), rv, CRYPT_FAILED, "crypt_digest_prefixed: Could not update digest.\n");
+
+			/* Oldest entry is replaced */
+			entry = &(context->midstates[context->midstateNext]);
+			context->midstateNext = (context->midstateNext + 1) % CRYPT_MIDSTATE_CACHE;
+			free(entry->prefix);
+			entry->prefixLen = 0;
+			entry->prefix = malloc(whole);
+			ASSERT(entry->prefix, rv, CRYPT_FAILED, "crypt_digest_prefixed: Could not allocate memory.\n");
+			memcpy(entry->prefix, prefix, whole);
+
+			ASSERT(CRYPT_OK == crypt_digest_midstate(context, &state, (char *) entry->midstate), rv, CRYPT_FAILED, "crypt_digest_prefixed: Could not get midstate.\n");
+			entry->prefixLen = whole;
+		}
+	}
+
+	ASSERT(CRYPT_OK == crypt_digest_update(context, &state, &prefix[whole], prefixLen - whole), rv, CRYPT_FAILED, "crypt_digest_prefixed: Could not update digest.\n");
+	ASSERT(CRYPT_OK == crypt_digest_update(context, &state, inBuffer, inBufferLen), rv, CRYPT_FAILED, "crypt_digest_prefixed: Could not update digest.\n");
+	ASSERT(CRYPT_OK == crypt_digest_final(context, &state, digest), rv, CRYPT_FAILED, "crypt_digest_prefixed: Could not finish digest.\n");
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest several independent buffers using SHA-256.
+ */
+int crypt_digest_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests) {
+	int rv = CRYPT_OK;
+	unsigned int i;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_digest_batch: Argument is NULL.\n");
+	ASSERT(inBuffers, rv, CRYPT_FAILED, "crypt_digest_batch: Argument is NULL.\n");
+	ASSERT(inBufferLens, rv, CRYPT_FAILED, "crypt_digest_batch: Argument is NULL.\n");
+	ASSERT(digests, rv, CRYPT_FAILED, "crypt_digest_batch: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_digest_batch: Context is not initialised.\n");
+
+	for(i = 0; i < n; i++) {
+		ASSERT(inBuffers[i] && digests[i], rv, CRYPT_FAILED, "crypt_digest_batch: Argument is NULL.\n");
+		ASSERT(inBufferLens[i] >= 0, rv, CRYPT_FAILED, "crypt_digest_batch: Negative buffer size.\n");
+	}
+
+	if(context->backend->digestBatch) {
+		rv = context->backend->digestBatch(context, inBuffers, inBufferLens, n, digests);
+	}
+	else {
+		for(i = 0; CRYPT_OK == rv && i < n; i++)
+			rv = context->backend->digest(context, inBuffers[i], inBufferLens[i], digests[i]);
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest and sign several independent buffers through the digest functions, ciphering on the host.
+ */
+int crypt_sign_batch_chained(crypt_context_t *context, char **readings, int *readingLens, unsigned int n, char **digests, char **signatures, char *iniVector) {
+	int rv = CRYPT_OK;
+	unsigned int i, k, chunk;
+
+	for(i = 0; i < n; i += chunk) {
+		chunk = (n - i < SIGN_CHUNK)? n - i : SIGN_CHUNK;
+
+		rv = crypt_digest_batch(context, &readings[i], &readingLens[i], chunk, &digests[i]);
+		ASSERT(CRYPT_OK == rv, rv, CRYPT_FAILED, "crypt_sign_batch_chained: Failed to digest buffers.\n");
+
+		/* Digests are still in cache. CBC chains of the chunk are interleaved to keep the AES kernel busy */
+		if(aes256_enc_blocks && chunk >= aes256_min_blocks) {
+			aes256_cbc_enc_batch((aes256_key_t *) context->aesKey, (const uint8_t **) &digests[i], (uint8_t **) &signatures[i], 32, chunk, (uint8_t *) iniVector);
+		}
+		else {
+			for(k = 0; k < chunk; k++) {
+				rv = crypt_aes_enc(context, digests[i + k], signatures[i + k], 32, iniVector);
+				ASSERT(CRYPT_OK == rv, rv, CRYPT_FAILED, "crypt_sign_batch_chained: Failed to cipher digest.\n");
+			}
+		}
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest and sign several independent buffers.
+ */
+int crypt_sign_batch(crypt_context_t *context, char **readings, int *readingLens, unsigned int n, char **digests, char **signatures, char *iniVector) {
+	int rv = CRYPT_OK;
+	unsigned int i;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_sign_batch: Argument is NULL.\n");
+	ASSERT(readings, rv, CRYPT_FAILED, "crypt_sign_batch: Argument is NULL.\n");
+	ASSERT(readingLens, rv, CRYPT_FAILED, "crypt_sign_batch: Argument is NULL.\n");
+	ASSERT(digests, rv, CRYPT_FAILED, "crypt_sign_batch: Argument is NULL.\n");
+	ASSERT(signatures, rv, CRYPT_FAILED, "crypt_sign_batch: Argument is NULL.\n");
+	ASSERT(iniVector, rv, CRYPT_FAILED, "crypt_sign_batch: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_sign_batch: Context is not initialised.\n");
+	ASSERT(context->cipher, rv, CRYPT_FAILED, "crypt_sign_batch: Key is not set.\n");
+
+	for(i = 0; i < n; i++) {
+		ASSERT(readings[i] && digests[i] && signatures[i], rv, CRYPT_FAILED, "crypt_sign_batch: Argument is NULL.\n");
+		ASSERT(readingLens[i] >= 0, rv, CRYPT_FAILED, "crypt_sign_batch: Negative buffer size.\n");
+	}
+
+	if(context->backend->signBatch) {
+		rv = context->backend->signBatch(context, readings, readingLens, n, digests, signatures, iniVector);
+	}
+	else {
+		rv = crypt_sign_batch_chained(context, readings, readingLens, n, digests, signatures, iniVector);
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Set the HMAC-SHA256 key.
+ */
+int crypt_set_hmac_key(crypt_context_t *context, char *key, int keyLen) {
+	int rv = CRYPT_OK;
+	int i, j;
+	uint8_t k[64];
+	uint8_t block[64];
+	uint32_t h[8];
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_set_hmac_key: Argument is NULL.\n");
+	ASSERT(key || !keyLen, rv, CRYPT_FAILED, "crypt_set_hmac_key: Argument is NULL.\n");
+	ASSERT(keyLen >= 0, rv, CRYPT_FAILED, "crypt_set_hmac_key: Negative key size.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_set_hmac_key: Context is not initialised.\n");
+
+	/* Key is zero-padded to a block, or hashed if longer */
+	memset(k, 0, sizeof(k));
+	if(keyLen > 64)
+		sha256_digest((uint8_t *) key, keyLen, k);
+	else
+		memcpy(k, key, keyLen);
+
+	/* Inner and outer midstates: a single block of key ^ ipad and key ^ opad */
+	for(i = 0; i < 64; i++)
+		block[i] = k[i] ^ 0x36;
+	memcpy(h, sha256_h0, sizeof(h));
+	sha256_compress(h, block, 1);
+	for(j = 0; j < 32; j++)
+		context->hmacIpad[j] = h[j / 4] >> (24 - (8 * (j % 4)));
+
+	for(i = 0; i < 64; i++)
+		block[i] = k[i] ^ 0x5c;
+	memcpy(h, sha256_h0, sizeof(h));
+	sha256_compress(h, block, 1);
+	for(j = 0; j < 32; j++)
+		context->hmacOpad[j] = h[j / 4] >> (24 - (8 * (j % 4)));
+
+	context->hmacKey = true;
+	context->hmacLoaded = false;
+
+	memset(k, 0, sizeof(k));
+	memset(block, 0, sizeof(block));
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief HMAC-SHA256 of a buffer through the digest functions, resuming the key midstates.
+ */
+int crypt_hmac_chained(crypt_context_t *context, char *inBuffer, int inBufferLen, char *mac) {
+	int rv = CRYPT_OK;
+	char inner[32];
+	crypt_digest_state_t state;
+
+	ASSERT(CRYPT_OK == crypt_digest_resume(context, &state, (char *) context->hmacIpad, 64), rv, CRYPT_FAILED, "crypt_hmac_chained: Could not resume inner digest.\n");
+	ASSERT(CRYPT_OK == crypt_digest_update(context, &state, inBuffer, inBufferLen), rv, CRYPT_FAILED, "crypt_hmac_chained: Could not update inner digest.\n");
+	ASSERT(CRYPT_OK == crypt_digest_final(context, &state, inner), rv, CRYPT_FAILED, "crypt_hmac_chained: Could not finish inner digest.\n");
+
+	ASSERT(CRYPT_OK == crypt_digest_resume(context, &state, (char *) context->hmacOpad, 64), rv, CRYPT_FAILED, "crypt_hmac_chained: Could not resume outer digest.\n");
+	ASSERT(CRYPT_OK == crypt_digest_update(context, &state, inner, 32), rv, CRYPT_FAILED, "crypt_hmac_chained: Could not update outer digest.\n");
+	ASSERT(CRYPT_OK == crypt_digest_final(context, &state, mac), rv, CRYPT_FAILED, "crypt_hmac_chained: Could not finish outer digest.\n");
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief HMAC-SHA256 of a buffer.
+ */
+int crypt_hmac(crypt_context_t *context, char *inBuffer, int inBufferLen, char *mac) {
+	return crypt_hmac_batch(context, &inBuffer, &inBufferLen, 1, &mac);
+}
+
+/**
+ * @brief HMAC-SHA256 of several independent buffers.
+ */
+int crypt_hmac_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **macs) {
+	int rv = CRYPT_OK;
+	unsigned int i;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_hmac_batch: Argument is NULL.\n");
+	ASSERT(inBuffers && inBufferLens && macs, rv, CRYPT_FAILED, "crypt_hmac_batch: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_hmac_batch: Context is not initialised.\n");
+	ASSERT(context->hmacKey, rv, CRYPT_FAILED, "crypt_hmac_batch: HMAC key is not set.\n");
+
+	for(i = 0; i < n; i++) {
+		ASSERT(inBuffers[i] && macs[i], rv, CRYPT_FAILED, "crypt_hmac_batch: Argument is NULL.\n");
+		ASSERT(inBufferLens[i] >= 0, rv, CRYPT_FAILED, "crypt_hmac_batch: Negative buffer size.\n");
+	}
+
+	if(context->backend->hmacBatch) {
+		rv = context->backend->hmacBatch(context, inBuffers, inBufferLens, n, macs);
+	}
+	else {
+		for(i = 0; i < n; i++) {
+			ASSERT(CRYPT_OK == crypt_hmac_chained(context, inBuffers[i], inBufferLens[i], macs[i]), rv, CRYPT_FAILED, "crypt_hmac_batch: Could not compute MAC.\n");
+		}
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief SHA-256d of a buffer through the digest functions.
+ */
+int crypt_digest_double_chained(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest) {
+	int rv = CRYPT_OK;
+	char inner[32];
+
+	ASSERT(CRYPT_OK == crypt_digest(context, inBuffer, inBufferLen, inner), rv, CRYPT_FAILED, "crypt_digest_double_chained: Could not compute inner digest.\n");
+	ASSERT(CRYPT_OK == crypt_digest(context, inner, 32, digest), rv, CRYPT_FAILED, "crypt_digest_double_chained: Could not compute outer digest.\n");
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief SHA-256d of a buffer.
+ */
+int crypt_digest_double(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest) {
+	return crypt_digest_double_batch(context, &inBuffer, &inBufferLen, 1, &digest);
+}
+
+/**
+ * @brief SHA-256d of several independent buffers.
+ */
+int crypt_digest_double_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests) {
+	int rv = CRYPT_OK;
+	unsigned int i;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_digest_double_batch: Argument is NULL.\n");
+	ASSERT(inBuffers && inBufferLens && digests, rv, CRYPT_FAILED, "crypt_digest_double_batch: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_digest_double_batch: Context is not initialised.\n");
+
+	for(i = 0; i < n; i++) {
+		ASSERT(inBuffers[i] && digests[i], rv, CRYPT_FAILED, "crypt_digest_double_batch: Argument is NULL.\n");
+		ASSERT(inBufferLens[i] >= 0, rv, CRYPT_FAILED, "crypt_digest_double_batch: Negative buffer size.\n");
+	}
+
+	if(context->backend->doubleBatch) {
+		rv = context->backend->doubleBatch(context, inBuffers, inBufferLens, n, digests);
+	}
+	else {
+		for(i = 0; i < n; i++) {
+			ASSERT(CRYPT_OK == crypt_digest_double_chained(context, inBuffers[i], inBufferLens[i], digests[i]), rv, CRYPT_FAILED, "crypt_digest_double_batch: Could not compute digest.\n");
+		}
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Count the leading zero bits of a digest.
+ */
+int crypt_zero_bits(const char *digest) {
+	int bits = 0;
+	const uint8_t *d = (const uint8_t *) digest;
+
+	while((bits < 256) && !(d[bits / 8] & (0x80 >> (bits % 8))))
+		bits++;
+
+	return bits;
+}
+
+/**
+ * @brief Search the nonce of a proof of work on the host, compressing only the blocks from the nonce on.
+ */
+static int search_blocks(char *inBuffer, int inBufferLen, int nonceOffset, int zeroBits, char *digest, uint64_t *attempts) {
+	int rv = CRYPT_OK;
+	unsigned int i;
+	unsigned int whole = nonceOffset & ~63;
+	unsigned int tailLen = inBufferLen - whole;
+	unsigned int nBlocks = (tailLen + 9 + 63) / 64;
+	uint64_t bitLen = (uint64_t) inBufferLen * 8;
+	uint32_t midstate[8], state[8];
+	uint32_t nonce;
+	uint8_t *field = (uint8_t *) &inBuffer[nonceOffset];
+	uint8_t *tail = calloc(nBlocks, 64);
+	uint8_t *tailField;
+
+	ASSERT(tail, rv, CRYPT_FAILED, "crypt_digest_search: Could not allocate memory.\n");
+	tailField = &tail[nonceOffset - whole];
+
+	/* Blocks before the one holding the nonce are the same for all candidates */
+	memcpy(midstate, sha256_h0, sizeof(midstate));
+	sha256_compress(midstate, (const uint8_t *) inBuffer, whole / 64);
+
+	/* Standard SHA padding, done once */
+	memcpy(tail, &inBuffer[whole], tailLen);
+	tail[tailLen] = 0x80;
+	for(i = 0; i < 8; i++)
+		tail[(64 * nBlocks) - 1 - i] = bitLen >> (8 * i);
+
+	nonce = (field[0] << 24) | (field[1] << 16) | (field[2] << 8) | field[3];
+	for(*attempts = 1; ; (*attempts)++, nonce++) {
+		ASSERT(*attempts <= (1ULL << 32), rv, CRYPT_FAILED, "crypt_digest_search: No nonce found.\n");
+
+		for(i = 0; i < 4; i++)
+			tailField[i] = nonce >> (24 - (8 * i));
+		memcpy(state, midstate, sizeof(state));
+		sha256_compress(state, tail, nBlocks);
+
+		for(i = 0; i < 8; i++) {
+			digest[(4 * i)] = state[i] >> 24;
+			digest[(4 * i) + 1] = state[i] >> 16;
+			digest[(4 * i) + 2] = state[i] >> 8;
+			digest[(4 * i) + 3] = state[i];
+		}
+		if(crypt_zero_bits(digest) >= zeroBits) {
+			memcpy(field, tailField, 4);
+			break;
+		}
+	}
+
+_err:
+	free(tail);
+	return rv;
+}
+
+/**
+ * @brief Search the nonce of a proof of work through the digest functions.
+ */
+int crypt_digest_search_chained(crypt_context_t *context, char *inBuffer, int inBufferLen, int nonceOffset, int zeroBits, char *digest, uint64_t *attempts) {
+	int rv = CRYPT_OK;
+	unsigned int i, j;
+	uint32_t nonce;
+	uint8_t *field = (uint8_t *) &inBuffer[nonceOffset];
+	char *candidates = malloc(SEARCH_CHUNK * inBufferLen);
+	char *inBuffers[SEARCH_CHUNK];
+	int inBufferLens[SEARCH_CHUNK];
+	char digestBuffs[SEARCH_CHUNK][32];
+	char *digests[SEARCH_CHUNK];
+
+	ASSERT(candidates, rv, CRYPT_FAILED, "crypt_digest_search_chained: Could not allocate memory.\n");
+
+	for(i = 0; i < SEARCH_CHUNK; i++) {
+		inBuffers[i] = &candidates[i * inBufferLen];
+		inBufferLens[i] = inBufferLen;
+		digests[i] = digestBuffs[i];
+		memcpy(inBuffers[i], inBuffer, inBufferLen);
+	}
+
+	/* 2^32 is a multiple of the chunk, so that chunks are always whole */
+	nonce = (field[0] << 24) | (field[1] << 16) | (field[2] << 8) | field[3];
+	for(*attempts = 0; ; *attempts += SEARCH_CHUNK) {
+		ASSERT(*attempts < (1ULL << 32), rv, CRYPT_FAILED, "crypt_digest_search_chained: No nonce found.\n");
+
+		for(i = 0; i < SEARCH_CHUNK; i++) {
+			for(j = 0; j < 4; j++)
+				inBuffers[i][nonceOffset + j] = (nonce + i) >> (24 - (8 * j));
+		}
+		ASSERT(CRYPT_OK == crypt_digest_batch(context, inBuffers, inBufferLens, SEARCH_CHUNK, digests), rv, CRYPT_FAILED, "crypt_digest_search_chained: Could not digest candidates.\n");
+
+		for(i = 0; (i < SEARCH_CHUNK) && (crypt_zero_bits(digests[i]) < zeroBits); i++);
+		if(i < SEARCH_CHUNK) {
+			memcpy(field, &inBuffers[i][nonceOffset], 4);
+			memcpy(digest, digests[i], 32);
+			*attempts += i + 1;
+			break;
+		}
+		nonce += SEARCH_CHUNK;
+	}
+
+_err:
+	free(candidates);
+	return rv;
+}
+
+/**
+ * @brief Search the nonce of a proof of work.
+ */
+int crypt_digest_search(crypt_context_t *context, char *inBuffer, int inBufferLen, int nonceOffset, int zeroBits, char *digest, uint64_t *attempts) {
+	int rv = CRYPT_OK;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_digest_search: Argument is NULL.\n");
+	ASSERT(inBuffer && digest && attempts, rv, CRYPT_FAILED, "crypt_digest_search: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_digest_search: Context is not initialised.\n");
+	ASSERT((nonceOffset >= 0) && ((nonceOffset + 4) <= inBufferLen), rv, CRYPT_FAILED, "crypt_digest_search: Nonce is out of the buffer.\n");
+	ASSERT((zeroBits >= 0) && (zeroBits < 256), rv, CRYPT_FAILED, "crypt_digest_search: Invalid number of zero bits.\n");
+
+	if(context->backend->search) {
+		rv = context->backend->search(context, inBuffer, inBufferLen, nonceOffset, zeroBits, digest, attempts);
+	}
+	else if(!context->backend->digestBlocks && !sha256_mb_lanes()) {
+		/* Batches would be hashed one by one on the host, where a midstate saves the blocks before the nonce */
+		rv = search_blocks(inBuffer, inBufferLen, nonceOffset, zeroBits, digest, attempts);
+	}
+	else {
+		rv = crypt_digest_search_chained(context, inBuffer, inBufferLen, nonceOffset, zeroBits, digest, attempts);
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Terminate a context.
+ */
+int crypt_terminate(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+	int i;
+
+	ASSERT(context, rv, CRYPT_FAILED, "crypt_terminate: Argument is NULL.\n");
+	ASSERT(context->initialised, rv, CRYPT_FAILED, "crypt_terminate: Context is not initialised.\n");
+
+	rv = context->backend->close(context);
+	context->backend = NULL;
+
+	memset(context->hmacIpad, 0, sizeof(context->hmacIpad));
+	memset(context->hmacOpad, 0, sizeof(context->hmacOpad));
+	context->hmacKey = false;
+
+	for(i = 0; i < CRYPT_MIDSTATE_CACHE; i++) {
+		free(context->midstates[i].prefix);
+		context->midstates[i].prefix = NULL;
+		context->midstates[i].prefixLen = 0;
+	}
+
+	if(context->cipher) {
+		gcry_cipher_close((gcry_cipher_hd_t) context->cipher);
+		context->cipher = NULL;
+	}
+	if(context->aesKey) {
+		aes256_wipe_key((aes256_key_t *) context->aesKey);
+		free(context->aesKey);
+		context->aesKey = NULL;
+	}
+
+	/* Set terminated */
+	context->initialised = false;
+
+_err:
+	return rv;
+}
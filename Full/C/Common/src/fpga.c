@@ -0,0 +1,1329 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (FPGA Protocol)                                               * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/common.h"
+#include "../include/crypt.h"
+#include "../include/crypt_backend.h"
+#include "../include/sha256.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Blocks sent in a single transfer */
+#define FPGA_BLOCKS 16
+/* SHORT commands pipelined in a single transfer */
+#define FPGA_SHORTS 64
+/* Transfers with no response before the FPGA is given up */
+#define FPGA_IDLE_MAX 4
+/* 32-byte requests in a BATCH frame, so that a frame and its tail fit in 4096 bytes (spidev default buffer size). */
+/* Fewer in CRC mode, as entries and responses take two more bytes each */
+#define FPGA_FRAME 120
+#define FPGA_FRAME_CRC 112
+/* NOPs after a BATCH frame of n requests with responses of resp bytes. Responses take a byte more than requests, */
+/* plus the core latency */
+#define FPGA_FRAME_TAIL(n, resp) ((((n) / 32) + 2) * (resp) + CRYPT_FPGA_DELAY)
+/* 32-byte requests in a SIGN frame. Responses take about twice the bytes of requests, so that half of them are left */
+/* for the tail, and the FIFO fills by about one entry every two: frames fit in the same buffer, and in FIFOs as */
+/* small as half of them */
+#define FPGA_SIGN_FRAME 56
+#define FPGA_SIGN_TAIL(n, resp) (((((n) + 1) / 2) + 2) * (resp) + CRYPT_FPGA_DELAY)
+/* NOPs before READ at most */
+#define FPGA_GAP_MAX 32
+/* Bytes clocked after the last command of core 0 until its digest is out, with DIGEST or READ */
+#define FPGA_TAIL_MAX (FPGA_GAP_MAX + CRYPT_FPGA_READ_LEN + CRYPT_FPGA_READ_DELAY + CRYPT_FPGA_RESP_LEN + CRYPT_FPGA_CRC_LEN)
+/* READ and its response in CRC mode */
+#define FPGA_READ_CRC_LEN (CRYPT_FPGA_READ_LEN + CRYPT_FPGA_READ_DELAY + CRYPT_FPGA_RESP_LEN + CRYPT_FPGA_CRC_LEN)
+/* RESULT and its response in CRC mode */
+#define FPGA_RESULT_CRC_LEN (CRYPT_FPGA_RESULT_LEN + CRYPT_FPGA_READ_DELAY + CRYPT_FPGA_RESULT_RESP_LEN + CRYPT_FPGA_CRC_LEN)
+/* STATS and its response in CRC mode */
+#define FPGA_STATS_CRC_LEN (CRYPT_FPGA_STATS_LEN + CRYPT_FPGA_READ_DELAY + CRYPT_FPGA_STATS_RESP_LEN + CRYPT_FPGA_CRC_LEN)
+/* Nonces tried by a SEARCH command, so that its result is polled for a bounded time (about 0.3 s at 4 cores) */
+#define FPGA_SEARCH_CHUNK (1 << 20)
+/* Times corrupted requests (or transactions) are sent again in CRC mode before the link is given up */
+#define FPGA_RETRIES 8
+/* SYNC bytes before a retry, that end any command a corrupted byte may have started (SEARCH and its CRC at most), some */
+/* more that arm bit realignment, NOPs that realign bytes in case the error was a stray SCLK edge, and CRC that clears */
+/* what a failed transaction left in the status byte */
+#define FPGA_SYNC_ONES (CRYPT_FPGA_SEARCH_LEN + CRYPT_FPGA_CRC_LEN + 4)
+#define FPGA_SYNC_NOPS 2
+#define FPGA_SYNC_LEN (FPGA_SYNC_ONES + FPGA_SYNC_NOPS + CRYPT_FPGA_CRC_CMD_LEN)
+/* SPI clocks tried by crypt_fpga_calibrate(), slowest first (BCM2835 core clock of 250 MHz over even dividers) */
+static const uint32_t fpga_clocks[] = {1953125, 3906250, 7812500, 10416666, 12500000, 15625000, 20833333, 25000000, 31250000, 41666666, 62500000};
+#define FPGA_CLOCKS (sizeof(fpga_clocks) / sizeof(fpga_clocks[0]))
+/* Passes of crypt_fpga_check() a clock must survive during calibration */
+#define FPGA_CHECK_ROUNDS 4
+/* 32-byte requests of the batch check */
+#define FPGA_CHECK_BATCH 64
+/* SYNC bytes that end any command a failing clock (or a stray SCLK edge) may have left half-received: a full BATCH */
+/* with CRCs, and then as many as before a retry */
+#define FPGA_RESYNC_LEN (CRYPT_FPGA_BATCH_LEN + CRYPT_FPGA_CRC_LEN + (255 * (32 + CRYPT_FPGA_CRC_LEN)) + FPGA_SYNC_ONES)
+/* Bytes sent in a single transfer while resynchronising (spidev default buffer size) */
+#define FPGA_RESYNC_CHUNK 4096
+
+/**
+ * @brief Tagged responses being received.
+ */
+typedef struct {
+	/* Request of each tag (number of requests if unused) */
+	unsigned int tagRecords[CRYPT_FPGA_TAGS];
+	/* Request and bytes left of the response being received */
+	unsigned int record;
+	unsigned int left;
+	/* Responses started (in CRC mode, only those received with a good CRC) and fully received */
+	unsigned int started;
+	unsigned int received;
+	/* CRC mode: response being received (signed ones are the largest), checked once complete, and requests with a */
+	/* good response */
+	uint8_t frame[CRYPT_FPGA_SIGN_RESP_LEN + CRYPT_FPGA_CRC_LEN];
+	bool done[CRYPT_FPGA_TAGS];
+} fpga_responses_t;
+
+/**
+ * @brief Known-answer vector.
+ */
+typedef struct {
+	const char *message;
+	unsigned int len;
+	uint8_t digest[32];
+} fpga_vector_t;
+
+/* FIPS 180-2 vectors (multi-block path) and a 32-byte message (SHORT path) */
+static const fpga_vector_t fpga_vectors[] = {
+	{"", 0, {
+		0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+		0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55
+	}},
+	{"abc", 3, {
+		0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+	}},
+	{"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56, {
+		0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+		0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1
+	}},
+	{"abcdefghijklmnopqrstuvwxyz012345", 32, {
+		0x65, 0x3b, 0xb1, 0x24, 0x5e, 0x82, 0x8f, 0xcd, 0xa4, 0xfa, 0x53, 0xfc, 0xd5, 0xa3, 0xde, 0xf5,
+		0xbd, 0x76, 0x54, 0xe6, 0x51, 0xf5, 0x4b, 0x41, 0x32, 0xb7, 0x3d, 0x74, 0xe6, 0x44, 0x35, 0xc4
+	}}
+};
+#define FPGA_VECTORS (sizeof(fpga_vectors) / sizeof(fpga_vectors[0]))
+
+/**
+ * @brief SPI transfer through the backend transfer function, accounted in the context bus statistics.
+ */
+int crypt_fpga_transfer(crypt_context_t *context, uint8_t *writeData, uint8_t *readData, unsigned int len) {
+	int rv = context->backend->transfer(context, writeData, readData, len);
+
+	if(CRYPT_OK == rv) {
+		context->busStats.transfers++;
+		context->busStats.sclkCycles += (8 * len) / (context->busLanes * (context->busDdr? 2 : 1));
+	}
+
+	return rv;
+}
+
+/**
+ * @brief CRC-16 of the FPGA protocol, as sent after frames in CRC mode.
+ */
+uint16_t crypt_fpga_crc(uint16_t crc, const uint8_t *data, unsigned int len) {
+	unsigned int i, j;
+
+	for(i = 0; i < len; i++) {
+		crc ^= data[i] << 8;
+		for(j = 0; j < 8; j++)
+			crc = (crc & 0x8000)? ((crc << 1) ^ CRYPT_FPGA_CRC_POLY) : (crc << 1);
+	}
+
+	return crc;
+}
+
+/**
+ * @brief True if CRC-protected frames are in use: requested, and the FPGA has them (along with BATCH and READ).
+ */
+static bool fpga_crc_on(crypt_context_t *context) {
+	return context->busCrc && (context->deviceFeatures & CRYPT_FPGA_FEATURE_CRC);
+}
+
+/**
+ * @brief Append the CRC of a frame in CRC mode. Returns the frame size.
+ */
+static unsigned int fpga_seal(crypt_context_t *context, uint8_t *frame, unsigned int len) {
+	uint16_t crc;
+
+	if(fpga_crc_on(context)) {
+		crc = crypt_fpga_crc(CRYPT_FPGA_CRC_INIT, frame, len);
+		frame[len] = crc >> 8;
+		frame[len + 1] = crc;
+		len += CRYPT_FPGA_CRC_LEN;
+	}
+
+	return len;
+}
+
+/**
+ * @brief Put the SYNC bytes and NOPs that go before a retry, ended by CRC (CRC mode kept on) if @p reset is set, so
+ *        that the status byte counts the commands of the retry alone. Returns their number.
+ */
+static unsigned int fpga_sync(crypt_context_t *context, uint8_t *writeData, bool reset) {
+	uint8_t *command = &writeData[FPGA_SYNC_LEN - CRYPT_FPGA_CRC_CMD_LEN];
+
+	memset(writeData, CRYPT_FPGA_CMD_SYNC, FPGA_SYNC_ONES);
+	memset(&writeData[FPGA_SYNC_ONES], 0, FPGA_SYNC_LEN - FPGA_SYNC_ONES);
+	if(reset) {
+		command[0] = CRYPT_FPGA_CMD_CRC;
+		command[1] = CRYPT_FPGA_CRC_MODE_ON;
+		fpga_seal(context, command, CRYPT_FPGA_CRC_CMD_LEN - CRYPT_FPGA_CRC_LEN);
+		context->busCount = 0;
+	}
+
+	return FPGA_SYNC_LEN;
+}
+
+/**
+ * @brief Check a READ (or RESULT) response of @p len bytes in CRC mode (status byte, digest, and CRC). False if it is
+ *        corrupted, if a command failed its CRC or if the FPGA did not take the @p taken commands sent since the last
+ *        good READ, either one counted in the bus statistics.
+ */
+static bool fpga_read_ok(crypt_context_t *context, const uint8_t *response, unsigned int len, unsigned int taken) {
+	unsigned int count = (context->busCount + taken) % 4;
+
+	if(crypt_fpga_crc(CRYPT_FPGA_CRC_INIT, response, len + CRYPT_FPGA_CRC_LEN)) {
+		context->busStats.crcErrors++;
+		return false;
+	}
+
+	/* A command byte corrupted into a NOP drops its command with no CRC error, but shows in the count */
+	if((response[0] & CRYPT_FPGA_STATUS_ERROR) || (((response[0] & CRYPT_FPGA_STATUS_COUNT) >> CRYPT_FPGA_STATUS_COUNT_SHIFT) != count)) {
+		context->busStats.frameErrors++;
+		return false;
+	}
+
+	context->busCount = count;
+	return true;
+}
+
+/**
+ * @brief True if all bytes are idle status bytes (no request in the FPGA, no response waiting).
+ */
+static bool fpga_idle(const uint8_t *readData, unsigned int len) {
+	unsigned int i;
+	uint8_t mask = ~(CRYPT_FPGA_STATUS_DONE | CRYPT_FPGA_STATUS_ERROR | CRYPT_FPGA_STATUS_COUNT);
+
+	for(i = 0; (i < len) && ((readData[i] & mask) == (CRYPT_FPGA_STATUS_FLAG | CRYPT_FPGA_STATUS_IDLE)); i++);
+
+	return i == len;
+}
+
+/**
+ * @brief In CRC mode, find out whether requests were lost after NOPs that ended with idle status bytes (what comes
+ *        before may be the output of a command made up by corrupted bytes): READ then confirms (with a CRC) that no
+ *        request is left in the FPGA, and takes MISO over from any response being sent. If @p stalled is set, READ
+ *        goes after SYNC bytes whatever the status bytes, as none come through once a stray SCLK edge shifted bytes.
+ */
+static int fpga_lost(crypt_context_t *context, const uint8_t *readData, unsigned int len, bool stalled, bool *lost) {
+	int rv = CRYPT_OK;
+	unsigned int tries, readLen;
+	uint8_t writeRead[FPGA_SYNC_LEN + FPGA_READ_CRC_LEN];
+	uint8_t readRead[FPGA_SYNC_LEN + FPGA_READ_CRC_LEN];
+	const uint8_t *response;
+
+	*lost = false;
+
+	/* READ is repeated until its response gets through */
+	for(tries = stalled? 1 : 0; stalled || fpga_idle(&readData[len - CRYPT_FPGA_DELAY], CRYPT_FPGA_DELAY); tries++) {
+		readLen = tries? fpga_sync(context, writeRead, false) : 0;
+		memset(&writeRead[readLen], 0, FPGA_READ_CRC_LEN);
+		writeRead[readLen] = CRYPT_FPGA_CMD_READ;
+		readLen += FPGA_READ_CRC_LEN;
+		ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeRead, readRead, readLen), rv, CRYPT_FAILED, "fpga_lost: SPI transfer failed.\n");
+
+		response = &readRead[readLen - CRYPT_FPGA_RESP_LEN - CRYPT_FPGA_CRC_LEN];
+		if(!crypt_fpga_crc(CRYPT_FPGA_CRC_INIT, response, CRYPT_FPGA_RESP_LEN + CRYPT_FPGA_CRC_LEN)) {
+			context->busCount = (response[0] & CRYPT_FPGA_STATUS_COUNT) >> CRYPT_FPGA_STATUS_COUNT_SHIFT;
+			*lost = response[0] & CRYPT_FPGA_STATUS_IDLE;
+			break;
+		}
+
+		context->busStats.crcErrors++;
+		ASSERT(tries < FPGA_RETRIES, rv, CRYPT_FAILED, "fpga_lost: Too many link errors.\n");
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Send a command with no response. In CRC mode, READ follows it in the same transfer, and the command is sent
+ *        again until the FPGA takes it (CRC clears the count rather than adding to it).
+ */
+static int fpga_command(crypt_context_t *context, const uint8_t *command, unsigned int len) {
+	int rv = CRYPT_OK;
+	unsigned int tries, frameLen;
+	bool crc = fpga_crc_on(context);
+	uint8_t writeData[FPGA_SYNC_LEN + CRYPT_FPGA_HKEY_LEN + CRYPT_FPGA_CRC_LEN + FPGA_READ_CRC_LEN];
+	uint8_t readData[FPGA_SYNC_LEN + CRYPT_FPGA_HKEY_LEN + CRYPT_FPGA_CRC_LEN + FPGA_READ_CRC_LEN];
+	bool reset = (CRYPT_FPGA_CMD_CRC == command[0]);
+
+	for(tries = 0; ; tries++) {
+		frameLen = tries? fpga_sync(context, writeData, true) : 0;
+		if(reset)
+			context->busCount = 0;
+		memcpy(&writeData[frameLen], command, len);
+		frameLen += len;
+		if(crc) {
+			memset(&writeData[frameLen], 0, FPGA_READ_CRC_LEN);
+			writeData[frameLen] = CRYPT_FPGA_CMD_READ;
+			frameLen += FPGA_READ_CRC_LEN;
+		}
+
+		ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, frameLen), rv, CRYPT_FAILED, "fpga_command: SPI transfer failed.\n");
+		if(!crc || fpga_read_ok(context, &readData[frameLen - CRYPT_FPGA_RESP_LEN - CRYPT_FPGA_CRC_LEN], CRYPT_FPGA_RESP_LEN, reset? 0 : 1))
+			break;
+
+		ASSERT(tries < FPGA_RETRIES, rv, CRYPT_FAILED, "fpga_command: Too many link errors.\n");
+		context->busStats.retries++;
+	}
+
+	memset(writeData, 0, sizeof(writeData));
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Append the bytes that get the digest of core 0 out after its last command: READ after some NOPs if the FPGA
+ *        has it, DIGEST (unless the last command was SHORT) and NOPs otherwise. Returns the number of bytes appended.
+ */
+static unsigned int fpga_tail(crypt_context_t *context, uint8_t *writeData, bool isShort) {
+	unsigned int len;
+
+	if(context->deviceFeatures & CRYPT_FPGA_FEATURE_STATUS) {
+		len = context->readGap + CRYPT_FPGA_READ_LEN + CRYPT_FPGA_READ_DELAY + CRYPT_FPGA_RESP_LEN + (fpga_crc_on(context)? CRYPT_FPGA_CRC_LEN : 0);
+		memset(writeData, 0, len);
+		writeData[context->readGap] = CRYPT_FPGA_CMD_READ;
+	}
+	else {
+		len = (isShort? 0 : CRYPT_FPGA_DIGEST_LEN) + CRYPT_FPGA_TAIL_LEN;
+		memset(writeData, 0, len);
+		if(!isShort)
+			writeData[0] = CRYPT_FPGA_CMD_DIGEST;
+	}
+
+	return len;
+}
+
+/**
+ * @brief Get the digest of core 0 from a transfer ended by fpga_tail(). A READ that came too early (status not done)
+ *        is repeated once the FPGA signals completion, and later ones are sent after more NOPs. In CRC mode, @p good
+ *        is cleared if a response was corrupted or one of the @p taken commands before READ dropped, and the whole
+ *        transaction must be sent again.
+ */
+static int fpga_tail_digest(crypt_context_t *context, const uint8_t *readData, unsigned int len, unsigned int taken, char *digest, bool *good) {
+	int rv = CRYPT_OK;
+	unsigned int idle = 0;
+	bool crc = fpga_crc_on(context);
+	unsigned int respLen = CRYPT_FPGA_RESP_LEN + (crc? CRYPT_FPGA_CRC_LEN : 0);
+	uint8_t writeRead[FPGA_READ_CRC_LEN];
+	uint8_t readRead[FPGA_READ_CRC_LEN];
+
+	*good = true;
+
+	if(context->deviceFeatures & CRYPT_FPGA_FEATURE_STATUS) {
+		*good = !crc || fpga_read_ok(context, &readData[len - respLen], CRYPT_FPGA_RESP_LEN, taken);
+		while(*good && !(readData[len - respLen] & CRYPT_FPGA_STATUS_DONE)) {
+			ASSERT(++idle <= FPGA_IDLE_MAX, rv, CRYPT_FAILED, "fpga_tail_digest: FPGA is not responding.\n");
+			if(context->readGap < FPGA_GAP_MAX)
+				context->readGap++;
+
+			if(context->backend->waitIrq) {
+				ASSERT(CRYPT_OK == context->backend->waitIrq(context), rv, CRYPT_FAILED, "fpga_tail_digest: Could not wait for FPGA.\n");
+			}
+
+			len = CRYPT_FPGA_READ_LEN + CRYPT_FPGA_READ_DELAY + respLen;
+			memset(writeRead, 0, len);
+			writeRead[0] = CRYPT_FPGA_CMD_READ;
+			ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeRead, readRead, len), rv, CRYPT_FAILED, "fpga_tail_digest: SPI transfer failed.\n");
+			readData = readRead;
+			*good = !crc || fpga_read_ok(context, &readData[len - respLen], CRYPT_FPGA_RESP_LEN, 0);
+		}
+	}
+
+	if(*good)
+		memcpy(digest, &readData[len - respLen + 1], 32);
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest a buffer using the FPGA attached to the backend transfer function.
+ */
+int crypt_fpga_digest(crypt_context_t *context, char *inBuffer, int inBufferLen, char *digest) {
+	int rv = CRYPT_OK;
+	unsigned int len, tries;
+	bool good = false;
+	uint8_t writeData[FPGA_SYNC_LEN + CRYPT_FPGA_SHORT_LEN + CRYPT_FPGA_CRC_LEN + FPGA_TAIL_MAX];
+	uint8_t readData[FPGA_SYNC_LEN + CRYPT_FPGA_SHORT_LEN + CRYPT_FPGA_CRC_LEN + FPGA_TAIL_MAX];
+	crypt_digest_state_t state;
+
+	/* 32-byte buffers (the readings) fit in a SHORT command, padded by the FPGA */
+	if(inBufferLen != 32) {
+		ASSERT(CRYPT_OK == crypt_digest_init(context, &state), rv, CRYPT_FAILED, "crypt_fpga_digest: Could not start digest.\n");
+		ASSERT(CRYPT_OK == crypt_digest_update(context, &state, inBuffer, inBufferLen), rv, CRYPT_FAILED, "crypt_fpga_digest: Could not update digest.\n");
+		ASSERT(CRYPT_OK == crypt_digest_final(context, &state, digest), rv, CRYPT_FAILED, "crypt_fpga_digest: Could not finish digest.\n");
+	}
+	else {
+		ASSERT(crypt_fpga_cores(context) != CRYPT_FAILED, rv, CRYPT_FAILED, "crypt_fpga_digest: Could not query FPGA.\n");
+
+		/* Command; 32 bytes of data; NOPs until digest is out. Sent again in CRC mode until it gets through */
+		for(tries = 0; !good; tries++) {
+			ASSERT(tries <= FPGA_RETRIES, rv, CRYPT_FAILED, "crypt_fpga_digest: Too many link errors.\n");
+			if(tries)
+				context->busStats.retries++;
+
+			len = tries? fpga_sync(context, writeData, true) : 0;
+			writeData[len] = CRYPT_FPGA_CMD_SHORT;
+			memcpy(&writeData[len + 1], inBuffer, 32);
+			len += fpga_seal(context, &writeData[len], CRYPT_FPGA_SHORT_LEN);
+			len += fpga_tail(context, &writeData[len], true);
+			ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, len), rv, CRYPT_FAILED, "crypt_fpga_digest: SPI transfer failed.\n");
+			ASSERT(CRYPT_OK == fpga_tail_digest(context, readData, len, 1, digest, &good), rv, CRYPT_FAILED, "crypt_fpga_digest: Could not read digest.\n");
+		}
+
+		context->busStats.digests++;
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest a run of 32-byte buffers with SHORT commands back to back, on a single core.
+ */
+static int fpga_batch_short(crypt_context_t *context, char **inBuffers, unsigned int n, char **digests) {
+	int rv = CRYPT_OK;
+	unsigned int i, j, chunk;
+	uint8_t writeData[(FPGA_SHORTS * CRYPT_FPGA_SHORT_LEN) + CRYPT_FPGA_TAIL_LEN];
+	uint8_t readData[(FPGA_SHORTS * CRYPT_FPGA_SHORT_LEN) + CRYPT_FPGA_TAIL_LEN];
+
+	for(i = 0; i < n; i += chunk) {
+		/* Each digest comes out while the following command goes in */
+		for(chunk = 0; (chunk < FPGA_SHORTS) && ((i + chunk) < n); chunk++) {
+			writeData[chunk * CRYPT_FPGA_SHORT_LEN] = CRYPT_FPGA_CMD_SHORT;
+			memcpy(&writeData[(chunk * CRYPT_FPGA_SHORT_LEN) + 1], inBuffers[i + chunk], 32);
+		}
+		memset(&writeData[chunk * CRYPT_FPGA_SHORT_LEN], 0, CRYPT_FPGA_TAIL_LEN);
+
+		ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, (chunk * CRYPT_FPGA_SHORT_LEN) + CRYPT_FPGA_TAIL_LEN), rv, CRYPT_FAILED, "fpga_batch_short: SPI transfer failed.\n");
+
+		for(j = 0; j < chunk; j++)
+			memcpy(digests[i + j], &readData[((j + 1) * CRYPT_FPGA_SHORT_LEN) + CRYPT_FPGA_DELAY], 32);
+		context->busStats.digests += chunk;
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Start receiving tagged responses of n requests.
+ */
+static void fpga_responses_init(fpga_responses_t *resp, unsigned int n) {
+	unsigned int i;
+
+	for(i = 0; i < CRYPT_FPGA_TAGS; i++) {
+		resp->tagRecords[i] = n;
+		resp->done[i] = false;
+	}
+	resp->record = 0;
+	resp->left = 0;
+	resp->started = 0;
+	resp->received = 0;
+}
+
+/**
+ * @brief Pick tagged responses from data received. Responses come in any order and may be split across transfers.
+ *        MISO carries status bytes between them. In CRC mode, responses are checked once complete, and corrupted
+ *        ones are dropped (their requests are sent again once the FPGA is idle, see fpga_lost()). Responses to SIGN
+ *        carry the signature after the digest, kept in @p signatures (NULL for other requests).
+ */
+static int fpga_responses_parse(crypt_context_t *context, fpga_responses_t *resp, const uint8_t *readData, unsigned int len, unsigned int n, char **digests, char **signatures) {
+	int rv = CRYPT_OK;
+	unsigned int i, byte;
+	bool crc = fpga_crc_on(context);
+	unsigned int payload = signatures? 64 : 32;
+	unsigned int frameLen = 1 + payload + CRYPT_FPGA_CRC_LEN;
+
+	for(i = 0; i < len; i++) {
+		if(resp->left && crc) {
+			resp->frame[frameLen - resp->left] = readData[i];
+			if(--(resp->left))
+				continue;
+
+			/* A stray tag is taken as a link error too: misframed bytes may pass for a request, now and then */
+			resp->record = resp->tagRecords[resp->frame[0] & ~CRYPT_FPGA_RESP_FLAG];
+			if(crypt_fpga_crc(CRYPT_FPGA_CRC_INIT, resp->frame, frameLen) || (resp->record >= n)) {
+				context->busStats.crcErrors++;
+				continue;
+			}
+
+			if(!(resp->done[resp->record])) {
+				memcpy(digests[resp->record], &(resp->frame[1]), 32);
+				if(signatures)
+					memcpy(signatures[resp->record], &(resp->frame[33]), 32);
+				resp->done[resp->record] = true;
+				resp->started++;
+				resp->received++;
+			}
+		}
+		else if(resp->left) {
+			byte = payload - resp->left;
+			if(byte < 32)
+				digests[resp->record][byte] = readData[i];
+			else
+				signatures[resp->record][byte - 32] = readData[i];
+			if(!(--(resp->left)))
+				resp->received++;
+		}
+		else if((readData[i] & CRYPT_FPGA_RESP_FLAG) && crc) {
+			resp->frame[0] = readData[i];
+			resp->left = frameLen - 1;
+		}
+		else if(readData[i] & CRYPT_FPGA_RESP_FLAG) {
+			resp->record = resp->tagRecords[readData[i] & ~CRYPT_FPGA_RESP_FLAG];
+			ASSERT(resp->record < n, rv, CRYPT_FAILED, "fpga_responses_parse: Unexpected response tag.\n");
+			resp->left = payload;
+			resp->started++;
+		}
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest a run of 32-byte buffers with TSHORT (or THMAC) commands, keeping one request in flight per core.
+ */
+static int fpga_batch_tagged(crypt_context_t *context, uint8_t cmd, char **inBuffers, unsigned int n, char **digests, unsigned int cores) {
+	int rv = CRYPT_OK;
+	unsigned int i, len, progress, window;
+	unsigned int next, sent, idle, rounds;
+	bool crc = fpga_crc_on(context);
+	bool nops, stalled, realigned, lost = false;
+	fpga_responses_t resp;
+	uint8_t writeData[FPGA_SYNC_LEN + (FPGA_SHORTS * (CRYPT_FPGA_TSHORT_LEN + CRYPT_FPGA_CRC_LEN)) + CRYPT_FPGA_DELAY + CRYPT_FPGA_RESP_LEN + CRYPT_FPGA_CRC_LEN];
+	uint8_t readData[FPGA_SYNC_LEN + (FPGA_SHORTS * (CRYPT_FPGA_TSHORT_LEN + CRYPT_FPGA_CRC_LEN)) + CRYPT_FPGA_DELAY + CRYPT_FPGA_RESP_LEN + CRYPT_FPGA_CRC_LEN];
+
+	/* In CRC mode, requests go in windows of distinct tags, so that lost ones may be told apart and sent again */
+	for(i = 0; i < n; i += window) {
+		window = n - i;
+		if(crc && (window > CRYPT_FPGA_TAGS))
+			window = CRYPT_FPGA_TAGS;
+
+		fpga_responses_init(&resp, window);
+		next = 0;
+		sent = 0;
+		idle = 0;
+		rounds = 0;
+		realigned = false;
+
+		while(resp.received < window) {
+			/* A request for each free core. FPGA frees a core as its response starts, so headers are counted. Tags */
+			/* are recycled, as there are fewer cores than tags. Lost requests are sent again after NOPs */
+			len = lost? fpga_sync(context, writeData, false) : 0;
+			lost = false;
+			for(; ((sent - resp.started) < cores) && (next < window) && (len < (FPGA_SHORTS * CRYPT_FPGA_TSHORT_LEN)); next++) {
+				if(resp.done[next])
+					continue;
+
+				writeData[len] = cmd;
+				writeData[len + 1] = next % CRYPT_FPGA_TAGS;
+				memcpy(&writeData[len + 2], inBuffers[i + next], 32);
+				resp.tagRecords[next % CRYPT_FPGA_TAGS] = next;
+				len += fpga_seal(context, &writeData[len], CRYPT_FPGA_TSHORT_LEN);
+				sent++;
+			}
+
+			/* All cores busy or nothing left to send: clock NOPs until a response is out, once the FPGA signals it */
+			/* if none is being received */
+			nops = !len;
+			if(nops) {
+				if(context->backend->waitIrq && !(resp.left)) {
+					ASSERT(CRYPT_OK == context->backend->waitIrq(context), rv, CRYPT_FAILED, "fpga_batch_tagged: Could not wait for FPGA.\n");
+				}
+				len = CRYPT_FPGA_DELAY + CRYPT_FPGA_RESP_LEN + (crc? CRYPT_FPGA_CRC_LEN : 0);
+				memset(writeData, 0, len);
+				ASSERT(++idle <= FPGA_IDLE_MAX, rv, CRYPT_FAILED, "fpga_batch_tagged: FPGA is not responding.\n");
+			}
+
+			ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, len), rv, CRYPT_FAILED, "fpga_batch_tagged: SPI transfer failed.\n");
+
+			progress = resp.started + resp.received;
+			ASSERT(CRYPT_OK == fpga_responses_parse(context, &resp, readData, len, window, &digests[i], NULL), rv, CRYPT_FAILED, "fpga_batch_tagged: Could not receive responses.\n");
+			if((resp.started + resp.received) != progress)
+				idle = 0;
+
+			/* Requests the FPGA dropped, or whose responses were corrupted, are sent again once it is idle. A */
+			/* response being received then was started by a corrupted status byte. With no status byte at all, */
+			/* bytes are realigned once before the FPGA is given up */
+			if(crc && nops && (resp.received < window)) {
+				stalled = (FPGA_IDLE_MAX == idle) && !realigned;
+				ASSERT(CRYPT_OK == fpga_lost(context, readData, len, stalled, &lost), rv, CRYPT_FAILED, "fpga_batch_tagged: Could not read status.\n");
+				if(stalled) {
+					realigned = true;
+					idle = 0;
+				}
+				if(lost) {
+					ASSERT(++rounds <= FPGA_RETRIES, rv, CRYPT_FAILED, "fpga_batch_tagged: Too many link errors.\n");
+					context->busStats.retries += sent - resp.started;
+					sent = resp.started;
+					next = 0;
+					idle = 0;
+					resp.left = 0;
+				}
+			}
+		}
+
+		context->busStats.digests += window;
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest a run of 32-byte buffers with BATCH frames, each one in a single transfer along with its responses.
+ *        @p flags go in the first tag (CRYPT_FPGA_BATCH_DOUBLE for SHA-256d). With @p signatures, SIGN frames are
+ *        sent instead, and signatures come back along with the digests.
+ */
+static int fpga_batch_frames(crypt_context_t *context, uint8_t flags, char **inBuffers, unsigned int n, char **digests, char **signatures) {
+	int rv = CRYPT_OK;
+	unsigned int i, j, len, progress, chunk, tags, rounds, tail;
+	unsigned int idle;
+	bool crc = fpga_crc_on(context);
+	bool stalled, realigned, lost;
+	unsigned int respLen = (signatures? CRYPT_FPGA_SIGN_RESP_LEN : CRYPT_FPGA_RESP_LEN) + (crc? CRYPT_FPGA_CRC_LEN : 0);
+	fpga_responses_t resp;
+	uint8_t *frame;
+	uint8_t writeData[FPGA_SYNC_LEN + CRYPT_FPGA_BATCH_LEN + (FPGA_FRAME * 32) + FPGA_FRAME_TAIL(FPGA_FRAME, CRYPT_FPGA_RESP_LEN)];
+	uint8_t readData[FPGA_SYNC_LEN + CRYPT_FPGA_BATCH_LEN + (FPGA_FRAME * 32) + FPGA_FRAME_TAIL(FPGA_FRAME, CRYPT_FPGA_RESP_LEN)];
+
+	/* FIFO fills by about one entry every 32 within a transfer, so that small FIFOs take shorter frames */
+	for(i = 0; i < n; i += chunk) {
+		chunk = n - i;
+		if(chunk > (crc? FPGA_FRAME_CRC : FPGA_FRAME))
+			chunk = crc? FPGA_FRAME_CRC : FPGA_FRAME;
+		if(chunk > (16 * context->deviceFifo))
+			chunk = 16 * context->deviceFifo;
+		if(signatures && (chunk > FPGA_SIGN_FRAME))
+			chunk = FPGA_SIGN_FRAME;
+		if(signatures && (chunk > context->deviceFifo))
+			chunk = context->deviceFifo;
+
+		/* In CRC mode, requests that did not make it are sent again in another frame, once the FPGA is idle */
+		fpga_responses_init(&resp, chunk);
+		for(rounds = 0; resp.received < chunk; rounds++) {
+			ASSERT(rounds <= FPGA_RETRIES, rv, CRYPT_FAILED, "fpga_batch_frames: Too many link errors.\n");
+			if(rounds)
+				context->busStats.retries += chunk - resp.received;
+
+			/* Header, data with no framing and NOPs while the last responses are sent. Tags start from 0, as all */
+			/* responses of the previous frame are in */
+			len = rounds? fpga_sync(context, writeData, false) : 0;
+			frame = &writeData[len];
+			len += CRYPT_FPGA_BATCH_LEN + (crc? CRYPT_FPGA_CRC_LEN : 0);
+			for(j = 0, tags = 0; j < chunk; j++) {
+				if(resp.done[j])
+					continue;
+
+				memcpy(&writeData[len], inBuffers[i + j], 32);
+				len += fpga_seal(context, &writeData[len], 32);
+				resp.tagRecords[tags++] = j;
+			}
+			frame[0] = signatures? CRYPT_FPGA_CMD_SIGN : CRYPT_FPGA_CMD_BATCH;
+			frame[1] = flags;
+			frame[2] = tags;
+			fpga_seal(context, frame, CRYPT_FPGA_BATCH_LEN);
+			tail = signatures? FPGA_SIGN_TAIL(tags, respLen) : FPGA_FRAME_TAIL(tags, respLen);
+			memset(&writeData[len], 0, tail);
+			len += tail;
+
+			ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, len), rv, CRYPT_FAILED, "fpga_batch_frames: SPI transfer failed.\n");
+			ASSERT(CRYPT_OK == fpga_responses_parse(context, &resp, readData, len, chunk, &digests[i], signatures? &signatures[i] : NULL), rv, CRYPT_FAILED, "fpga_batch_frames: Could not receive responses.\n");
+
+			/* Responses left out of the frame, if any, are clocked out with NOPs */
+			memset(writeData, 0, CRYPT_FPGA_DELAY + respLen);
+			idle = 0;
+			realigned = false;
+			lost = false;
+			while((resp.received < chunk) && !lost) {
+				ASSERT(++idle <= FPGA_IDLE_MAX, rv, CRYPT_FAILED, "fpga_batch_frames: FPGA is not responding.\n");
+				if(context->backend->waitIrq && !(resp.left)) {
+					ASSERT(CRYPT_OK == context->backend->waitIrq(context), rv, CRYPT_FAILED, "fpga_batch_frames: Could not wait for FPGA.\n");
+				}
+				ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, CRYPT_FPGA_DELAY + respLen), rv, CRYPT_FAILED, "fpga_batch_frames: SPI transfer failed.\n");
+
+				progress = resp.started + resp.received;
+				ASSERT(CRYPT_OK == fpga_responses_parse(context, &resp, readData, CRYPT_FPGA_DELAY + respLen, chunk, &digests[i], signatures? &signatures[i] : NULL), rv, CRYPT_FAILED, "fpga_batch_frames: Could not receive responses.\n");
+				if((resp.started + resp.received) != progress)
+					idle = 0;
+
+				if(crc && (resp.received < chunk)) {
+					stalled = (FPGA_IDLE_MAX == idle) && !realigned;
+					ASSERT(CRYPT_OK == fpga_lost(context, readData, CRYPT_FPGA_DELAY + respLen, stalled, &lost), rv, CRYPT_FAILED, "fpga_batch_frames: Could not read status.\n");
+					if(stalled) {
+						realigned = true;
+						idle = 0;
+					}
+					if(lost)
+						resp.left = 0;
+				}
+			}
+		}
+
+		context->busStats.digests += chunk;
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Get number of SHA-256 cores of the FPGA attached to the backend transfer function.
+ */
+int crypt_fpga_cores(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+	uint16_t crc;
+	uint8_t *info;
+	uint8_t writeData[CRYPT_FPGA_INFO_LEN + CRYPT_FPGA_TAIL_LEN + CRYPT_FPGA_CRC_LEN];
+	uint8_t readData[CRYPT_FPGA_INFO_LEN + CRYPT_FPGA_TAIL_LEN + CRYPT_FPGA_CRC_LEN];
+
+	if(!(context->deviceCores)) {
+		memset(writeData, 0, sizeof(writeData));
+		writeData[0] = CRYPT_FPGA_CMD_INFO;
+		ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, sizeof(writeData)), rv, CRYPT_FAILED, "crypt_fpga_cores: SPI transfer failed.\n");
+
+		/* Bitstreams with no INFO command send zeroes back. Response ends with a CRC if the FPGA was left in CRC mode */
+		info = &readData[CRYPT_FPGA_INFO_LEN + CRYPT_FPGA_DELAY];
+		context->deviceFeatures = info[1];
+		context->deviceFifo = info[2];
+
+		/* CRC mode is set either way, as a previous context may have left it on. CRC commands always carry a CRC */
+		if(context->deviceFeatures & CRYPT_FPGA_FEATURE_CRC) {
+			writeData[0] = CRYPT_FPGA_CMD_CRC;
+			writeData[1] = context->busCrc? CRYPT_FPGA_CRC_MODE_ON : 0;
+			crc = crypt_fpga_crc(CRYPT_FPGA_CRC_INIT, writeData, CRYPT_FPGA_CRC_CMD_LEN - CRYPT_FPGA_CRC_LEN);
+			writeData[2] = crc >> 8;
+			writeData[3] = crc;
+			ASSERT(CRYPT_OK == fpga_command(context, writeData, CRYPT_FPGA_CRC_CMD_LEN), rv, CRYPT_FAILED, "crypt_fpga_cores: Could not set CRC mode.\n");
+		}
+
+		context->deviceCores = info[0]? info[0] : 1;
+	}
+
+	rv = context->deviceCores;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Big endian counter of a STATS response.
+ */
+static uint64_t fpga_counter(const uint8_t *bytes, unsigned int len) {
+	uint64_t value = 0;
+	unsigned int i;
+
+	for(i = 0; i < len; i++)
+		value = (value << 8) | bytes[i];
+
+	return value;
+}
+
+/**
+ * @brief Get the performance counters of the FPGA attached to the backend transfer function.
+ */
+int crypt_fpga_device_stats(crypt_context_t *context, crypt_device_stats_t *stats) {
+	int rv = CRYPT_OK;
+	unsigned int tries, len, respLen;
+	bool good;
+	const uint8_t *counters;
+	uint8_t writeData[FPGA_SYNC_LEN + FPGA_STATS_CRC_LEN];
+	uint8_t readData[FPGA_SYNC_LEN + FPGA_STATS_CRC_LEN];
+
+	memset(stats, 0, sizeof(crypt_device_stats_t));
+	ASSERT(crypt_fpga_cores(context) != CRYPT_FAILED, rv, CRYPT_FAILED, "crypt_fpga_device_stats: Could not query FPGA.\n");
+
+	if(context->deviceFeatures & CRYPT_FPGA_FEATURE_STATS) {
+		/* STATS is sent again in CRC mode until its response gets through */
+		respLen = CRYPT_FPGA_STATS_RESP_LEN + (fpga_crc_on(context)? CRYPT_FPGA_CRC_LEN : 0);
+		for(tries = 0, good = false; !good; tries++) {
+			ASSERT(tries <= FPGA_RETRIES, rv, CRYPT_FAILED, "crypt_fpga_device_stats: Too many link errors.\n");
+			if(tries)
+				context->busStats.retries++;
+
+			len = tries? fpga_sync(context, writeData, true) : 0;
+			memset(&writeData[len], 0, CRYPT_FPGA_STATS_LEN + CRYPT_FPGA_READ_DELAY + respLen);
+			writeData[len] = CRYPT_FPGA_CMD_STATS;
+			len += CRYPT_FPGA_STATS_LEN + CRYPT_FPGA_READ_DELAY + respLen;
+			ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, len), rv, CRYPT_FAILED, "crypt_fpga_device_stats: SPI transfer failed.\n");
+			good = !fpga_crc_on(context) || fpga_read_ok(context, &readData[len - respLen], CRYPT_FPGA_STATS_RESP_LEN, 0);
+		}
+
+		counters = &readData[len - respLen + 1];
+		stats->cycles = fpga_counter(&counters[0], 6);
+		stats->busyCycles = fpga_counter(&counters[6], 6);
+		stats->idleCycles = fpga_counter(&counters[12], 6);
+		stats->transactions = fpga_counter(&counters[18], 4);
+		stats->frameErrors = fpga_counter(&counters[22], 4);
+		stats->maxLatency = fpga_counter(&counters[26], 2);
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest several independent buffers using the FPGA attached to the backend transfer function.
+ */
+int crypt_fpga_digest_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests) {
+	int rv = CRYPT_OK;
+	int cores;
+	unsigned int i, run;
+
+	cores = crypt_fpga_cores(context);
+	ASSERT(cores != CRYPT_FAILED, rv, CRYPT_FAILED, "crypt_fpga_digest_batch: Could not query FPGA.\n");
+
+	for(i = 0; i < n; i += run) {
+		/* Other sizes go one by one */
+		if(inBufferLens[i] != 32) {
+			ASSERT(CRYPT_OK == crypt_fpga_digest(context, inBuffers[i], inBufferLens[i], digests[i]), rv, CRYPT_FAILED, "crypt_fpga_digest_batch: Could not digest buffer.\n");
+			run = 1;
+			continue;
+		}
+
+		for(run = 0; ((i + run) < n) && (32 == inBufferLens[i + run]); run++);
+
+		if(context->deviceFeatures & CRYPT_FPGA_FEATURE_BATCH) {
+			ASSERT(CRYPT_OK == fpga_batch_frames(context, 0, &inBuffers[i], run, &digests[i], NULL), rv, CRYPT_FAILED, "crypt_fpga_digest_batch: Could not digest buffers.\n");
+		}
+		else if(cores > 1) {
+			ASSERT(CRYPT_OK == fpga_batch_tagged(context, CRYPT_FPGA_CMD_TSHORT, &inBuffers[i], run, &digests[i], cores), rv, CRYPT_FAILED, "crypt_fpga_digest_batch: Could not digest buffers.\n");
+		}
+		else {
+			ASSERT(CRYPT_OK == fpga_batch_short(context, &inBuffers[i], run, &digests[i]), rv, CRYPT_FAILED, "crypt_fpga_digest_batch: Could not digest buffers.\n");
+		}
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Compress whole blocks of a multi-block digest using the FPGA attached to the backend transfer function.
+ */
+int crypt_fpga_digest_blocks(crypt_context_t *context, crypt_digest_state_t *state, const uint8_t *blocks, unsigned int nBlocks, char *digest) {
+	int rv = CRYPT_OK;
+	unsigned int i, chunk, len, tries, taken;
+	bool crc, first, good;
+	char h[32];
+	uint8_t writeData[FPGA_SYNC_LEN + CRYPT_FPGA_LOAD_LEN + CRYPT_FPGA_CRC_LEN + (FPGA_BLOCKS * (CRYPT_FPGA_BLOCK_LEN + CRYPT_FPGA_CRC_LEN)) + FPGA_TAIL_MAX];
+	uint8_t readData[FPGA_SYNC_LEN + CRYPT_FPGA_LOAD_LEN + CRYPT_FPGA_CRC_LEN + (FPGA_BLOCKS * (CRYPT_FPGA_BLOCK_LEN + CRYPT_FPGA_CRC_LEN)) + FPGA_TAIL_MAX];
+
+	ASSERT(crypt_fpga_cores(context) != CRYPT_FAILED, rv, CRYPT_FAILED, "crypt_fpga_digest_blocks: Could not query FPGA.\n");
+	crc = fpga_crc_on(context);
+
+	do {
+		chunk = (nBlocks < FPGA_BLOCKS)? nBlocks : FPGA_BLOCKS;
+		first = state->first;
+
+		/* In CRC mode, every chunk ends with READ of the hash value, kept in state->h. A chunk that does not get */
+		/* through is sent again, halved (as the link is noisy) and chained to the hash value before it */
+		for(tries = 0; ; tries++) {
+			if(tries && (chunk > 1))
+				chunk /= 2;
+
+			len = tries? fpga_sync(context, writeData, true) : 0;
+			taken = 0;
+			state->first = first;
+
+			/* Midstate set by crypt_digest_resume() goes to the core before the first block */
+			if(state->load || (tries && !first)) {
+				writeData[len] = CRYPT_FPGA_CMD_LOAD;
+				for(i = 0; i < 32; i++)
+					writeData[len + i + 1] = state->h[i / 4] >> (24 - (8 * (i % 4)));
+				len += fpga_seal(context, &writeData[len], CRYPT_FPGA_LOAD_LEN);
+				taken++;
+			}
+
+			/* Core chains blocks by itself, only the first one of a message is flagged */
+			for(i = 0; i < chunk; i++) {
+				writeData[len] = state->first? CRYPT_FPGA_CMD_INIT : CRYPT_FPGA_CMD_NEXT;
+				memcpy(&writeData[len + 1], &blocks[i * 64], 64);
+				len += fpga_seal(context, &writeData[len], CRYPT_FPGA_BLOCK_LEN);
+				state->first = false;
+				taken++;
+			}
+
+			/* Digest is read in the same transfer as the last blocks */
+			if((len || digest) && (crc || ((nBlocks == chunk) && digest)))
+				len += fpga_tail(context, &writeData[len], false);
+
+			if(len) {
+				ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, len), rv, CRYPT_FAILED, "crypt_fpga_digest_blocks: SPI transfer failed.\n");
+			}
+			if(!crc || !len)
+				break;
+
+			ASSERT(CRYPT_OK == fpga_tail_digest(context, readData, len, taken, h, &good), rv, CRYPT_FAILED, "crypt_fpga_digest_blocks: Could not read digest.\n");
+			if(good)
+				break;
+
+			ASSERT(tries < FPGA_RETRIES, rv, CRYPT_FAILED, "crypt_fpga_digest_blocks: Too many link errors.\n");
+			context->busStats.retries++;
+		}
+
+		/* A LOAD with no blocks after it leaves the hash value as it was */
+		if(crc && chunk) {
+			for(i = 0; i < 8; i++)
+				state->h[i] = ((uint8_t) h[4 * i] << 24) | ((uint8_t) h[(4 * i) + 1] << 16) | ((uint8_t) h[(4 * i) + 2] << 8) | (uint8_t) h[(4 * i) + 3];
+		}
+
+		state->load = false;
+		blocks += chunk * 64;
+		nBlocks -= chunk;
+	} while(nBlocks);
+
+	if(digest) {
+		if(crc) {
+			memcpy(digest, h, 32);
+		}
+		else {
+			ASSERT(CRYPT_OK == fpga_tail_digest(context, readData, len, taken, digest, &good), rv, CRYPT_FAILED, "crypt_fpga_digest_blocks: Could not read digest.\n");
+		}
+		context->busStats.digests++;
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief HMAC-SHA256 of several independent buffers using the FPGA attached to the backend transfer function.
+ */
+int crypt_fpga_hmac_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **macs) {
+	int rv = CRYPT_OK;
+	int cores;
+	unsigned int i, run, len;
+	uint8_t writeData[CRYPT_FPGA_HKEY_LEN + CRYPT_FPGA_CRC_LEN];
+
+	cores = crypt_fpga_cores(context);
+	ASSERT(cores != CRYPT_FAILED, rv, CRYPT_FAILED, "crypt_fpga_hmac_batch: Could not query FPGA.\n");
+
+	/* Key midstates stay in the FPGA until the key changes */
+	if((context->deviceFeatures & CRYPT_FPGA_FEATURE_HMAC) && !(context->hmacLoaded)) {
+		writeData[0] = CRYPT_FPGA_CMD_HKEY;
+		memcpy(&writeData[1], context->hmacIpad, 32);
+		memcpy(&writeData[33], context->hmacOpad, 32);
+		len = fpga_seal(context, writeData, CRYPT_FPGA_HKEY_LEN);
+		ASSERT(CRYPT_OK == fpga_command(context, writeData, len), rv, CRYPT_FAILED, "crypt_fpga_hmac_batch: Could not load key midstates.\n");
+		memset(writeData, 0, sizeof(writeData));
+		context->hmacLoaded = true;
+	}
+
+	for(i = 0; i < n; i += run) {
+		/* Other sizes (or bitstreams with no HMAC) go one by one, with the midstates loaded into core 0 */
+		if((inBufferLens[i] != 32) || !(context->deviceFeatures & CRYPT_FPGA_FEATURE_HMAC)) {
+			ASSERT(CRYPT_OK == crypt_hmac_chained(context, inBuffers[i], inBufferLens[i], macs[i]), rv, CRYPT_FAILED, "crypt_fpga_hmac_batch: Could not compute MAC.\n");
+			run = 1;
+			continue;
+		}
+
+		run = 0;
+		while(((i + run) < n) && (32 == inBufferLens[i + run]))
+			run++;
+
+		ASSERT(CRYPT_OK == fpga_batch_tagged(context, CRYPT_FPGA_CMD_THMAC, &inBuffers[i], run, &macs[i], cores), rv, CRYPT_FAILED, "crypt_fpga_hmac_batch: Could not compute MACs.\n");
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief SHA-256d of several independent buffers using the FPGA attached to the backend transfer function.
+ */
+int crypt_fpga_double_batch(crypt_context_t *context, char **inBuffers, int *inBufferLens, unsigned int n, char **digests) {
+	int rv = CRYPT_OK;
+	int cores;
+	unsigned int i, run;
+
+	cores = crypt_fpga_cores(context);
+	ASSERT(cores != CRYPT_FAILED, rv, CRYPT_FAILED, "crypt_fpga_double_batch: Could not query FPGA.\n");
+
+	for(i = 0; i < n; i += run) {
+		/* Other sizes (or bitstreams with no SHA-256d) go one by one, the inner digest coming back to the host */
+		if((inBufferLens[i] != 32) || !(context->deviceFeatures & CRYPT_FPGA_FEATURE_DOUBLE)) {
+			ASSERT(CRYPT_OK == crypt_digest_double_chained(context, inBuffers[i], inBufferLens[i], digests[i]), rv, CRYPT_FAILED, "crypt_fpga_double_batch: Could not compute digest.\n");
+			run = 1;
+			continue;
+		}
+
+		run = 0;
+		while(((i + run) < n) && (32 == inBufferLens[i + run]))
+			run++;
+
+		if(context->deviceFeatures & CRYPT_FPGA_FEATURE_BATCH) {
+			ASSERT(CRYPT_OK == fpga_batch_frames(context, CRYPT_FPGA_BATCH_DOUBLE, &inBuffers[i], run, &digests[i], NULL), rv, CRYPT_FAILED, "crypt_fpga_double_batch: Could not compute digests.\n");
+		}
+		else {
+			ASSERT(CRYPT_OK == fpga_batch_tagged(context, CRYPT_FPGA_CMD_TDOUBLE, &inBuffers[i], run, &digests[i], cores), rv, CRYPT_FAILED, "crypt_fpga_double_batch: Could not compute digests.\n");
+		}
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Digest and sign several independent buffers using the FPGA attached to the backend transfer function.
+ */
+int crypt_fpga_sign_batch(crypt_context_t *context, char **readings, int *readingLens, unsigned int n, char **digests, char **signatures, char *iniVector) {
+	int rv = CRYPT_OK;
+	unsigned int i, run, len;
+	bool sign;
+	uint8_t writeData[CRYPT_FPGA_AKEY_LEN + CRYPT_FPGA_CRC_LEN];
+
+	ASSERT(crypt_fpga_cores(context) != CRYPT_FAILED, rv, CRYPT_FAILED, "crypt_fpga_sign_batch: Could not query FPGA.\n");
+
+	/* Key and IV stay in the FPGA until either one changes */
+	sign = context->deviceFeatures & CRYPT_FPGA_FEATURE_SIGN;
+	if(sign && (!(context->signLoaded) || memcmp(context->signIv, iniVector, 16))) {
+		writeData[0] = CRYPT_FPGA_CMD_AKEY;
+		memcpy(&writeData[1], context->secretKey, 32);
+		memcpy(&writeData[33], iniVector, 16);
+		len = fpga_seal(context, writeData, CRYPT_FPGA_AKEY_LEN);
+		ASSERT(CRYPT_OK == fpga_command(context, writeData, len), rv, CRYPT_FAILED, "crypt_fpga_sign_batch: Could not load key.\n");
+		memset(writeData, 0, sizeof(writeData));
+		memcpy(context->signIv, iniVector, 16);
+		context->signLoaded = true;
+	}
+
+	for(i = 0; i < n; i += run) {
+		/* Other sizes (or all buffers, on bitstreams with no SIGN) are digested as usual and ciphered on the host */
+		for(run = 1; ((i + run) < n) && ((sign && (32 == readingLens[i + run])) == (sign && (32 == readingLens[i]))); run++);
+
+		if(sign && (32 == readingLens[i])) {
+			ASSERT(CRYPT_OK == fpga_batch_frames(context, 0, &readings[i], run, &digests[i], &signatures[i]), rv, CRYPT_FAILED, "crypt_fpga_sign_batch: Could not sign buffers.\n");
+		}
+		else {
+			ASSERT(CRYPT_OK == crypt_sign_batch_chained(context, &readings[i], &readingLens[i], run, &digests[i], &signatures[i], iniVector), rv, CRYPT_FAILED, "crypt_fpga_sign_batch: Could not sign buffers.\n");
+		}
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Get the result of SEARCH (digest, nonce and attempts) from a transfer ended by RESULT. RESULT is repeated
+ *        until the search is over, once the FPGA signals completion. As that may take long, only bytes that are not
+ *        status bytes count as no response. @p good is cleared as in fpga_tail_digest(), but only if the first response
+ *        fails: SEARCH is known to be taken after that, so a later corrupted one only has RESULT sent again (after NOPs
+ *        and CRC, that leave the search running).
+ */
+static int fpga_search_result(crypt_context_t *context, const uint8_t *readData, unsigned int len, unsigned int taken, uint8_t *result, bool *good) {
+	int rv = CRYPT_OK;
+	unsigned int tries, idle = 0;
+	bool crc = fpga_crc_on(context);
+	unsigned int respLen = CRYPT_FPGA_RESULT_RESP_LEN + (crc? CRYPT_FPGA_CRC_LEN : 0);
+	uint8_t writeResult[FPGA_SYNC_LEN + FPGA_RESULT_CRC_LEN];
+	uint8_t readResult[FPGA_SYNC_LEN + FPGA_RESULT_CRC_LEN];
+
+	*good = !crc || fpga_read_ok(context, &readData[len - respLen], CRYPT_FPGA_RESULT_RESP_LEN, taken);
+	while(*good && !(readData[len - respLen] & CRYPT_FPGA_STATUS_DONE)) {
+		if(!(readData[len - respLen] & CRYPT_FPGA_STATUS_FLAG) || (readData[len - respLen] & CRYPT_FPGA_RESP_FLAG)) {
+			ASSERT(++idle <= FPGA_IDLE_MAX, rv, CRYPT_FAILED, "fpga_search_result: FPGA is not responding.\n");
+		}
+
+		if(context->backend->waitIrq) {
+			ASSERT(CRYPT_OK == context->backend->waitIrq(context), rv, CRYPT_FAILED, "fpga_search_result: Could not wait for FPGA.\n");
+		}
+
+		for(tries = 0, *good = false; !(*good) && (tries <= FPGA_RETRIES); tries++) {
+			if(tries)
+				context->busStats.retries++;
+
+			len = tries? fpga_sync(context, writeResult, true) : 0;
+			memset(&writeResult[len], 0, FPGA_RESULT_CRC_LEN);
+			writeResult[len] = CRYPT_FPGA_CMD_RESULT;
+			len += CRYPT_FPGA_RESULT_LEN + CRYPT_FPGA_READ_DELAY + respLen;
+			ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeResult, readResult, len), rv, CRYPT_FAILED, "fpga_search_result: SPI transfer failed.\n");
+			*good = !crc || fpga_read_ok(context, &readResult[len - respLen], CRYPT_FPGA_RESULT_RESP_LEN, 0);
+		}
+		readData = readResult;
+	}
+
+	if(*good)
+		memcpy(result, &readData[len - respLen + 1], CRYPT_FPGA_RESULT_RESP_LEN - 1);
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Search the nonce of a proof of work using the FPGA attached to the backend transfer function.
+ */
+int crypt_fpga_search(crypt_context_t *context, char *inBuffer, int inBufferLen, int nonceOffset, int zeroBits, char *digest, uint64_t *attempts) {
+	int rv = CRYPT_OK;
+	unsigned int i, len, tries, taken, offset;
+	unsigned int last = inBufferLen & ~63;
+	bool crc, good = false;
+	uint32_t nonce;
+	uint64_t bits = (uint64_t) inBufferLen * 8;
+	uint8_t midstate[32];
+	uint8_t block[64];
+	uint8_t result[CRYPT_FPGA_RESULT_RESP_LEN - 1];
+	uint8_t *frame;
+	uint8_t writeData[FPGA_SYNC_LEN + CRYPT_FPGA_LOAD_LEN + CRYPT_FPGA_SEARCH_LEN + (2 * CRYPT_FPGA_CRC_LEN) + FPGA_RESULT_CRC_LEN];
+	uint8_t readData[FPGA_SYNC_LEN + CRYPT_FPGA_LOAD_LEN + CRYPT_FPGA_SEARCH_LEN + (2 * CRYPT_FPGA_CRC_LEN) + FPGA_RESULT_CRC_LEN];
+	crypt_digest_state_t state;
+
+	ASSERT(crypt_fpga_cores(context) != CRYPT_FAILED, rv, CRYPT_FAILED, "crypt_fpga_search: Could not query FPGA.\n");
+	crc = fpga_crc_on(context);
+
+	/* SEARCH hashes a single block, so the nonce must be in the last one, and the padding too */
+	if(!(context->deviceFeatures & CRYPT_FPGA_FEATURE_SEARCH) || ((inBufferLen - last) > 55) || (nonceOffset < (int) last)) {
+		ASSERT(CRYPT_OK == crypt_digest_search_chained(context, inBuffer, inBufferLen, nonceOffset, zeroBits, digest, attempts), rv, CRYPT_FAILED, "crypt_fpga_search: Could not search nonce.\n");
+	}
+	else {
+		/* Blocks before the last one are hashed once. Their midstate is loaded into core 0 before each SEARCH, as */
+		/* cores take it from there */
+		if(last) {
+			ASSERT(CRYPT_OK == crypt_digest_init(context, &state), rv, CRYPT_FAILED, "crypt_fpga_search: Could not start digest.\n");
+			ASSERT(CRYPT_OK == crypt_digest_update(context, &state, inBuffer, last), rv, CRYPT_FAILED, "crypt_fpga_search: Could not update digest.\n");
+			ASSERT(CRYPT_OK == crypt_digest_midstate(context, &state, (char *) midstate), rv, CRYPT_FAILED, "crypt_fpga_search: Could not get midstate.\n");
+		}
+
+		/* Last block, padded */
+		offset = nonceOffset - last;
+		memset(block, 0, sizeof(block));
+		memcpy(block, &inBuffer[last], inBufferLen - last);
+		block[inBufferLen - last] = 0x80;
+		for(i = 0; i < 8; i++)
+			block[56 + i] = bits >> (56 - (8 * i));
+		nonce = (block[offset] << 24) | (block[offset + 1] << 16) | (block[offset + 2] << 8) | block[offset + 3];
+
+		/* 2^32 is a multiple of the chunk, so that chunks are always whole. Commands are sent again in CRC mode */
+		/* until RESULT gets through */
+		for(*attempts = 0; ; nonce = (result[32] << 24) | (result[33] << 16) | (result[34] << 8) | result[35]) {
+			ASSERT(*attempts < (1ULL << 32), rv, CRYPT_FAILED, "crypt_fpga_search: No nonce found.\n");
+			for(i = 0; i < 4; i++)
+				block[offset + i] = nonce >> (24 - (8 * i));
+
+			for(tries = 0, good = false; !good; tries++) {
+				ASSERT(tries <= FPGA_RETRIES, rv, CRYPT_FAILED, "crypt_fpga_search: Too many link errors.\n");
+				if(tries)
+					context->busStats.retries++;
+
+				len = tries? fpga_sync(context, writeData, true) : 0;
+				taken = 1;
+				if(last) {
+					writeData[len] = CRYPT_FPGA_CMD_LOAD;
+					memcpy(&writeData[len + 1], midstate, 32);
+					len += fpga_seal(context, &writeData[len], CRYPT_FPGA_LOAD_LEN);
+					taken++;
+				}
+
+				frame = &writeData[len];
+				frame[0] = CRYPT_FPGA_CMD_SEARCH;
+				frame[1] = offset | (last? CRYPT_FPGA_SEARCH_CHAIN : 0);
+				frame[2] = zeroBits;
+				for(i = 0; i < 4; i++)
+					frame[3 + i] = FPGA_SEARCH_CHUNK >> (24 - (8 * i));
+				memcpy(&frame[7], block, 64);
+				len += fpga_seal(context, frame, CRYPT_FPGA_SEARCH_LEN);
+
+				memset(&writeData[len], 0, FPGA_RESULT_CRC_LEN);
+				writeData[len] = CRYPT_FPGA_CMD_RESULT;
+				len += CRYPT_FPGA_RESULT_LEN + CRYPT_FPGA_READ_DELAY + CRYPT_FPGA_RESULT_RESP_LEN + (crc? CRYPT_FPGA_CRC_LEN : 0);
+
+				ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, len), rv, CRYPT_FAILED, "crypt_fpga_search: SPI transfer failed.\n");
+				ASSERT(CRYPT_OK == fpga_search_result(context, readData, len, taken, result, &good), rv, CRYPT_FAILED, "crypt_fpga_search: Could not read result.\n");
+			}
+
+			/* Digest is all ones (never a winner) if no nonce of the chunk won, and nonce the next one to try */
+			i = (result[36] << 24) | (result[37] << 16) | (result[38] << 8) | result[39];
+			*attempts += i;
+			context->busStats.digests += i;
+			if(crypt_zero_bits((char *) result) >= zeroBits)
+				break;
+		}
+
+		memcpy(&inBuffer[nonceOffset], &result[32], 4);
+		memcpy(digest, result, 32);
+	}
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Bring the FPGA back to a byte and command boundary. Must be called at a clock known to work.
+ */
+int crypt_fpga_resync(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+	unsigned int i, len, idle;
+	uint8_t writeData[FPGA_RESYNC_CHUNK];
+	uint8_t readData[FPGA_RESYNC_CHUNK];
+
+	/* SYNC bytes end whatever command was half-received, and the first NOP after them starts a byte. Bytes taken as */
+	/* commands may have started requests of their own */
+	memset(writeData, CRYPT_FPGA_CMD_SYNC, sizeof(writeData));
+	for(i = 0; i < FPGA_RESYNC_LEN; i += len) {
+		len = ((FPGA_RESYNC_LEN - i) < FPGA_RESYNC_CHUNK)? (FPGA_RESYNC_LEN - i) : FPGA_RESYNC_CHUNK;
+		ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, len), rv, CRYPT_FAILED, "crypt_fpga_resync: SPI transfer failed.\n");
+	}
+	memset(writeData, 0, sizeof(writeData));
+	ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, FPGA_SYNC_NOPS), rv, CRYPT_FAILED, "crypt_fpga_resync: SPI transfer failed.\n");
+
+	/* Device information is queried again, as it may have been read at a failing clock */
+	context->deviceCores = 0;
+	ASSERT(crypt_fpga_cores(context) != CRYPT_FAILED, rv, CRYPT_FAILED, "crypt_fpga_resync: Could not query FPGA.\n");
+
+	/* A SEARCH cut short takes SYNC bytes as arguments (255 zero bits over 2^32 nonces) and may run for an hour. Any */
+	/* command to core 0 ends it, and LOAD gives no response to drain */
+	if(context->deviceFeatures & CRYPT_FPGA_FEATURE_SEARCH) {
+		writeData[0] = CRYPT_FPGA_CMD_LOAD;
+		memset(&writeData[1], 0, 32);
+		len = fpga_seal(context, writeData, CRYPT_FPGA_LOAD_LEN);
+		ASSERT(CRYPT_OK == fpga_command(context, writeData, len), rv, CRYPT_FAILED, "crypt_fpga_resync: Could not end search.\n");
+		memset(writeData, 0, len);
+	}
+
+	/* Responses to those requests are drained */
+	if(context->deviceFeatures & CRYPT_FPGA_FEATURE_STATUS) {
+		len = 0;
+		for(idle = 0; !len || !fpga_idle(readData, len); idle++) {
+			ASSERT(idle <= FPGA_IDLE_MAX, rv, CRYPT_FAILED, "crypt_fpga_resync: FPGA is not responding.\n");
+			len = CRYPT_FPGA_TAIL_LEN;
+			ASSERT(CRYPT_OK == crypt_fpga_transfer(context, writeData, readData, len), rv, CRYPT_FAILED, "crypt_fpga_resync: SPI transfer failed.\n");
+		}
+	}
+
+	/* Keys may have been overwritten, and READ starts over from its first gap */
+	context->hmacLoaded = false;
+	context->signLoaded = false;
+	context->readGap = CRYPT_FPGA_READ_GAP;
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Check the FPGA attached to the backend transfer function against known-answer vectors.
+ */
+int crypt_fpga_check(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+	unsigned int i, j;
+	char digest[32];
+	uint8_t expected[32];
+	char messages[FPGA_CHECK_BATCH][32];
+	char digests[FPGA_CHECK_BATCH][32];
+	char *inBuffers[FPGA_CHECK_BATCH];
+	char *outBuffers[FPGA_CHECK_BATCH];
+	int inBufferLens[FPGA_CHECK_BATCH];
+	uint64_t errors = context->busStats.crcErrors + context->busStats.frameErrors + context->busStats.retries;
+
+	for(i = 0; i < FPGA_VECTORS; i++) {
+		ASSERT(CRYPT_OK == crypt_fpga_digest(context, (char *) fpga_vectors[i].message, fpga_vectors[i].len, digest), rv, CRYPT_FAILED, "crypt_fpga_check: Could not digest vector %u.\n", i);
+		ASSERT(!memcmp(digest, fpga_vectors[i].digest, 32), rv, CRYPT_FAILED, "crypt_fpga_check: Vector %u does not match at %u Hz.\n", i, context->busHz);
+	}
+
+	/* Batch path is checked against the host SHA-256 kernel. Requests differ in every byte, so that mixed up */
+	/* responses show as well as corrupted ones */
+	for(i = 0; i < FPGA_CHECK_BATCH; i++) {
+		for(j = 0; j < 32; j++)
+			messages[i][j] = (i * 37) + (j * 11);
+		inBuffers[i] = messages[i];
+		outBuffers[i] = digests[i];
+		inBufferLens[i] = 32;
+	}
+
+	ASSERT(CRYPT_OK == crypt_fpga_digest_batch(context, inBuffers, inBufferLens, FPGA_CHECK_BATCH, outBuffers), rv, CRYPT_FAILED, "crypt_fpga_check: Could not digest batch.\n");
+	for(i = 0; i < FPGA_CHECK_BATCH; i++) {
+		sha256_digest((uint8_t *) messages[i], 32, expected);
+		ASSERT(!memcmp(digests[i], expected, 32), rv, CRYPT_FAILED, "crypt_fpga_check: Batch request %u does not match at %u Hz.\n", i, context->busHz);
+	}
+
+	/* In CRC mode, link errors are caught and retried, but a clock that needs retries is no good either */
+	ASSERT(errors == (context->busStats.crcErrors + context->busStats.frameErrors + context->busStats.retries), rv, CRYPT_FAILED, "crypt_fpga_check: Link errors at %u Hz.\n", context->busHz);
+
+_err:
+	return rv;
+}
+
+/**
+ * @brief Sweep the SPI clocks of the backend and set the fastest reliable one.
+ */
+int crypt_fpga_calibrate(crypt_context_t *context) {
+	int rv = CRYPT_OK;
+	unsigned int i, j, best = 0;
+	bool failed = false;
+
+	ASSERT(context->backend->setClock, rv, CRYPT_FAILED, "crypt_fpga_calibrate: Backend has no clock to set.\n");
+
+	/* Slowest clock must pass, so that the FPGA may be resynchronised there */
+	ASSERT(CRYPT_OK == context->backend->setClock(context, fpga_clocks[0]), rv, CRYPT_FAILED, "crypt_fpga_calibrate: Could not set clock.\n");
+	ASSERT(CRYPT_OK == crypt_fpga_resync(context), rv, CRYPT_FAILED, "crypt_fpga_calibrate: Could not resynchronise FPGA.\n");
+	ASSERT(CRYPT_OK == crypt_fpga_check(context), rv, CRYPT_FAILED, "crypt_fpga_calibrate: FPGA fails at %u Hz.\n", context->busHz);
+
+	/* Clocks are tried up to the first failure */
+	for(i = 1; (i < FPGA_CLOCKS) && !failed; i++) {
+		ASSERT(CRYPT_OK == context->backend->setClock(context, fpga_clocks[i]), rv, CRYPT_FAILED, "crypt_fpga_calibrate: Could not set clock.\n");
+		for(j = 0; (j < FPGA_CHECK_ROUNDS) && (CRYPT_OK == crypt_fpga_check(context)); j++);
+
+		failed = (j < FPGA_CHECK_ROUNDS);
+		if(!failed)
+			best = i;
+	}
+
+	/* A clock that barely passes may fail with temperature or noise, so the next one down is kept */
+	if(failed && best)
+		best--;
+
+	ASSERT(CRYPT_OK == context->backend->setClock(context, fpga_clocks[best]), rv, CRYPT_FAILED, "crypt_fpga_calibrate: Could not set clock.\n");
+	if(failed) {
+		ASSERT(CRYPT_OK == crypt_fpga_resync(context), rv, CRYPT_FAILED, "crypt_fpga_calibrate: Could not resynchronise FPGA.\n");
+	}
+	ASSERT(CRYPT_OK == crypt_fpga_check(context), rv, CRYPT_FAILED, "crypt_fpga_calibrate: FPGA fails at %u Hz.\n", context->busHz);
+
+_err:
+	return rv;
+}
@@ -0,0 +1,462 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (SHA-256 Kernels)                                             * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/sha256.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#if defined(__aarch64__) || defined(__arm__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define S0(x) (ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define S1(x) (ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define s0(x) (ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define s1(x) (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+#define CH(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x, y, z) (((x) & (y)) | ((z) & ((x) | (y))))
+
+/* Load big-endian word */
+#define LOAD32(p) (((uint32_t) (p)[0] << 24) | ((uint32_t) (p)[1] << 16) | ((uint32_t) (p)[2] << 8) | (uint32_t) (p)[3])
+
+/* One round, variables are rotated by the caller instead of being moved around */
+#define ROUND(a, b, c, d, e, f, g, h, i) {\
+	uint32_t t1 = h + S1(e) + CH(e, f, g) + sha256_k[i] + w[(i) & 15];\
+	d += t1;\
+	h = t1 + S0(a) + MAJ(a, b, c);\
+}
+
+/* Message schedule, kept as a 16-word sliding window */
+#define SCHEDULE(i) (w[(i) & 15] += s1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] + s0(w[((i) - 15) & 15]))
+
+/* Eight rounds, after which the variables are back in their original places */
+#define ROUNDS8(i) {\
+	ROUND(a, b, c, d, e, f, g, h, (i) + 0);\
+	ROUND(h, a, b, c, d, e, f, g, (i) + 1);\
+	ROUND(g, h, a, b, c, d, e, f, (i) + 2);\
+	ROUND(f, g, h, a, b, c, d, e, (i) + 3);\
+	ROUND(e, f, g, h, a, b, c, d, (i) + 4);\
+	ROUND(d, e, f, g, h, a, b, c, (i) + 5);\
+	ROUND(c, d, e, f, g, h, a, b, (i) + 6);\
+	ROUND(b, c, d, e, f, g, h, a, (i) + 7);\
+}
+
+#define SCHEDULE8(i) {\
+	SCHEDULE((i) + 0); SCHEDULE((i) + 1); SCHEDULE((i) + 2); SCHEDULE((i) + 3);\
+	SCHEDULE((i) + 4); SCHEDULE((i) + 5); SCHEDULE((i) + 6); SCHEDULE((i) + 7);\
+}
+
+const uint32_t sha256_h0[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+const uint32_t sha256_k[64] __attribute__((aligned(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/**
+ * @brief Multi-buffer kernel descriptor.
+ */
+typedef struct {
+	size_t lanes;
+	sha256_mb_compress_t compress;
+} mb_kernel_t;
+
+sha256_compress_t sha256_compress = sha256_compress_scalar;
+static const char *kernelName = "scalar";
+
+/* Multi-buffer kernels in use, widest first */
+static mb_kernel_t mbKernels[3];
+static int mbKernelsLen = 0;
+
+/**
+ * @brief Portable compression function.
+ */
+void sha256_compress_scalar(uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+	int i;
+	uint32_t w[16];
+	uint32_t a, b, c, d, e, f, g, h;
+
+	for(; nBlocks; nBlocks--, blocks += 64) {
+		for(i = 0; i < 16; i++)
+			w[i] = LOAD32(&blocks[4 * i]);
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		ROUNDS8(0);
+		ROUNDS8(8);
+		for(i = 16; i < 64; i += 16) {
+			SCHEDULE8(i);
+			ROUNDS8(i);
+			SCHEDULE8(i + 8);
+			ROUNDS8(i + 8);
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
+}
+
+/**
+ * @brief Tell if a multi-buffer kernel supported by the CPU is to be used: only along with the portable kernel,
+ *        unless environment variable CRYPT_SHA256_MB names it.
+ */
+static int mb_wanted(const char *name, const char *forcedMb, int scalar) {
+	if(forcedMb && *forcedMb)
+		return !strcmp(forcedMb, name);
+
+	return !scalar && (sha256_compress_scalar == sha256_compress);
+}
+
+/**
+ * @brief Select the fastest compression function supported by this CPU.
+ */
+void sha256_select(void) {
+	char *forced = getenv("CRYPT_SHA256");
+	char *forcedMb = getenv("CRYPT_SHA256_MB");
+	int scalar = forced && !strcmp(forced, "scalar");
+
+	sha256_compress = sha256_compress_scalar;
+	kernelName = "scalar";
+	mbKernelsLen = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+	{
+		unsigned int eax, ebx, ecx, edx;
+
+		/* SSSE3 (ecx bit 9) and SSE4.1 (ecx bit 19) are used alongside SHA (leaf 7, ebx bit 29) */
+		if(!scalar && __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1 << 9)) && (ecx & (1 << 19)) &&
+			__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1 << 29))) {
+			sha256_compress = sha256_compress_shani;
+			kernelName = "shani";
+		}
+	}
+
+	/* __builtin_cpu_supports() also checks if the OS saves the wider registers. Multi-buffer kernels are left for */
+	/* CPUs without SHA extensions: per message, even AVX-512 is no faster than them on some CPUs */
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f") && mb_wanted("avx512", forcedMb, scalar))
+		mbKernels[mbKernelsLen++] = (mb_kernel_t) {16, sha256_mb_compress_avx512};
+	if(__builtin_cpu_supports("avx2") && mb_wanted("avx2", forcedMb, scalar))
+		mbKernels[mbKernelsLen++] = (mb_kernel_t) {8, sha256_mb_compress_avx2};
+	if(__builtin_cpu_supports("sse2") && mb_wanted("sse2", forcedMb, scalar))
+		mbKernels[mbKernelsLen++] = (mb_kernel_t) {4, sha256_mb_compress_sse2};
+#endif
+
+#if defined(__aarch64__)
+	if(!scalar && (getauxval(AT_HWCAP) & HWCAP_SHA2)) {
+		sha256_compress = sha256_compress_armv8;
+		kernelName = "armv8";
+	}
+
+	/* 4-lane NEON only pays off on cores without SHA-256 instructions (e.g. Cortex-A53 on Raspberry Pi 3) */
+	if(mb_wanted("neon", forcedMb, scalar))
+		mbKernels[mbKernelsLen++] = (mb_kernel_t) {4, sha256_mb_compress_neon};
+#endif
+
+#if defined(__arm__)
+	if((getauxval(AT_HWCAP) & HWCAP_NEON) && mb_wanted("neon", forcedMb, scalar))
+		mbKernels[mbKernelsLen++] = (mb_kernel_t) {4, sha256_mb_compress_neon};
+#endif
+}
+
+/**
+ * @brief Get name of compression function in use.
+ */
+const char *sha256_kernel_name(void) {
+	return kernelName;
+}
+
+/**
+ * @brief Get the lane count of the widest multi-buffer kernel in use.
+ */
+size_t sha256_mb_lanes(void) {
+	return mbKernelsLen? mbKernels[0].lanes : 0;
+}
+
+/**
+ * @brief Store hash state as a big-endian digest.
+ */
+static void store_digest(const uint32_t *state, uint8_t *digest) {
+	int i;
+
+	for(i = 0; i < 8; i++) {
+		digest[4 * i] = state[i] >> 24;
+		digest[(4 * i) + 1] = state[i] >> 16;
+		digest[(4 * i) + 2] = state[i] >> 8;
+		digest[(4 * i) + 3] = state[i];
+	}
+}
+
+/**
+ * @brief Single-block compression from the initial hash value, for messages of up to 32 bytes.
+ * @param state Output hash state.
+ * @param m First 8 message words, already padded if message is shorter than 32 bytes.
+ * @param w8 Ninth message word: padding if message is exactly 32 bytes, zero otherwise.
+ * @param w15 Last message word: message length in bits.
+ * @note Always inlined, so that constant @p w8 and @p w15 (and the zeroes in between) get folded into the
+ *       round constants and message schedule at compile time.
+ */
+static inline __attribute__((always_inline)) void compress_short(uint32_t *state, const uint32_t *m, uint32_t w8, uint32_t w15) {
+	uint32_t w[16] = {m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], w8, 0, 0, 0, 0, 0, 0, w15};
+	uint32_t a = sha256_h0[0], b = sha256_h0[1], c = sha256_h0[2], d = sha256_h0[3];
+	uint32_t e = sha256_h0[4], f = sha256_h0[5], g = sha256_h0[6], h = sha256_h0[7];
+
+	ROUNDS8(0);
+	ROUNDS8(8);
+	SCHEDULE8(16);
+	ROUNDS8(16);
+	SCHEDULE8(24);
+	ROUNDS8(24);
+	SCHEDULE8(32);
+	ROUNDS8(32);
+	SCHEDULE8(40);
+	ROUNDS8(40);
+	SCHEDULE8(48);
+	ROUNDS8(48);
+	SCHEDULE8(56);
+	ROUNDS8(56);
+
+	state[0] = sha256_h0[0] + a;
+	state[1] = sha256_h0[1] + b;
+	state[2] = sha256_h0[2] + c;
+	state[3] = sha256_h0[3] + d;
+	state[4] = sha256_h0[4] + e;
+	state[5] = sha256_h0[5] + f;
+	state[6] = sha256_h0[6] + g;
+	state[7] = sha256_h0[7] + h;
+}
+
+/**
+ * @brief Digest a buffer of any size using SHA-256.
+ */
+void sha256_digest_generic(const uint8_t *inBuffer, size_t inBufferLen, uint8_t *digest) {
+	int i;
+	uint32_t state[8];
+	uint8_t tail[128];
+	size_t nBlocks = inBufferLen / 64;
+	size_t tailLen = inBufferLen % 64;
+	/* Padding takes one or two extra blocks */
+	size_t tailBlocks = (tailLen < 56)? 1 : 2;
+	uint64_t bitLen = (uint64_t) inBufferLen * 8;
+
+	memcpy(state, sha256_h0, sizeof(state));
+
+	/* Full blocks are compressed straight from input */
+	if(nBlocks)
+		sha256_compress(state, inBuffer, nBlocks);
+
+	/* Last block(s): remaining data, 0x80, zeroes and message length in bits */
+	memcpy(tail, &inBuffer[nBlocks * 64], tailLen);
+	tail[tailLen] = 0x80;
+	memset(&tail[tailLen + 1], 0, (tailBlocks * 64) - tailLen - 1);
+	for(i = 0; i < 8; i++)
+		tail[(tailBlocks * 64) - 1 - i] = bitLen >> (8 * i);
+	sha256_compress(state, tail, tailBlocks);
+
+	store_digest(state, digest);
+}
+
+/**
+ * @brief Digest a buffer that fits in a single block using SHA-256.
+ */
+void sha256_digest_short(const uint8_t *inBuffer, size_t inBufferLen, uint8_t *digest) {
+	int i;
+	uint32_t state[8];
+	uint32_t m[8];
+	uint8_t block[64];
+
+	if(sha256_compress_scalar == sha256_compress && 32 == inBufferLen) {
+		/* Message words 8 to 15 are all constant */
+		for(i = 0; i < 8; i++)
+			m[i] = LOAD32(&inBuffer[4 * i]);
+		compress_short(state, m, 0x80000000, 256);
+	}
+	else if(sha256_compress_scalar == sha256_compress && inBufferLen < 32) {
+		/* Padding falls within the first 8 words, message words 8 to 14 are zero */
+		memcpy(block, inBuffer, inBufferLen);
+		block[inBufferLen] = 0x80;
+		memset(&block[inBufferLen + 1], 0, 31 - inBufferLen);
+		for(i = 0; i < 8; i++)
+			m[i] = LOAD32(&block[4 * i]);
+		compress_short(state, m, 0, inBufferLen * 8);
+	}
+	else {
+		/* Hardware kernels beat the specialised one, so just pad and compress a single block */
+		memcpy(state, sha256_h0, sizeof(state));
+		memcpy(block, inBuffer, inBufferLen);
+		block[inBufferLen] = 0x80;
+		memset(&block[inBufferLen + 1], 0, 61 - inBufferLen);
+		block[62] = (inBufferLen * 8) >> 8;
+		block[63] = inBufferLen * 8;
+		sha256_compress(state, block, 1);
+	}
+
+	store_digest(state, digest);
+}
+
+/**
+ * @brief Digest a buffer using SHA-256.
+ */
+void sha256_digest(const uint8_t *inBuffer, size_t inBufferLen, uint8_t *digest) {
+	if(inBufferLen <= SHA256_SHORT_MAX)
+		sha256_digest_short(inBuffer, inBufferLen, digest);
+	else
+		sha256_digest_generic(inBuffer, inBufferLen, digest);
+}
+
+/**
+ * @brief Digest one buffer per lane of a multi-buffer kernel.
+ */
+static void digest_lanes(const mb_kernel_t *kernel, const uint8_t **inBuffers, const size_t *inBufferLens, uint8_t **digests) {
+	size_t i, l, b;
+	size_t lanes = kernel->lanes;
+	size_t nBlocks[SHA256_MB_MAX_LANES];
+	size_t maxBlocks = 0;
+	uint8_t tail[64];
+	/* SoA state and block, aligned to cache lines */
+	uint32_t state[8 * SHA256_MB_MAX_LANES] __attribute__((aligned(64)));
+	uint32_t block[16 * SHA256_MB_MAX_LANES] __attribute__((aligned(64)));
+
+	for(l = 0; l < lanes; l++) {
+		/* Data, 0x80 and 64-bit length */
+		nBlocks[l] = (inBufferLens[l] + 9 + 63) / 64;
+		if(nBlocks[l] > maxBlocks)
+			maxBlocks = nBlocks[l];
+
+		for(i = 0; i < 8; i++)
+			state[(i * lanes) + l] = sha256_h0[i];
+	}
+
+	for(b = 0; b < maxBlocks; b++) {
+		/* Transpose b-th block of each lane into block. Lanes that are already done keep their last block. Data is */
+		/* only addressed while some is left, so that no pointer goes past the end of a buffer */
+		for(l = 0; l < lanes; l++) {
+			size_t offset = b * 64;
+			const uint8_t *src = tail;
+
+			if(b >= nBlocks[l])
+				continue;
+
+			if(offset + 64 <= inBufferLens[l]) {
+				src = &inBuffers[l][offset];
+			}
+			else {
+				size_t remaining = (offset < inBufferLens[l])? (inBufferLens[l] - offset) : 0;
+
+				if(remaining)
+					memcpy(tail, &inBuffers[l][offset], remaining);
+				memset(&tail[remaining], 0, 64 - remaining);
+				if(offset <= inBufferLens[l])
+					tail[remaining] = 0x80;
+				if((nBlocks[l] - 1) == b) {
+					uint64_t bitLen = (uint64_t) inBufferLens[l] * 8;
+
+					for(i = 0; i < 8; i++)
+						tail[63 - i] = bitLen >> (8 * i);
+				}
+			}
+
+			for(i = 0; i < 16; i++)
+				block[(i * lanes) + l] = LOAD32(&src[4 * i]);
+		}
+
+		kernel->compress(state, block);
+
+		/* Collect digests of lanes that just finished */
+		for(l = 0; l < lanes; l++) {
+			if((nBlocks[l] - 1) != b)
+				continue;
+
+			for(i = 0; i < 8; i++) {
+				uint32_t word = state[(i * lanes) + l];
+
+				digests[l][4 * i] = word >> 24;
+				digests[l][(4 * i) + 1] = word >> 16;
+				digests[l][(4 * i) + 2] = word >> 8;
+				digests[l][(4 * i) + 3] = word;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Digest several independent buffers using SHA-256.
+ */
+void sha256_digest_batch(const uint8_t **inBuffers, const size_t *inBufferLens, size_t n, uint8_t **digests) {
+	int k = 0;
+
+	while(n) {
+		/* Use the widest kernel that can be filled */
+		while(k < mbKernelsLen && mbKernels[k].lanes > n)
+			k++;
+
+		/* Tail is done one by one */
+		if(k == mbKernelsLen) {
+			sha256_digest(*inBuffers, *inBufferLens, *digests);
+			inBuffers++;
+			inBufferLens++;
+			digests++;
+			n--;
+		}
+		else {
+			digest_lanes(&mbKernels[k], inBuffers, inBufferLens, digests);
+			inBuffers += mbKernels[k].lanes;
+			inBufferLens += mbKernels[k].lanes;
+			digests += mbKernels[k].lanes;
+			n -= mbKernels[k].lanes;
+		}
+	}
+}
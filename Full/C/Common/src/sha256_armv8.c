@@ -0,0 +1,82 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (SHA-256 ARMv8 Crypto Extensions Kernel)                      * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/sha256.h"
+
+#if defined(__aarch64__)
+
+#pragma GCC target("+crypto")
+
+#include <arm_neon.h>
+#include <stdint.h>
+
+/* Four rounds with message words from group k */
+#define QROUND(k) {\
+	msg = vaddq_u32(m[(k) & 3], vld1q_u32(&sha256_k[4 * (k)]));\
+	tmp = state0;\
+	state0 = vsha256hq_u32(state0, state1, msg);\
+	state1 = vsha256h2q_u32(state1, tmp, msg);\
+}
+
+/* Message words of group k from groups k-4 to k-1 */
+#define SCHEDULE(k) {\
+	m[(k) & 3] = vsha256su1q_u32(vsha256su0q_u32(m[(k) & 3], m[((k) - 3) & 3]), m[((k) - 2) & 3], m[((k) - 1) & 3]);\
+}
+
+/**
+ * @brief Compression function using ARMv8 Cryptography Extensions.
+ */
+void sha256_compress_armv8(uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+	uint32x4_t state0, state1, save0, save1, msg, tmp;
+	uint32x4_t m[4];
+
+	state0 = vld1q_u32(&state[0]);
+	state1 = vld1q_u32(&state[4]);
+
+	for(; nBlocks; nBlocks--, blocks += 64) {
+		save0 = state0;
+		save1 = state1;
+
+		m[0] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(&blocks[0])));
+		m[1] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(&blocks[16])));
+		m[2] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(&blocks[32])));
+		m[3] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(&blocks[48])));
+
+		QROUND(0); QROUND(1); QROUND(2); QROUND(3);
+		SCHEDULE(4); QROUND(4); SCHEDULE(5); QROUND(5); SCHEDULE(6); QROUND(6); SCHEDULE(7); QROUND(7);
+		SCHEDULE(8); QROUND(8); SCHEDULE(9); QROUND(9); SCHEDULE(10); QROUND(10); SCHEDULE(11); QROUND(11);
+		SCHEDULE(12); QROUND(12); SCHEDULE(13); QROUND(13); SCHEDULE(14); QROUND(14); SCHEDULE(15); QROUND(15);
+
+		state0 = vaddq_u32(state0, save0);
+		state1 = vaddq_u32(state1, save1);
+	}
+
+	vst1q_u32(&state[0], state0);
+	vst1q_u32(&state[4], state1);
+}
+
+#endif
@@ -0,0 +1,91 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (SHA-256 x86 SHA Extensions Kernel)                           * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/sha256.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#pragma GCC target("sha,ssse3,sse4.1")
+
+#include <immintrin.h>
+#include <stdint.h>
+
+/* Four rounds with message words from group k */
+#define QROUND(k) {\
+	msg = _mm_add_epi32(m[(k) & 3], _mm_load_si128((const __m128i *) &sha256_k[4 * (k)]));\
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg);\
+	msg = _mm_shuffle_epi32(msg, 0x0e);\
+	state0 = _mm_sha256rnds2_epu32(state0, state1, msg);\
+}
+
+/* Message words of group k from groups k-4 to k-1 */
+#define SCHEDULE(k) {\
+	m[(k) & 3] = _mm_sha256msg1_epu32(m[(k) & 3], m[((k) - 3) & 3]);\
+	m[(k) & 3] = _mm_add_epi32(m[(k) & 3], _mm_alignr_epi8(m[((k) - 1) & 3], m[((k) - 2) & 3], 4));\
+	m[(k) & 3] = _mm_sha256msg2_epu32(m[(k) & 3], m[((k) - 1) & 3]);\
+}
+
+/**
+ * @brief Compression function using x86 SHA extensions.
+ */
+void sha256_compress_shani(uint32_t *state, const uint8_t *blocks, size_t nBlocks) {
+	__m128i state0, state1, save0, save1, msg, tmp;
+	__m128i m[4];
+	const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	/* SHA instructions use state as ABEF and CDGH */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[0]), 0xb1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[4]), 0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+	for(; nBlocks; nBlocks--, blocks += 64) {
+		save0 = state0;
+		save1 = state1;
+
+		m[0] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &blocks[0]), byteSwap);
+		m[1] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &blocks[16]), byteSwap);
+		m[2] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &blocks[32]), byteSwap);
+		m[3] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) &blocks[48]), byteSwap);
+
+		QROUND(0); QROUND(1); QROUND(2); QROUND(3);
+		SCHEDULE(4); QROUND(4); SCHEDULE(5); QROUND(5); SCHEDULE(6); QROUND(6); SCHEDULE(7); QROUND(7);
+		SCHEDULE(8); QROUND(8); SCHEDULE(9); QROUND(9); SCHEDULE(10); QROUND(10); SCHEDULE(11); QROUND(11);
+		SCHEDULE(12); QROUND(12); SCHEDULE(13); QROUND(13); SCHEDULE(14); QROUND(14); SCHEDULE(15); QROUND(15);
+
+		state0 = _mm_add_epi32(state0, save0);
+		state1 = _mm_add_epi32(state1, save1);
+	}
+
+	/* Back to ABCD and EFGH */
+	tmp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	_mm_storeu_si128((__m128i *) &state[0], _mm_blend_epi16(tmp, state1, 0xf0));
+	_mm_storeu_si128((__m128i *) &state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+#endif
@@ -0,0 +1,218 @@
+/* ********************************************************************************************* */
+/* * Simple Cryptography Library (Verilator Model of TOP.v)                                    * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "../include/verilator_top.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "VTOP.h"
+#include "verilated.h"
+
+/* SYS_CLK half period (50 MHz), in picoseconds */
+#define TOP_SYSCLK_HALF_PS 10000
+/* SYS_CLK cycles with PB[1] held low on reset */
+#define TOP_RESET_CYCLES 4
+
+/**
+ * @brief Model and simulated time.
+ */
+typedef struct {
+	VerilatedContext *ctx;
+	VTOP *top;
+	/* Current time, in picoseconds */
+	uint64_t now;
+	/* Time of next SYS_CLK edge, in picoseconds */
+	uint64_t nextSysclk;
+	/* SCLK half period, in picoseconds */
+	uint64_t sclkHalf;
+	/* SYS_CLK rising edges so far */
+	uint64_t sysclkCycles;
+	/* SPI data lines on each direction and transfers on both SCLK edges */
+	unsigned int lanes;
+	bool ddr;
+} top_t;
+
+/**
+ * @brief Advance simulated time, toggling SYS_CLK on the way.
+ */
+static void advance(top_t *t, uint64_t ps) {
+	uint64_t target = t->now + ps;
+
+	while(t->nextSysclk <= target) {
+		t->now = t->nextSysclk;
+		t->ctx->time(t->now);
+		t->top->SYS_CLK = !(t->top->SYS_CLK);
+		t->top->eval();
+
+		if(t->top->SYS_CLK)
+			(t->sysclkCycles)++;
+		t->nextSysclk += TOP_SYSCLK_HALF_PS;
+	}
+
+	t->now = target;
+	t->ctx->time(t->now);
+}
+
+/**
+ * @brief Drive a beat on the MOSI lanes (I2C_SDA, GPIO_01, GPIO_02 and GPIO_03, lowest first).
+ */
+static void drive(top_t *t, uint8_t beat) {
+	t->top->I2C_SDA = beat & 1;
+	t->top->GPIO_01 = (beat >> 1) & 1;
+	t->top->GPIO_02 = (beat >> 2) & 1;
+	t->top->GPIO_03 = (beat >> 3) & 1;
+	t->top->eval();
+}
+
+/**
+ * @brief Read a beat from the MISO lanes (GPIO_A, GPIO_04, GPIO_05 and GPIO_06, lowest first).
+ */
+static uint8_t sample(top_t *t) {
+	uint8_t beat = (t->top->GPIO_A & 1) | ((t->top->GPIO_04 & 1) << 1) | ((t->top->GPIO_05 & 1) << 2) | ((t->top->GPIO_06 & 1) << 3);
+
+	return beat & ((1 << t->lanes) - 1);
+}
+
+/**
+ * @brief Create the Verilator model of TOP.v and reset it through PB[1].
+ */
+void *verilator_top_open(uint32_t sclkHz, unsigned int lanes, bool ddr) {
+	top_t *t;
+
+	if(!sclkHz || ((lanes != 1) && (lanes != 2) && (lanes != 4)))
+		return NULL;
+
+	t = new top_t;
+	t->ctx = new VerilatedContext;
+	t->top = new VTOP(t->ctx);
+	t->now = 0;
+	t->nextSysclk = TOP_SYSCLK_HALF_PS;
+	t->sclkHalf = 500000000000ull / sclkHz;
+	t->sysclkCycles = 0;
+	t->lanes = lanes;
+	t->ddr = ddr;
+
+	/* SPI idle (mode 0) and PB[1] (rst_n) pressed. Push buttons are active low */
+	t->top->SYS_CLK = 0;
+	t->top->I2C_SCL = 0;
+	t->top->I2C_SDA = 0;
+	t->top->GPIO_01 = 0;
+	t->top->GPIO_02 = 0;
+	t->top->GPIO_03 = 0;
+	t->top->PB = 0xe;
+	t->top->eval();
+	advance(t, 2 * TOP_SYSCLK_HALF_PS * TOP_RESET_CYCLES);
+
+	t->top->PB = 0xf;
+	t->top->eval();
+	advance(t, 2 * TOP_SYSCLK_HALF_PS * TOP_RESET_CYCLES);
+
+	return t;
+}
+
+/**
+ * @brief Change the simulated SPI clock.
+ */
+bool verilator_top_set_sclk(void *top, uint32_t sclkHz) {
+	top_t *t = (top_t *) top;
+
+	if(!sclkHz)
+		return false;
+
+	t->sclkHalf = 500000000000ull / sclkHz;
+
+	return true;
+}
+
+/**
+ * @brief Full-duplex SPI transfer with the model.
+ */
+uint64_t verilator_top_transfer(void *top, const uint8_t *writeData, uint8_t *readData, unsigned int len) {
+	unsigned int i, j;
+	top_t *t = (top_t *) top;
+	uint64_t then = t->sysclkCycles;
+	unsigned int lanes = t->lanes;
+	uint8_t mask = (1 << lanes) - 1;
+
+	for(i = 0; i < len; i++) {
+		readData[i] = 0;
+
+		/* Beats of a byte, most significant first */
+		for(j = lanes; j <= 8; j += lanes) {
+			/* MOSI is driven while SCLK is low */
+			drive(t, (writeData[i] >> (8 - j)) & mask);
+			advance(t, t->sclkHalf);
+
+			/* Both sides sample on the rising edge: MISO is read before the slave updates it */
+			readData[i] |= sample(t) << (8 - j);
+			t->top->I2C_SCL = 1;
+			t->top->eval();
+
+			/* With DDR, next beat is driven while SCLK is high and sampled on the falling edge */
+			if(t->ddr) {
+				j += lanes;
+				drive(t, (writeData[i] >> (8 - j)) & mask);
+				advance(t, t->sclkHalf);
+				readData[i] |= sample(t) << (8 - j);
+			}
+			else {
+				advance(t, t->sclkHalf);
+			}
+
+			t->top->I2C_SCL = 0;
+			t->top->eval();
+		}
+	}
+
+	return t->sysclkCycles - then;
+}
+
+/**
+ * @brief Advance simulated time until the completion interrupt is high.
+ */
+uint64_t verilator_top_wait_irq(void *top, uint64_t maxCycles) {
+	top_t *t = (top_t *) top;
+	uint64_t then = t->sysclkCycles;
+
+	while(!(t->top->GPIO_07) && ((t->sysclkCycles - then) < maxCycles))
+		advance(t, 2 * TOP_SYSCLK_HALF_PS);
+
+	return t->sysclkCycles - then;
+}
+
+/**
+ * @brief Destroy the model.
+ */
+void verilator_top_close(void *top) {
+	top_t *t = (top_t *) top;
+
+	t->top->final();
+	delete t->top;
+	delete t->ctx;
+	delete t;
+}
@@ -30,7 +30,7 @@
 #include <stdlib.h>
 #include <sys/time.h>
 
-#include "../include/crypt.h"
+#include "../../Common/include/crypt.h"
 
 #define MSG_LEN 32
 #define ITERS 128
@@ -38,63 +38,66 @@
 int main(void) {
 	int i, j;
 	struct timeval then, now;
-	suseconds_t totalHash = 0; 
-	suseconds_t totalAes = 0; 
+	suseconds_t totalSign = 0;
 	FILE *opf;
 	mraa_aio_context aio0;
 	crypt_context_t context;
-	char readings[MSG_LEN + 1];
-	char hashBuff[32];
-	char encBuff[32];
+	char readings[ITERS][MSG_LEN + 1];
+	char hashBuff[ITERS][32];
+	char encBuff[ITERS][32];
+	char *readingPtrs[ITERS];
+	char *hashPtrs[ITERS];
+	char *encPtrs[ITERS];
+	int readingLens[ITERS];
 
+	if(crypt_initialise(&context) != CRYPT_OK) {
+		fprintf(stderr, "Could not initialise cryptography library.\n");
+		return 1;
+	}
 	opf = fopen("data.out", "w");
 	aio0 = mraa_aio_init(0);
-	crypt_initialise(&context);
 	/* For test purposes, the key is left wide open here */
 	crypt_set_key(&context, "abcdefghijklmnopqrstuvwxyz012345");
-
-	for(i = 0; i < MSG_LEN; i++)
-		readings[i] = 0;
+	printf("Using %s backend\n", crypt_get_backend_name(&context));
 
 	for(i = 0; i < ITERS; i++) {
 		/* Acquire data from analog input 0 */
-		sprintf(&readings[0], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[4], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[8], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[12], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[16], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[20], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[24], "%04x", mraa_aio_read(aio0));
-		sprintf(&readings[28], "%04x", mraa_aio_read(aio0));
-		//sprintf(readings, "abcdefghijklmnopqrstuvwxyz012345");
+		sprintf(&readings[i][0], "%04x", mraa_aio_read(aio0));
+		sprintf(&readings[i][4], "%04x", mraa_aio_read(aio0));
+		sprintf(&readings[i][8], "%04x", mraa_aio_read(aio0));
+		sprintf(&readings[i][12], "%04x", mraa_aio_read(aio0));
+		sprintf(&readings[i][16], "%04x", mraa_aio_read(aio0));
+		sprintf(&readings[i][20], "%04x", mraa_aio_read(aio0));
+		sprintf(&readings[i][24], "%04x", mraa_aio_read(aio0));
+		sprintf(&readings[i][28], "%04x", mraa_aio_read(aio0));
+		//sprintf(readings[i], "abcdefghijklmnopqrstuvwxyz012345");
 
-		/* Digest data */
-		gettimeofday(&then, NULL);
-		crypt_digest(&context, readings, MSG_LEN, hashBuff);
-		gettimeofday(&now, NULL);
-		totalHash += (now.tv_usec - then.tv_usec);
+		readingPtrs[i] = readings[i];
+		readingLens[i] = MSG_LEN;
+		hashPtrs[i] = hashBuff[i];
+		encPtrs[i] = encBuff[i];
+	}
 
-		/* Cipher digest */
-		gettimeofday(&then, NULL);
-		crypt_aes_enc(&context, hashBuff, encBuff, 32, "0123456789abcdef");
-		gettimeofday(&now, NULL);
-		totalAes += (now.tv_usec - then.tv_usec);
+	/* Digest and cipher all readings in one go */
+	gettimeofday(&then, NULL);
+	crypt_sign_batch(&context, readingPtrs, readingLens, ITERS, hashPtrs, encPtrs, "0123456789abcdef");
+	gettimeofday(&now, NULL);
+	totalSign = (now.tv_sec - then.tv_sec) * 1000000 + (now.tv_usec - then.tv_usec);
 
-		/* Save findings to file */
-		fprintf(opf, "%s\n", readings);
+	/* Save findings to file */
+	for(i = 0; i < ITERS; i++) {
+		fprintf(opf, "%s\n", readings[i]);
 		for(j = 0; j < 32; j++)
-			fprintf(opf, "%02x", hashBuff[j] & 0xff);
+			fprintf(opf, "%02x", hashBuff[i][j] & 0xff);
 		fprintf(opf, "\n");
 		for(j = 0; j < 32; j++)
-			fprintf(opf, "%02x", encBuff[j] & 0xff);
+			fprintf(opf, "%02x", encBuff[i][j] & 0xff);
 		fprintf(opf, "\n");
 	}
 
 	/* Print statistics */
-	printf("Done. Elapsed hash time: %ld us\n", totalHash);
-	printf("Done. Elapsed hash time per iter: %ld us\n", totalHash / ITERS);
-	printf("Done. Elapsed cipher time: %ld us\n", totalAes);
-	printf("Done. Elapsed total time: %ld us\n", totalHash + totalAes);
+	printf("Done. Elapsed hash + cipher time: %ld us\n", totalSign);
+	printf("Done. Elapsed hash + cipher time per iter: %ld us\n", totalSign / ITERS);
 
 	crypt_terminate(&context);
 	mraa_aio_close(aio0);
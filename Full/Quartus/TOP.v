@@ -25,14 +25,47 @@
 /* * DEALINGS IN THE SOFTWARE.                                                                 * */
 /* ********************************************************************************************* */
 
-module TOP(
+module TOP#(
+		/* Number of SHA-256 cores. Each iterative core takes about 1000 registers (its message schedule included), */
+		/* so only one fits the MAX 10 of the BeMicro board (8K LEs) along with the manager */
+		parameter CORES = 1,
+		/* 1 to share a 64-stage pipelined core (sha256_pipe) among the CORES slots of the manager. It takes one */
+		/* block per cycle, but does not fit the MAX 10 of the BeMicro board */
+		parameter PIPELINED = 0,
+		/* Rounds per clock cycle of the iterative cores (1, 2 or 4). More rounds take more LUTs and shorten the time */
+		/* from init to digest_valid (66, 34 and 18 cycles) */
+		parameter ROUNDS_PER_CYCLE = 1,
+		/* Entries of the BATCH input FIFO (log2, 3 to 6). Entries (tag and 32 bytes of data) are kept in M9K blocks */
+		parameter FIFO_BITS = 6,
+		/* SPI data lines on each direction (1, 2 or 4) and transfers on both s_sclk edges (see SPISlaveStream) */
+		parameter LANES = 1,
+		parameter DDR = 0,
+		/* 1 to add the AES-256 core that signs SIGN requests on chip (the host signs on its own without it). It */
+		/* does not fit the MAX 10 of the BeMicro board along with the rest */
+		parameter AES = 0,
+		/* 1 to build HMAC (HKEY and THMAC) and performance counters (STATS) into the manager. INFO tells the host */
+		/* which features are there */
+		parameter HMAC = 1,
+		parameter STATS = 1,
+		/* 1 to build nonce search (SEARCH and RESULT) into the manager. It keeps about 1500 registers of its own, */
+		/* and is meant for designs with several cores */
+		parameter SEARCH = 0
+	) (
 		SYS_CLK,
 		PB,
 		USER_LED,
 
 		I2C_SCL,
 		I2C_SDA,
-		GPIO_A
+		GPIO_A,
+
+		GPIO_01,
+		GPIO_02,
+		GPIO_03,
+		GPIO_04,
+		GPIO_05,
+		GPIO_06,
+		GPIO_07
 	);
 
 	/* Input clock (50 Mhz) */
@@ -49,64 +82,148 @@ module TOP(
 	/* SPI: MISO */
 	output GPIO_A;
 
-	wire [255:0] wPMosi;
-	wire [255:0] wPMiso;
-	wire wPValid;
+	/* SPI: MOSI lanes 1 to 3 (LANES > 1) */
+	input GPIO_01;
+	input GPIO_02;
+	input GPIO_03;
+	/* SPI: MISO lanes 1 to 3 (LANES > 1) */
+	output GPIO_04;
+	output GPIO_05;
+	output GPIO_06;
+	/* Completion interrupt (see Manager) */
+	output GPIO_07;
+
+	wire [7:0] wPRx;
+	wire wPRxToggle;
+	wire [7:0] wPTx;
+	wire wPSync;
 	wire wShaResetN;
-	wire wShaInit;
-	wire wShaNext;
+	wire [CORES-1:0] wShaInit;
+	wire [CORES-1:0] wShaNext;
+	wire [CORES-1:0] wShaLoad;
 	wire wShaMode;
 	wire [511:0] wShaBlock;
-	wire [255:0] wShaDigest;
+	wire [255:0] wShaMidstate;
+	wire [(256*CORES)-1:0] wShaDigest;
+	wire [CORES-1:0] wShaDigestValid;
+	wire wAesStart;
+	wire [255:0] wAesKey;
+	wire [127:0] wAesBlock;
+	wire [127:0] wAesResult;
+	wire wAesResultValid;
 	wire [1:0] wUserLed;
+	wire [3:0] wMosi = {GPIO_03, GPIO_02, GPIO_01, I2C_SDA};
+	wire [LANES-1:0] wMiso;
 
 	assign USER_LED = {6'h3f, wUserLed[1], wUserLed[0]};
+	/* Unused MISO lanes are driven low */
+	assign {GPIO_06, GPIO_05, GPIO_04, GPIO_A} = wMiso;
 
 	/* SPI Slave Module */
-	SPISlaveDelayedResponse#(256, 40) spiinst(
+	SPISlaveStream#(LANES, DDR) spiinst(
 		.rst_n(PB[1]),
 
 		.s_sclk(I2C_SCL),
-		.s_mosi(I2C_SDA),
-		.s_miso(GPIO_A),
+		.s_mosi(wMosi[LANES-1:0]),
+		.s_miso(wMiso),
 
-		.p_mosi(wPMosi),
-		.p_miso(wPMiso),
-		.p_valid(wPValid)
+		.p_rx(wPRx),
+		.p_rx_toggle(wPRxToggle),
+		.p_tx(wPTx),
+		.p_sync(wPSync)
 	);
 
 	/* Communication and SHA-256 module manager */
-	Manager manager(
+	Manager#(CORES, FIFO_BITS, AES, HMAC, SEARCH, STATS) manager(
 		.clk(SYS_CLK),
 		.rst_n(PB[1]),
 
-		.p_mosi(wPMosi),
-		.p_miso(wPMiso),
-		.p_valid(wPValid),
+		.p_rx(wPRx),
+		.p_rx_toggle(wPRxToggle),
+		.p_tx(wPTx),
+		.p_sync(wPSync),
+		.irq(GPIO_07),
 
 		.sha_reset_n(wShaResetN),
 		.sha_init(wShaInit),
 		.sha_next(wShaNext),
+		.sha_load(wShaLoad),
 		.sha_mode(wShaMode),
 		.sha_block(wShaBlock),
-		.sha_digest(wShaDigest)
+		.sha_midstate(wShaMidstate),
+		.sha_digest(wShaDigest),
+		.sha_digest_valid(wShaDigestValid),
+
+		.aes_start(wAesStart),
+		.aes_key(wAesKey),
+		.aes_block(wAesBlock),
+		.aes_result(wAesResult),
+		.aes_result_valid(wAesResultValid)
 	);
 
-	/* SHA-256 Module */
-	sha256_core shainst(
-		.clk(SYS_CLK),
-		.reset_n(wShaResetN),
-
-		.init(wShaInit),
-		.next(wShaNext),
-		.mode(wShaMode),
-
-		.block(wShaBlock),
-
-		.ready(),
-		.digest(wShaDigest),
-		.digest_valid()
-	);
+	/* SHA-256 Modules, sharing the block bus */
+	genvar i;
+	generate
+		if(PIPELINED) begin: pipe
+			sha256_pipe#(CORES) shainst(
+				.clk(SYS_CLK),
+				.reset_n(wShaResetN),
+
+				.init(wShaInit),
+				.next(wShaNext),
+				.load(wShaLoad),
+				.mode(wShaMode),
+
+				.block(wShaBlock),
+				.midstate(wShaMidstate),
+
+				.ready(),
+				.digest(wShaDigest),
+				.digest_valid(wShaDigestValid)
+			);
+		end
+		else begin: iter
+			for(i = 0; i < CORES; i = i + 1) begin: sha
+				sha256_core#(ROUNDS_PER_CYCLE) shainst(
+					.clk(SYS_CLK),
+					.reset_n(wShaResetN),
+
+					.init(wShaInit[i]),
+					.next(wShaNext[i]),
+					.load(wShaLoad[i]),
+					.mode(wShaMode),
+
+					.block(wShaBlock),
+					.midstate(wShaMidstate),
+
+					.ready(),
+					.digest(wShaDigest[(256*i)+:256]),
+					.digest_valid(wShaDigestValid[i])
+				);
+			end
+		end
+	endgenerate
+
+	/* AES-256 module, signing digests of SIGN requests */
+	generate
+		if(AES) begin: aes
+			AES256Enc aesinst(
+				.clk(SYS_CLK),
+				.rst_n(PB[1]),
+
+				.start(wAesStart),
+				.key(wAesKey),
+				.block(wAesBlock),
+
+				.result(wAesResult),
+				.result_valid(wAesResultValid)
+			);
+		end
+		else begin: noaes
+			assign wAesResult = 'h0;
+			assign wAesResultValid = 'b0;
+		end
+	endgenerate
 
 	/* Activity LED for SPI */
 	ActivityLED act1(
@@ -122,7 +239,7 @@ module TOP(
 		.clk(SYS_CLK),
 		.rst_n(PB[1]),
 
-		.sig_in(wShaInit),
+		.sig_in(|wShaInit),
 		.led_out(wUserLed[1])
 	);
 
@@ -1,5 +1,5 @@
 /* ********************************************************************************************* */
-/* * Decipher data and display                                                                 * */
+/* * Block FIFO Module                                                                         * */
 /* * Authors:                                                                                  * */
 /* *     André Bannwart Perina                                                                 * */
 /* *     Luciano Falqueto                                                                      * */
@@ -25,59 +25,67 @@
 /* * DEALINGS IN THE SOFTWARE.                                                                 * */
 /* ********************************************************************************************* */
 
-#include <stdio.h>
+module BlockFIFO#(
+		/* Entry width */
+		parameter WIDTH = 8,
+		/* Number of entries (log2) */
+		parameter BITS = 4
+	) (
+		clk,
+		rst_n,
 
-#include "../include/crypt.h"
+		wr,
+		wr_data,
+		rd,
+		rd_data,
 
-#define MSG_LEN 32
-#define ITERS 128
+		empty,
+		full
+	);
 
-int main(void) {
-	int i, j;
-	FILE *ipf;
-	crypt_context_t context;
-	char readings[MSG_LEN + 1];
-	char hashBuff[41];
-	char encBuff[40];
-	char decBuff[MSG_LEN + 1];
+	/* Usual inputs */
+	input clk;
+	input rst_n;
 
-	ipf = fopen("data.out", "r");
-	crypt_initialise(&context);
-	/* For test purposes, the key is left wide open here */
-	crypt_set_key(&context, "abcdefghijklmnopqrstuvwxyz012345");
+	/* Write port. Writes to a full FIFO are dropped */
+	input wr;
+	input [WIDTH-1:0] wr_data;
+	/* Read port. rd_data holds the entry read on the cycle after rd (registered, so that memory blocks are inferred) */
+	input rd;
+	output [WIDTH-1:0] rd_data;
 
-	for(i = 0; i < MSG_LEN; i++)
-		readings[i] = 0;
+	output empty;
+	output full;
 
-	for(i = 0; i < 1024; i++) {
-		/* Read data from file (and convert it to raw when applicable) */
-		fscanf(ipf, "%s\n", (char *) &readings);
-		for(j = 0; j < 32; j++)
-			fscanf(ipf, "%02x", (unsigned int *) &hashBuff[j]);
-		for(j = 0; j < 32; j++)
-			fscanf(ipf, "%02x", (unsigned int *) &encBuff[j]);
+	reg [WIDTH-1:0] mem [0:(1<<BITS)-1];
+	reg [WIDTH-1:0] rdData;
+	/* Pointers have an extra bit, telling a full FIFO from an empty one */
+	reg [BITS:0] wrPtr;
+	reg [BITS:0] rdPtr;
 
-		/* Decipher signature */
-		crypt_aes_dec(&context, encBuff, decBuff, 32, "0123456789abcdef");
+	assign rd_data = rdData;
+	assign empty = (wrPtr == rdPtr);
+	assign full = (wrPtr == {~rdPtr[BITS], rdPtr[BITS-1:0]});
 
-		/* Print findings */
-		printf("Signature: ");
-		for(j = 0; j < 32; j++)
-			printf("%02x", encBuff[j] & 0xff);
-		printf("\n");
-		printf("Decoded hash: ");
-		for(j = 0; j < 32; j++)
-			printf("%02x", decBuff[j] & 0xff);
-		printf("\n");
-		printf("Original hash: ");
-		for(j = 0; j < 32; j++)
-			printf("%02x", hashBuff[j] & 0xff);
-		printf("\n");
-		printf("Data: %s\n\n", readings);
-	}
+	/* Memory has no reset */
+	always @(posedge clk) begin
+		if(wr && !full)
+			mem[wrPtr[BITS-1:0]] <= wr_data;
+		if(rd)
+			rdData <= mem[rdPtr[BITS-1:0]];
+	end
 
-	crypt_terminate(&context);
-	fclose(ipf);
+	always @(posedge clk or negedge rst_n) begin
+		if(!rst_n) begin
+			wrPtr <= 'h0;
+			rdPtr <= 'h0;
+		end
+		else begin
+			if(wr && !full)
+				wrPtr <= wrPtr + 'h1;
+			if(rd && !empty)
+				rdPtr <= rdPtr + 'h1;
+		end
+	end
 
-	return 0;
-}
+endmodule
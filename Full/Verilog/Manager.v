@@ -25,60 +25,886 @@
 /* * DEALINGS IN THE SOFTWARE.                                                                 * */
 /* ********************************************************************************************* */
 
-module Manager(
+module Manager#(
+		/* Number of SHA-256 cores (1 to 127) */
+		parameter CORES = 1,
+		/* Entries of the BATCH input FIFO (log2, 3 to 6) */
+		parameter FIFO_BITS = 6,
+		/* 1 when an AES-256 core (AES256Enc) is attached: AKEY and SIGN are taken */
+		parameter AES = 1,
+		/* 1 to take HKEY and THMAC (HMAC key midstates kept on chip) */
+		parameter HMAC = 1,
+		/* 1 to take SEARCH and RESULT (nonce search) */
+		parameter SEARCH = 1,
+		/* 1 to take STATS (performance counters) */
+		parameter STATS = 1
+	) (
 		clk,
 		rst_n,
 
-		p_mosi,
-		p_miso,
-		p_valid,
+		p_rx,
+		p_rx_toggle,
+		p_tx,
+		p_sync,
+		irq,
 
 		sha_reset_n,
 		sha_init,
 		sha_next,
+		sha_load,
 		sha_mode,
 		sha_block,
-		sha_digest
+		sha_midstate,
+		sha_digest,
+		sha_digest_valid,
+
+		aes_start,
+		aes_key,
+		aes_block,
+		aes_result,
+		aes_result_valid
 	);
 
+	/* ************************************************************* */
+	/* Protocol: the host sends commands, each one a command byte    */
+	/* followed by a fixed number of bytes:                          */
+	/*                                                               */
+	/* NOP:    0x00                                                  */
+	/* SHORT:  0x01, 32 bytes of data. Data is hashed as a whole     */
+	/*         32-byte message                                       */
+	/* INIT:   0x02, 64-byte block. First block of a message         */
+	/* NEXT:   0x03, 64-byte block. Chained to previous block        */
+	/* DIGEST: 0x04. Sends digest of last block                      */
+	/* TSHORT: 0x05, tag (0 to 127), 32 bytes of data. Same as SHORT */
+	/*         on the next core, round-robin, with a tagged response */
+	/* INFO:   0x06. Sends device information (byte 0: CORES, byte   */
+	/*         1: features, bit 0 set for HKEY and THMAC, bit 1 for  */
+	/*         BATCH, bit 2 for READ and status, bit 3 for CRC, bit  */
+	/*         4 for TDOUBLE, bit 5 for SEARCH and RESULT, bit 6 for */
+	/*         AKEY and SIGN, bit 7 for STATS; byte 2: BATCH FIFO    */
+	/*         entries). Bits 0, 5, 6 and 7 follow parameters HMAC, */
+	/*         SEARCH, AES and STATS, and commands of features left  */
+	/*         out are dropped. The others are always built          */
+	/* LOAD:   0x07, 32 bytes of hash value (H0 to H7, big endian).  */
+	/*         NEXT blocks are chained to this midstate, and DIGEST  */
+	/*         sends the raw hash value after them                   */
+	/* HKEY:   0x08, 32 bytes of inner and 32 bytes of outer HMAC    */
+	/*         midstate (hash value after key ^ ipad and key ^ opad) */
+	/* THMAC:  0x09, tag, 32 bytes of data. Same as TSHORT, but the  */
+	/*         core chains the inner and outer hashes of HMAC-SHA256 */
+	/*         with the HKEY midstates and sends the MAC back        */
+	/* BATCH:  0x0A, tag, count (1 to 255), count times 32 bytes of  */
+	/*         data. Same as count TSHORT commands, tagged from tag  */
+	/*         on (modulo 128), queued in a FIFO. With bit 7 of tag  */
+	/*         set, same as count TDOUBLE commands instead           */
+	/* READ:   0x0B. Sends status and the digest of core 0 right     */
+	/*         away, one byte after the command                      */
+	/* CRC:    0x0C, mode (bit 0 set for CRC frames), CRC. Carries   */
+	/*         its CRC whatever the mode                             */
+	/* TDOUBLE: 0x0D, tag, 32 bytes of data. Same as TSHORT, but the */
+	/*         core hashes the digest again, padded on chip, and     */
+	/*         sends SHA-256(SHA-256(data)) back                     */
+	/* SEARCH: 0x0E, offset (bits 5:0: byte offset of the nonce in   */
+	/*         the block; bit 7 set to chain to the hash value of    */
+	/*         core 0, as NEXT, rather than start from H0), zero     */
+	/*         bits, limit (32 bits, big endian, 0 for 2^32),        */
+	/*         64-byte block, padded by the host. Tries limit nonces */
+	/*         (32 bits, big endian) from the one in the block on,   */
+	/*         on all free cores, until a digest starts with zero    */
+	/*         bits zero bits                                        */
+	/* RESULT: 0x0F. Sends status, then the digest of the last       */
+	/*         SEARCH, its nonce and its attempts (32 bits each, big */
+	/*         endian) right away, as READ. Digest is all ones, and  */
+	/*         nonce the next one to try, if none matched            */
+	/* AKEY:   0x10, 32 bytes of AES-256 key, 16 bytes of IV         */
+	/* SIGN:   0x11, tag, count (1 to 255), count times 32 bytes of  */
+	/*         data. Same as BATCH, but each response carries the    */
+	/*         AES-256-CBC signature of the digest (AKEY key and IV, */
+	/*         two blocks) after it: 64 bytes                        */
+	/* STATS:  0x12. Sends status, then the counters right away, as  */
+	/*         READ: clock cycles, core cycles busy and idle (48     */
+	/*         bits each), commands taken, commands dropped (32 bits */
+	/*         each) and longest hash (16 bits), big endian          */
+	/* SYNC:   0xFF. Arms bit realignment (see below)                */
+	/*                                                               */
+	/* Digests of SHORT and DIGEST commands (and INFO) are sent on   */
+	/* MISO DELAY bytes after the command ends, while the host keeps */
+	/* sending NOPs or further commands. MISO carries the status     */
+	/* byte elsewhere. As the digest takes 32 bytes, a SHORT command */
+	/* may follow another right away: data of request N+1 goes in    */
+	/* while digest of request N comes out. SHORT, INIT, NEXT and    */
+	/* DIGEST use core 0 only, as does LOAD.                         */
+	/*                                                               */
+	/* TSHORT requests go to the next free core, round-robin. Their  */
+	/* responses are sent as soon as the core is done and MISO is    */
+	/* free: a header byte (0x80 | tag) and 32 bytes of digest. The  */
+	/* host matches them by tag, as they may come out of order, and  */
+	/* may keep up to CORES requests in flight. As there is no fixed */
+	/* delay, SCLK is not limited by the core latency. TSHORT, THMAC */
+	/* and TDOUBLE may be mixed, but not the other commands.         */
+	/*                                                               */
+	/* BATCH data goes into the FIFO with no framing bytes between   */
+	/* entries, and free cores take them in order. The whole batch   */
+	/* fits in a single transfer: responses are sent as for TSHORT,  */
+	/* so while MOSI carries 32 bytes per entry, MISO carries 33 per */
+	/* response. As long as cores are faster than the bus, the FIFO  */
+	/* only fills by about one entry every 32. The host ends the     */
+	/* transfer (or sends NOPs) before that reaches the FIFO size,   */
+	/* as writes to a full FIFO are dropped. BATCH may follow other  */
+	/* tagged commands once their responses are in.                  */
+	/*                                                               */
+	/* SEARCH takes the cores over: each free core starts on the     */
+	/* next nonce, as soon as it is free, so that the search runs at */
+	/* the speed of the cores rather than of the bus. Cores finish   */
+	/* in the order they start, so the first digest that matches has */
+	/* the lowest nonce. Only NOP, READ, RESULT, INFO and STATS may  */
+	/* be sent until status bit 0 (and irq) tells the search is      */
+	/* over. Attempts are the digests checked until then. Commands   */
+	/* to core 0 (as LOAD and SEARCH sent again after a link error)  */
+	/* end it before that, and the digests of cores still on it are  */
+	/* dropped. Core 0 drops its nonce right away to take the        */
+	/* command, as the SHA-256 cores take a new block (or midstate)  */
+	/* even while busy.                                              */
+	/*                                                               */
+	/* SIGN digests go to the AES-256 core (AES256Enc) one at a      */
+	/* time, as their cores are done, and take about 32 cycles       */
+	/* there. A core is kept until its response is out, and the AES  */
+	/* core until the response starts: as MISO takes 65 bytes per    */
+	/* response, it is always free again by the time the next digest */
+	/* is done. AKEY is only sent with no SIGN response due.         */
+	/*                                                               */
+	/* Counters run from reset on, and tell whether the bus or the   */
+	/* cores hold the host back (the host compares two STATS). Busy  */
+	/* cycles are those a core spends hashing, from init or next     */
+	/* until its digest is valid, summed over all cores; idle ones   */
+	/* the rest, waiting for SPI to bring a request or take a        */
+	/* response out. Commands taken are all but NOP and SYNC, each   */
+	/* BATCH or SIGN entry counting as one, and commands dropped     */
+	/* those that failed their CRC. The longest hash is in cycles,   */
+	/* from init or next until the digest is valid.                  */
+	/*                                                               */
+	/* SPI has no chip select, so a stray s_sclk cycle shifts every  */
+	/* later byte by a beat (two with DDR). To realign, the host     */
+	/* sends at least 73 SYNC bytes, then NOPs. Ones fill whatever   */
+	/* command the shifted bytes started (a BATCH may take up to     */
+	/* 8700), and are read as SYNC bytes after that. p_sync is high  */
+	/* from a SYNC byte taken between commands to the next byte, and */
+	/* while it is, SPISlaveStream starts a byte on the first beat   */
+	/* of zeros after a beat of ones: the first NOP. A slip of whole */
+	/* s_sclk cycles is undone this way. Ones and zeros read the     */
+	/* same whatever the shift, and as the host never sends SYNC     */
+	/* otherwise, aligned bytes are left as they are. With DDR,      */
+	/* bytes only start on rising edges, so a slip of half a cycle   */
+	/* (a single stray edge) is not undone, and the FPGA must be     */
+	/* reset. With 4 lanes and DDR, a cycle is a whole byte: a stray */
+	/* one only adds a byte, that the SYNC bytes absorb, and bytes   */
+	/* never need realigning.                                        */
+	/*                                                               */
+	/* Padding of INIT/NEXT messages is done by the host. DELAY      */
+	/* bytes give the core time to finish the last block (40 s_sclk  */
+	/* cycles, as in SPISlaveDelayedResponse#(256, 40)).             */
+	/*                                                               */
+	/* As DELAY is counted in bytes, fast buses may read a digest    */
+	/* before it is done. The status byte tells when it is: 0x40,    */
+	/* with bit 0 set while core 0 holds the digest of its last      */
+	/* command, bit 1 while a tagged response is waiting and bit 2   */
+	/* once all tagged requests are done. The host may poll it with  */
+	/* NOPs, or wait for irq, and then send READ. READ also sends    */
+	/* status first, so that a READ sent too early is simply         */
+	/* repeated. irq is high while a tagged response is waiting or   */
+	/* being sent, and once the digest of a core 0 command is done,  */
+	/* until it is read.                                             */
+	/*                                                               */
+	/* In CRC mode, commands with payload (and each BATCH entry) end */
+	/* with the CRC-16 of their bytes, command byte included (CCITT  */
+	/* polynomial 0x1021 from 0xFFFF, most significant byte first).  */
+	/* A command that fails it is dropped, and bit 3 of the status   */
+	/* byte is set until the next CRC command. Bits 5:4 count the    */
+	/* SHORT, INIT, NEXT, LOAD, HKEY, SEARCH and AKEY commands taken */
+	/* (modulo 4), cleared by CRC as well, so that the host also     */
+	/* finds out about commands whose command byte was corrupted     */
+	/* into a NOP. READ does not clear either, as corrupted bytes    */
+	/* may pass for it. BATCH (and SIGN) tags move on past dropped   */
+	/* entries, so that the host knows which ones are missing.       */
+	/* Responses (after DELAY, READ, RESULT, STATS and tagged) end   */
+	/* with the CRC-16 of their bytes as well, header or status      */
+	/* included.                                                     */
+	/* ************************************************************* */
+
+	/* Commands */
+	localparam CMD_NOP = 8'h00;
+	localparam CMD_SHORT = 8'h01;
+	localparam CMD_INIT = 8'h02;
+	localparam CMD_NEXT = 8'h03;
+	localparam CMD_DIGEST = 8'h04;
+	localparam CMD_TSHORT = 8'h05;
+	localparam CMD_INFO = 8'h06;
+	localparam CMD_LOAD = 8'h07;
+	localparam CMD_HKEY = 8'h08;
+	localparam CMD_THMAC = 8'h09;
+	localparam CMD_BATCH = 8'h0A;
+	localparam CMD_READ = 8'h0B;
+	localparam CMD_CRC = 8'h0C;
+	localparam CMD_TDOUBLE = 8'h0D;
+	localparam CMD_SEARCH = 8'h0E;
+	localparam CMD_RESULT = 8'h0F;
+	localparam CMD_AKEY = 8'h10;
+	localparam CMD_SIGN = 8'h11;
+	localparam CMD_STATS = 8'h12;
+	localparam CMD_SYNC = 8'hFF;
+	/* Bytes between the last byte of a block and the first byte of its digest */
+	localparam DELAY = 5;
+	/* Device information, sent by INFO */
+	localparam [7:0] INFO_CORES = CORES;
+	localparam [7:0] INFO_FEATURES = {(STATS != 0), (AES != 0), (SEARCH != 0), 4'hF, (HMAC != 0)};
+	localparam [7:0] INFO_FIFO = 1 << FIFO_BITS;
+	/* Status byte: flag (so that it is never mistaken for zeroes or a tagged response header) and bits */
+	localparam [7:0] STATUS_FLAG = 8'h40;
+	localparam STATUS_DONE = 0;
+	localparam STATUS_PENDING = 1;
+	localparam STATUS_IDLE = 2;
+	localparam STATUS_ERROR = 3;
+	localparam STATUS_COUNT = 4;
+
 	/* Usual inputs */
 	input clk;
 	input rst_n;
 
-	/* Parallel bus */
-	input [255:0] p_mosi;
-	output [255:0] p_miso;
-	input p_valid;
+	/* Byte stream from/to SPI slave */
+	input [7:0] p_rx;
+	input p_rx_toggle;
+	output [7:0] p_tx;
+	/* High while the SPI slave may realign bytes */
+	output p_sync;
+	/* Completion interrupt (active high) */
+	output irq;
 
-	/* IO to/from SHA-256 module */
+	/* IO to/from SHA-256 modules. Block is shared, as cores only read it on init/next */
 	output sha_reset_n;
-	output sha_init;
-	output sha_next;
+	output [CORES-1:0] sha_init;
+	output [CORES-1:0] sha_next;
+	output [CORES-1:0] sha_load;
 	output sha_mode;
 	output [511:0] sha_block;
-	input [255:0] sha_digest;
+	output [255:0] sha_midstate;
+	input [(256*CORES)-1:0] sha_digest;
+	input [CORES-1:0] sha_digest_valid;
+
+	/* IO to/from the AES-256 core */
+	output aes_start;
+	output [255:0] aes_key;
+	output [127:0] aes_block;
+	input [127:0] aes_result;
+	input aes_result_valid;
+
+	reg [2:0] rxTogglePrev;
+	reg [7:0] cmd;
+	reg [6:0] count;
+	reg [511:0] block;
+	reg [6:0] rxTag;
+	reg [CORES-1:0] init;
+	reg [CORES-1:0] next;
+	reg [CORES-1:0] load;
+	reg [6:0] rrCore;
+	reg [6:0] freeCore;
+	reg [6:0] core;
+	reg [CORES-1:0] busy;
+	reg [CORES-1:0] pending;
+	reg [CORES-1:0] validPrev;
+	reg [CORES-1:0] innerPass;
+	reg [CORES-1:0] doublePass;
+	reg [CORES-1:0] outerWait;
+	reg [6:0] outerCore;
+	reg loadOuter;
+	reg outerDouble;
+	reg [255:0] outerData;
+	reg [255:0] ipad;
+	reg [255:0] opad;
+	reg [(7*CORES)-1:0] coreTag;
+	reg [2:0] outWait;
+	reg outInfo;
+	reg [6:0] outLeft;
+	reg [519:0] out;
+	reg [7:0] tx;
+	reg [6:0] respCore;
+	reg [7:0] batchLeft;
+	reg [5:0] batchByte;
+	reg [6:0] batchTag;
+	reg batchDouble;
+	reg batchSign;
+	reg fifoLoad;
+	reg [6:0] fifoCore;
+	reg core0Done;
+	reg irqCore0;
+	reg crcMode;
+	reg [15:0] crcIn;
+	reg [15:0] crcOut;
+	reg [1:0] outCrc;
+	reg frameError;
+	reg syncArm;
+	reg [1:0] cmdCount;
+	reg searching;
+	reg searchMode;
+	reg searchFound;
+	reg searchChain;
+	reg searchLoad;
+	reg [47:0] searchArgs;
+	reg [5:0] searchOffset;
+	reg [255:0] searchMask;
+	reg [32:0] searchLeft;
+	reg [31:0] searchNonce;
+	reg [31:0] loadNonce;
+	reg [31:0] searchAttempts;
+	reg [31:0] searchResult;
+	reg [255:0] searchDigest;
+	reg [255:0] searchMid;
+	reg [511:0] searchBlock;
+	reg [511:0] searchData;
+	reg [31:0] cmdNonce;
+	reg [CORES-1:0] searchPass;
+	reg [CORES-1:0] searchWait;
+	reg [CORES-1:0] searchStale;
+	reg [6:0] searchCore;
+	reg [(32*CORES)-1:0] coreNonce;
+	reg [255:0] aesKey;
+	reg [127:0] aesIv;
+	reg aesStart;
+	reg aesRun;
+	reg [127:0] aesBlock;
+	reg [CORES-1:0] signPass;
+	reg [CORES-1:0] signWait;
+	reg [6:0] signCore;
+	reg [6:0] waitCore;
+	reg signing;
+	reg signHalf;
+	reg [127:0] signFirst;
+	reg [255:0] signature;
+	reg [CORES-1:0] running;
+	reg [(16*CORES)-1:0] runCycles;
+	reg [7:0] runCount;
+	reg [15:0] doneCycles;
+	reg [47:0] perfCycles;
+	reg [47:0] perfBusy;
+	reg [47:0] perfIdle;
+	reg [31:0] perfCommands;
+	reg [31:0] perfErrors;
+	reg [15:0] perfLatency;
+	integer i;
+	integer j;
+	integer k;
+	integer m;
+	integer b;
+	integer n;
+	integer q;
+	integer r;
+
+	/* CRC-16 (CCITT) after a byte, from the CRC so far */
+	function [15:0] crc16;
+		input [15:0] crc;
+		input [7:0] data;
+		integer b;
+		begin
+			crc16 = crc;
+			for(b = 7; b >= 0; b = b - 1)
+				crc16 = {crc16[14:0], 1'b0} ^ ((crc16[15] ^ data[b])? 16'h1021 : 16'h0);
+		end
+	endfunction
+
+	/* p_rx_toggle is synchronised by rxTogglePrev[1:0]. A byte is received when it changes */
+	wire rxStrobe = rxTogglePrev[2] ^ rxTogglePrev[1];
+	/* Command of the byte being received (first byte of a command is the command itself) */
+	wire [7:0] rxCmd = count? cmd : p_rx;
+	/* Index of last payload byte of rxCmd (BATCH data is not counted) */
+	wire [6:0] payloadLast = ((CMD_SHORT == rxCmd) || (CMD_LOAD == rxCmd))? 32 : ((CMD_TSHORT == rxCmd) || (CMD_THMAC == rxCmd) || (CMD_TDOUBLE == rxCmd))? 33 :
+		((CMD_INIT == rxCmd) || (CMD_NEXT == rxCmd) || (CMD_HKEY == rxCmd))? 64 : ((CMD_BATCH == rxCmd) || (CMD_SIGN == rxCmd))? 2 :
+		(CMD_CRC == rxCmd)? 1 : (CMD_SEARCH == rxCmd)? 70 : (CMD_AKEY == rxCmd)? 48 : 0;
+	/* Commands with payload end with two CRC bytes in CRC mode, CRC commands always do */
+	wire crcTrailer = (crcMode && payloadLast) || (CMD_CRC == rxCmd);
+	/* Index of last byte of rxCmd */
+	wire [6:0] cmdLast = payloadLast + (crcTrailer? 'd2 : 'd0);
+	/* Command of a feature left out of the design. The host does not send those, as INFO tells */
+	wire cmdOff = (!HMAC && ((CMD_HKEY == rxCmd) || (CMD_THMAC == rxCmd))) || (!SEARCH && ((CMD_SEARCH == rxCmd) || (CMD_RESULT == rxCmd))) ||
+		(!AES && ((CMD_AKEY == rxCmd) || (CMD_SIGN == rxCmd))) || (!STATS && (CMD_STATS == rxCmd));
+	/* Last byte of a BATCH entry */
+	wire [5:0] entryLast = crcMode? 'd33 : 'd31;
+	/* CRC of the command (or BATCH entry) so far, byte being received included. It is zero after a good CRC */
+	wire [15:0] crcNext = crc16((batchLeft? !batchByte : !count)? 16'hFFFF : crcIn, p_rx);
+	wire cmdOk = !crcTrailer || !crcNext;
+	/* Last byte of a SHORT, DIGEST or INFO command: response is sent DELAY bytes later */
+	wire outStart = !batchLeft && (count == cmdLast) && cmdOk && ((CMD_SHORT == rxCmd) || (CMD_DIGEST == rxCmd) || (CMD_INFO == rxCmd));
+	/* READ (or RESULT, or STATS) command: status and digest (or search result, or counters) are sent right away */
+	wire readStart = !batchLeft && !count && !cmdOff && ((CMD_READ == rxCmd) || (CMD_RESULT == rxCmd) || (CMD_STATS == rxCmd));
+	/* Device information */
+	wire [255:0] info = {INFO_CORES, INFO_FEATURES, INFO_FIFO, 232'h0};
+	/* Block register once the byte being received is in */
+	wire [511:0] blockNext = {block[503:0], p_rx};
+	/* Payload on the last byte of a command (CRC bytes are not shifted in) */
+	wire [511:0] cmdBlock = crcTrailer? block : blockNext;
+	/* Cores that just finished a tagged request */
+	wire [CORES-1:0] coreDone = busy & sha_digest_valid & ~validPrev;
+	wire fifoEmpty;
+	wire [264:0] fifoData;
+	/* Last byte of a BATCH entry: entry goes into the FIFO with its tag, unless it fails its CRC */
+	wire fifoWr = rxStrobe && batchLeft && (entryLast == batchByte) && (!crcMode || !crcNext);
+	/* FIFO entry is taken by a free core on cycles with the block bus free */
+	wire fifoRd = !fifoEmpty && !(&busy) && !rxStrobe && !outerWait;
+	/* Next nonce of a SEARCH is taken by a free core on cycles with the block bus free as well */
+	wire searchStart = SEARCH && searching && !searchFound && searchLeft && !(&busy) && !rxStrobe && !outerWait && !fifoRd;
+
+	/* BATCH input FIFO (signature flag, SHA-256d flag, tag and data) */
+	BlockFIFO#(265, FIFO_BITS) fifo(
+		.clk(clk),
+		.rst_n(rst_n),
+
+		.wr(fifoWr),
+		.wr_data({batchSign, batchDouble, batchTag, (crcMode? block[255:0] : blockNext[255:0])}),
+		.rd(fifoRd),
+		.rd_data(fifoData),
+
+		.empty(fifoEmpty),
+		.full()
+	);
+
+	/* Status byte */
+	wire idle = !busy && fifoEmpty && !batchLeft && !searching;
+	wire [7:0] status = STATUS_FLAG | (core0Done << STATUS_DONE) | ((|pending) << STATUS_PENDING) | (idle << STATUS_IDLE) |
+		(frameError << STATUS_ERROR) | (cmdCount << STATUS_COUNT);
+
+	/* Lowest core with a tagged response waiting */
+	always @* begin
+		respCore = 'h0;
+		for(i = CORES - 1; i >= 0; i = i - 1) begin
+			if(pending[i])
+				respCore = i;
+		end
+	end
+
+	/* Lowest core with the inner hash of a THMAC done */
+	always @* begin
+		outerCore = 'h0;
+		for(k = CORES - 1; k >= 0; k = k - 1) begin
+			if(outerWait[k])
+				outerCore = k;
+		end
+	end
+
+	/* Lowest core with a SEARCH digest to be checked */
+	always @* begin
+		searchCore = 'h0;
+		for(m = CORES - 1; m >= 0; m = m - 1) begin
+			if(searchWait[m])
+				searchCore = m;
+		end
+	end
+
+	/* Lowest core with a SIGN digest waiting for the AES core */
+	always @* begin
+		waitCore = 'h0;
+		for(n = CORES - 1; n >= 0; n = n - 1) begin
+			if(signWait[n])
+				waitCore = n;
+		end
+	end
 
-	reg [1:0] pValidPrev;
+	/* Cores hashing, and the longest hash of those just done */
+	always @* begin
+		runCount = 'h0;
+		doneCycles = 'h0;
+		for(q = 0; q < CORES; q = q + 1) begin
+			runCount = runCount + running[q];
+			if(running[q] && sha_digest_valid[q] && !validPrev[q] && (runCycles[(16*q)+:16] > doneCycles))
+				doneCycles = runCycles[(16*q)+:16];
+		end
+	end
 
-	assign p_miso = sha_digest;
-	/* First cycle after rising edge of p_valid: Reset SHA-256 module */
-	assign sha_reset_n = !(p_valid && !pValidPrev[0]);
-	/* Second cycle after rising edge of p_valid: Init SHA-256 module */
-	assign sha_init = (pValidPrev[0] && !pValidPrev[1]);
-	assign sha_next = 'b0;
+	/* Nonce field of the SEARCH block being received (byte offset from its first byte), and the search block with */
+	/* the nonce of the core being started */
+	always @* begin
+		cmdNonce = 'h0;
+		searchData = searchBlock;
+		for(b = 0; b <= 60; b = b + 1) begin
+			if(b == searchArgs[45:40])
+				cmdNonce = cmdBlock[(480 - (8 * b))+:32];
+			if(b == searchOffset)
+				searchData[(480 - (8 * b))+:32] = loadNonce;
+		end
+	end
+
+	/* First free core from rrCore on. Host keeps at most CORES requests in flight (not counting the FIFO), so */
+	/* there is always one for TSHORT and THMAC */
+	always @* begin
+		freeCore = rrCore;
+		for(j = CORES - 1; j >= 0; j = j - 1) begin
+			core = ((rrCore + j) >= CORES)? (rrCore + j - CORES) : (rrCore + j);
+			if(!busy[core])
+				freeCore = core;
+		end
+	end
+
+	assign p_tx = tx;
+	assign p_sync = syncArm;
+	assign irq = (|pending) || (|outLeft) || (|outCrc) || (irqCore0 && core0Done);
+	/* Cores are only reset along with the rest of the design, so that chained blocks keep their state */
+	assign sha_reset_n = rst_n;
+	assign sha_init = init;
+	assign sha_next = next;
+	assign sha_load = load;
 	assign sha_mode = 'b1;
-	/* Only 32 bytes are used. The rest is set to standard SHA padding */
-	assign sha_block = {p_mosi, 1'b1, 255'h100};
+	/* SHORT commands only use 32 bytes. The rest is set to standard SHA padding, for 256 bits (or 768 bits for both */
+	/* HMAC hashes, as the 64-byte key block comes first). The second hash of SHA-256d is a 32-byte message as well. */
+	/* SEARCH blocks are padded by the host */
+	assign sha_block = (SEARCH && searchLoad)? searchData : loadOuter? {outerData, 1'b1, (outerDouble? 255'h100 : 255'h300)} : fifoLoad? {fifoData[255:0], 1'b1, 255'h100} :
+		(HMAC && (CMD_THMAC == cmd))? {block[255:0], 1'b1, 255'h300} : ((CMD_SHORT == cmd) || (CMD_TSHORT == cmd) || (CMD_TDOUBLE == cmd))? {block[255:0], 1'b1, 255'h100} :
+		block;
+	/* LOAD payload is the last 32 bytes shifted in. HMAC hashes start from the key midstates, chained SEARCH from the */
+	/* hash value core 0 had */
+	assign sha_midstate = (SEARCH && searchLoad)? searchMid : loadOuter? opad : (HMAC && (CMD_THMAC == cmd))? ipad : block[255:0];
+	assign aes_start = aesStart;
+	assign aes_key = aesKey;
+	assign aes_block = aesBlock;
 
 	always @(posedge clk or negedge rst_n) begin
 		if(!rst_n) begin
-			pValidPrev <= 'b11;
+			rxTogglePrev <= 'b0;
+			cmd <= CMD_NOP;
+			count <= 'h0;
+			init <= 'h0;
+			next <= 'h0;
+			load <= 'h0;
+			rrCore <= 'h0;
+			busy <= 'h0;
+			pending <= 'h0;
+			validPrev <= 'h0;
+			innerPass <= 'h0;
+			doublePass <= 'h0;
+			outerWait <= 'h0;
+			loadOuter <= 'b0;
+			outerDouble <= 'b0;
+			searching <= 'b0;
+			searchMode <= 'b0;
+			searchFound <= 'b0;
+			searchLoad <= 'b0;
+			searchPass <= 'h0;
+			searchWait <= 'h0;
+			searchStale <= 'h0;
+			signPass <= 'h0;
+			signWait <= 'h0;
+			signing <= 'b0;
+			aesStart <= 'b0;
+			aesRun <= 'b0;
+			batchLeft <= 'h0;
+			fifoLoad <= 'b0;
+			core0Done <= 'b0;
+			irqCore0 <= 'b0;
+			crcMode <= 'b0;
+			crcIn <= 'h0;
+			outCrc <= 'h0;
+			frameError <= 'b0;
+			syncArm <= 'b0;
+			cmdCount <= 'h0;
+			outWait <= 'h0;
+			outInfo <= 'b0;
+			outLeft <= 'h0;
+			tx <= 'h0;
+			running <= 'h0;
+			perfCycles <= 'h0;
+			perfBusy <= 'h0;
+			perfIdle <= 'h0;
+			perfCommands <= 'h0;
+			perfErrors <= 'h0;
+			perfLatency <= 'h0;
 		end
 		else begin
-			/* pValidPrev[0] holds last p_valid value */
-			pValidPrev[0] <= p_valid;
-			/* pValidPrev[1] holds second last p_valid value */
-			pValidPrev[1] <= pValidPrev[0];
+			rxTogglePrev <= {rxTogglePrev[1:0], p_rx_toggle};
+
+			/* Counters. A core runs from the cycle it is started on until its digest is valid */
+			running <= (running & ~(sha_digest_valid & ~validPrev)) | init | next;
+			for(r = 0; r < CORES; r = r + 1)
+				runCycles[(16*r)+:16] <= (init[r] || next[r])? 'h1 : (runCycles[(16*r)+:16] + running[r]);
+			perfCycles <= perfCycles + 'h1;
+			perfBusy <= perfBusy + runCount;
+			perfIdle <= perfIdle + (CORES - runCount);
+			if(doneCycles > perfLatency)
+				perfLatency <= doneCycles;
+
+			init <= 'h0;
+			next <= 'h0;
+			load <= 'h0;
+
+			/* Core 0 is done once its digest is valid, not counting the cycle it is started on. After SEARCH, once the */
+			/* search is over */
+			core0Done <= searchMode? !searching : (sha_digest_valid[0] && !init[0] && !next[0] && !load[0]);
+
+			/* A tagged response is waiting from the moment its core is done */
+			validPrev <= sha_digest_valid;
+			pending <= pending | (coreDone & ~innerPass & ~searchPass & ~signPass);
+
+			/* Outer hash of a THMAC (or second hash of a TDOUBLE, from H0) starts once the first one is done, on the */
+			/* same core. Bytes received start cores on the cycle after rxStrobe, so this is done on other cycles to */
+			/* have the block bus to itself */
+			outerWait <= outerWait | (coreDone & innerPass);
+			loadOuter <= 'b0;
+			if(outerWait && !rxStrobe) begin
+				init[outerCore] <= doublePass[outerCore];
+				load[outerCore] <= !doublePass[outerCore];
+				next[outerCore] <= !doublePass[outerCore];
+				loadOuter <= 'b1;
+				outerDouble <= doublePass[outerCore];
+				outerData <= sha_digest[(256*outerCore)+:256];
+				outerWait[outerCore] <= 'b0;
+				innerPass[outerCore] <= 'b0;
+				doublePass[outerCore] <= 'b0;
+			end
+
+			/* FIFO entries start like TSHORT requests, the cycle after they are read */
+			fifoLoad <= fifoRd;
+			if(fifoRd) begin
+				init[freeCore] <= 'b1;
+				busy[freeCore] <= 'b1;
+				fifoCore <= freeCore;
+				rrCore <= ((CORES - 1) == freeCore)? 'h0 : (freeCore + 'h1);
+			end
+			if(fifoLoad) begin
+				coreTag[(7*fifoCore)+:7] <= fifoData[262:256];
+				innerPass[fifoCore] <= fifoData[263];
+				doublePass[fifoCore] <= fifoData[263];
+				signPass[fifoCore] <= AES && fifoData[264];
+			end
+
+			/* SIGN digests wait for the AES core, which ciphers the first half XOR the IV, then the second half XOR */
+			/* the first ciphered block (CBC). Response is sent once both are done, as for other tagged requests */
+			signWait <= signWait | (coreDone & ~innerPass & signPass);
+			aesStart <= 'b0;
+			if(signWait && !signing) begin
+				signing <= 'b1;
+				signHalf <= 'b0;
+				signCore <= waitCore;
+				signWait[waitCore] <= 'b0;
+				aesStart <= 'b1;
+				aesRun <= 'b1;
+				aesBlock <= sha_digest[((256*waitCore)+128)+:128] ^ aesIv;
+			end
+			else if(aesRun && aes_result_valid && !aesStart) begin
+				signHalf <= 'b1;
+				signFirst <= aes_result;
+				aesStart <= !signHalf;
+				aesRun <= !signHalf;
+				aesBlock <= sha_digest[(256*signCore)+:128] ^ aes_result;
+				if(signHalf) begin
+					signature <= {signFirst, aes_result};
+					pending[signCore] <= 'b1;
+				end
+			end
+
+			/* SEARCH nonces start like FIFO entries, the cycle after they are taken */
+			searchLoad <= searchStart;
+			if(searchStart) begin
+				init[freeCore] <= !searchChain;
+				load[freeCore] <= searchChain;
+				next[freeCore] <= searchChain;
+				busy[freeCore] <= 'b1;
+				searchPass[freeCore] <= 'b1;
+				searchStale[freeCore] <= 'b0;
+				signPass[freeCore] <= 'b0;
+				coreNonce[(32*freeCore)+:32] <= searchNonce;
+				loadNonce <= searchNonce;
+				searchNonce <= searchNonce + 'h1;
+				searchLeft <= searchLeft - 'h1;
+				rrCore <= ((CORES - 1) == freeCore)? 'h0 : (freeCore + 'h1);
+			end
+
+			/* SEARCH digests are checked one per cycle, and counted until one matches (unless they are left from a */
+			/* previous SEARCH). Core is free then */
+			searchWait <= searchWait | (coreDone & searchPass);
+			if(searchWait) begin
+				busy[searchCore] <= 'b0;
+				searchPass[searchCore] <= 'b0;
+				searchWait[searchCore] <= 'b0;
+				if(!searchFound && !searchStale[searchCore]) begin
+					searchAttempts <= searchAttempts + 'h1;
+					if(!(sha_digest[(256*searchCore)+:256] & searchMask)) begin
+						searchFound <= 'b1;
+						searchResult <= coreNonce[(32*searchCore)+:32];
+						searchDigest <= sha_digest[(256*searchCore)+:256];
+					end
+				end
+			end
+
+			/* Search is over once a digest matches (or all nonces are tried) and its cores are back */
+			if(searching && (searchFound || !searchLeft) && !searchPass) begin
+				searching <= 'b0;
+				if(!searchFound)
+					searchResult <= searchNonce;
+			end
+
+			/* Realignment is armed by SYNC bytes between commands only, as data may be all ones as well */
+			if(rxStrobe)
+				syncArm <= !batchLeft && !count && (CMD_SYNC == p_rx);
+
+			if(rxStrobe && batchLeft) begin
+				/* BATCH (or SIGN) data: every 32 bytes make an entry (34 in CRC mode) */
+				crcIn <= crcNext;
+				if(batchByte < 'd32)
+					block <= blockNext;
+				batchByte <= (entryLast == batchByte)? 'h0 : (batchByte + 'h1);
+				if(entryLast == batchByte) begin
+					batchTag <= batchTag + 'h1;
+					batchLeft <= batchLeft - 'h1;
+					if(crcMode && crcNext) begin
+						frameError <= 'b1;
+						perfErrors <= perfErrors + 'h1;
+					end
+					else begin
+						perfCommands <= perfCommands + 'h1;
+					end
+				end
+			end
+			else if(rxStrobe) begin
+				crcIn <= crcNext;
+				if(!count)
+					cmd <= p_rx;
+
+				/* Payload is shifted into block. Core is started once the command is complete, if its CRC is good */
+				if(1 == count)
+					rxTag <= p_rx[6:0];
+				if((CMD_SEARCH == rxCmd) && count && (count <= 'd6))
+					searchArgs <= {searchArgs[39:0], p_rx};
+				if(count && (count <= payloadLast))
+					block <= blockNext;
+				if(count && (count == cmdLast) && !cmdOk) begin
+					frameError <= 'b1;
+					perfErrors <= perfErrors + 'h1;
+				end
+				if((count == cmdLast) && cmdOk && !cmdOff && (CMD_NOP != rxCmd) && (CMD_SYNC != rxCmd))
+					perfCommands <= perfCommands + 'h1;
+				if(count && (count == cmdLast) && cmdOk && !cmdOff) begin
+					if((CMD_SHORT == rxCmd) || (CMD_INIT == rxCmd) || (CMD_NEXT == rxCmd) || (CMD_LOAD == rxCmd) || (CMD_HKEY == rxCmd) ||
+						(CMD_SEARCH == rxCmd) || (CMD_AKEY == rxCmd))
+						cmdCount <= cmdCount + 'h1;
+
+					if((CMD_TSHORT == rxCmd) || (CMD_THMAC == rxCmd) || (CMD_TDOUBLE == rxCmd)) begin
+						/* THMAC loads the inner midstate and chains the data block to it. THMAC and TDOUBLE take */
+						/* a second pass */
+						init[freeCore] <= (CMD_THMAC != rxCmd);
+						load[freeCore] <= (CMD_THMAC == rxCmd);
+						next[freeCore] <= (CMD_THMAC == rxCmd);
+						innerPass[freeCore] <= (CMD_THMAC == rxCmd) || (CMD_TDOUBLE == rxCmd);
+						doublePass[freeCore] <= (CMD_TDOUBLE == rxCmd);
+						signPass[freeCore] <= 'b0;
+						busy[freeCore] <= 'b1;
+						coreTag[(7*freeCore)+:7] <= rxTag;
+						rrCore <= ((CORES - 1) == freeCore)? 'h0 : (freeCore + 'h1);
+					end
+					else if(CMD_HKEY == rxCmd) begin
+						ipad <= cmdBlock[511:256];
+						opad <= cmdBlock[255:0];
+					end
+					else if(CMD_AKEY == rxCmd) begin
+						aesKey <= cmdBlock[383:128];
+						aesIv <= cmdBlock[127:0];
+					end
+					else if(CMD_CRC == rxCmd) begin
+						/* CRC also clears the error flag and the count, as it is never taken from corrupted bytes */
+						crcMode <= cmdBlock[0];
+						frameError <= 'b0;
+						cmdCount <= 'h0;
+					end
+					else if((CMD_BATCH == rxCmd) || (CMD_SIGN == rxCmd)) begin
+						batchLeft <= cmdBlock[7:0];
+						batchByte <= 'h0;
+						batchTag <= rxTag;
+						batchDouble <= cmdBlock[15];
+						batchSign <= (CMD_SIGN == rxCmd);
+					end
+					else if(CMD_SEARCH == rxCmd) begin
+						/* Mask has the leading zero bits set. Digest is all ones until one matches */
+						searching <= 'b1;
+						searchMode <= 'b1;
+						searchFound <= 'b0;
+						searchChain <= searchArgs[47];
+						searchOffset <= searchArgs[45:40];
+						searchMask <= ~({256{1'b1}} >> searchArgs[39:32]);
+						searchLeft <= {!searchArgs[31:0], searchArgs[31:0]};
+						searchNonce <= cmdNonce;
+						searchAttempts <= 'h0;
+						searchDigest <= {256{1'b1}};
+						searchBlock <= cmdBlock;
+						searchMid <= sha_digest[255:0];
+						searchStale <= searchPass;
+						core0Done <= 'b0;
+						irqCore0 <= 'b1;
+					end
+					else begin
+						init[0] <= (CMD_SHORT == rxCmd) || (CMD_INIT == rxCmd);
+						next[0] <= (CMD_NEXT == rxCmd);
+						load[0] <= (CMD_LOAD == rxCmd);
+						busy[0] <= 'b0;
+						searching <= 'b0;
+						searchMode <= 'b0;
+						searchStale <= searchPass;
+						core0Done <= 'b0;
+						irqCore0 <= 'b1;
+					end
+				end
+
+				count <= (count == cmdLast)? 'h0 : (count + 'h1);
+			end
+
+			if(rxStrobe) begin
+				/* SPI slave sends p_tx two bytes after it is set, so first response byte is picked DELAY - 1 bytes */
+				/* after the command. Digest is copied to out then, so that the core may start the next request */
+				/* while the rest is sent. A new command may start its wait while a digest is still being sent */
+				outWait <= outStart? (DELAY - 1) : (outWait && !readStart)? (outWait - 'h1) : 'h0;
+				if(outStart)
+					outInfo <= (CMD_INFO == rxCmd);
+
+				/* READ takes over MISO, even if a digest is being sent, as do RESULT and STATS. Responses end with their */
+				/* CRC in CRC mode */
+				if(readStart) begin
+					tx <= status;
+					out <= (SEARCH && (CMD_RESULT == rxCmd))? {searchDigest, searchResult, searchAttempts, 200'h0} :
+						(STATS && (CMD_STATS == rxCmd))? {perfCycles, perfBusy, perfIdle, perfCommands, perfErrors, perfLatency, 296'h0} : {sha_digest[255:0], 264'h0};
+					outLeft <= (SEARCH && (CMD_RESULT == rxCmd))? 'd40 : (STATS && (CMD_STATS == rxCmd))? 'd28 : 'd32;
+					crcOut <= crc16(16'hFFFF, status);
+					outCrc <= crcMode? 'd2 : 'd0;
+					/* A READ sent too early does not clear irq, so that the host may wait for it. STATS leaves it alone */
+					if(core0Done && (CMD_STATS != rxCmd))
+						irqCore0 <= 'b0;
+				end
+				else if('h1 == outWait) begin
+					tx <= outInfo? info[255:248] : sha_digest[255:248];
+					out <= {(outInfo? info[247:0] : sha_digest[247:0]), 272'h0};
+					outLeft <= 'd31;
+					crcOut <= crc16(16'hFFFF, outInfo? info[255:248] : sha_digest[255:248]);
+					outCrc <= crcMode? 'd2 : 'd0;
+				end
+				else if(outLeft) begin
+					tx <= out[519:512];
+					out <= {out[511:0], 8'h0};
+					outLeft <= outLeft - 'h1;
+					crcOut <= crc16(crcOut, out[519:512]);
+				end
+				else if(outCrc) begin
+					tx <= outCrc[1]? crcOut[15:8] : crcOut[7:0];
+					outCrc <= outCrc - 'h1;
+				end
+				else if(pending && !outWait) begin
+					/* Tagged response: header and digest (and signature). Core is free once its digest is copied, as is */
+					/* the AES core once the signature is */
+					tx <= {1'b1, coreTag[(7*respCore)+:7]};
+					out <= {sha_digest[(256*respCore)+:256], (signPass[respCore]? signature : 256'h0), 8'h0};
+					outLeft <= signPass[respCore]? 'd64 : 'd32;
+					crcOut <= crc16(16'hFFFF, {1'b1, coreTag[(7*respCore)+:7]});
+					outCrc <= crcMode? 'd2 : 'd0;
+					pending[respCore] <= 'b0;
+					busy[respCore] <= 'b0;
+					if(signPass[respCore])
+						signing <= 'b0;
+				end
+				else begin
+					tx <= status;
+				end
+			end
 		end
 	end
 
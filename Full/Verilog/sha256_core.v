@@ -37,15 +37,21 @@
 //
 //======================================================================
 
-module sha256_core(
+module sha256_core #(
+                     // Rounds computed per clock cycle (1, 2 or 4).
+                     parameter ROUNDS_PER_CYCLE = 1
+                    )
+                   (
                    input wire            clk,
                    input wire            reset_n,
 
                    input wire            init,
                    input wire            next,
+                   input wire            load,
                    input wire            mode,
 
                    input wire [511 : 0]  block,
+                   input wire [255 : 0]  midstate,
 
                    output wire           ready,
                    output wire [255 : 0] digest,
@@ -140,6 +146,7 @@ module sha256_core(
   //----------------------------------------------------------------
   reg digest_init;
   reg digest_update;
+  reg digest_load;
 
   reg state_init;
   reg state_update;
@@ -148,26 +155,39 @@ module sha256_core(
 
   reg ready_flag;
 
-  reg [31 : 0] t1;
-  reg [31 : 0] t2;
+  reg [31 : 0] a_rnd;
+  reg [31 : 0] b_rnd;
+  reg [31 : 0] c_rnd;
+  reg [31 : 0] d_rnd;
+  reg [31 : 0] e_rnd;
+  reg [31 : 0] f_rnd;
+  reg [31 : 0] g_rnd;
+  reg [31 : 0] h_rnd;
 
-  wire [31 : 0] k_data;
+  wire [(32 * ROUNDS_PER_CYCLE) - 1 : 0] k_data;
 
   reg           w_init;
   reg           w_next;
-  wire [31 : 0] w_data;
+  wire [(32 * ROUNDS_PER_CYCLE) - 1 : 0] w_data;
 
 
   //----------------------------------------------------------------
   // Module instantiantions.
   //----------------------------------------------------------------
-  sha256_k_constants k_constants_inst(
-                                      .addr(t_ctr_reg),
-                                      .K(k_data)
-                                     );
-
-
-  sha256_w_mem w_mem_inst(
+  // One constant per round of the cycle, first round in the MSBs.
+  genvar k_idx;
+  generate
+    for (k_idx = 0 ; k_idx < ROUNDS_PER_CYCLE ; k_idx = k_idx + 1)
+      begin : k_constants
+        sha256_k_constants k_constants_inst(
+                                            .addr(t_ctr_reg + k_idx),
+                                            .K(k_data[(32 * (ROUNDS_PER_CYCLE - 1 - k_idx)) +: 32])
+                                           );
+      end
+  endgenerate
+
+
+  sha256_w_mem #(.ROUNDS_PER_CYCLE(ROUNDS_PER_CYCLE)) w_mem_inst(
                           .clk(clk),
                           .reset_n(reset_n),
 
@@ -262,7 +282,7 @@ module sha256_core(
   //----------------------------------------------------------------
   // digest_logic
   //
-  // The logic needed to init as well as update the digest.
+  // The logic needed to init, load as well as update the digest.
   //----------------------------------------------------------------
   always @*
     begin : digest_logic
@@ -303,6 +323,19 @@ module sha256_core(
             end
         end
 
+      if (digest_load)
+        begin
+          H0_new = midstate[255 : 224];
+          H1_new = midstate[223 : 192];
+          H2_new = midstate[191 : 160];
+          H3_new = midstate[159 : 128];
+          H4_new = midstate[127 :  96];
+          H5_new = midstate[95  :  64];
+          H6_new = midstate[63  :  32];
+          H7_new = midstate[31  :   0];
+          H_we = 1;
+        end
+
       if (digest_update)
         begin
           H0_new = H0_reg + a_reg;
@@ -319,43 +352,60 @@ module sha256_core(
 
 
   //----------------------------------------------------------------
-  // t1_logic
+  // rounds_logic
   //
-  // The logic for the T1 function.
+  // The logic for ROUNDS_PER_CYCLE rounds, chained. Each one
+  // computes the T1 and T2 functions and shifts the state.
   //----------------------------------------------------------------
   always @*
-    begin : t1_logic
+    begin : rounds_logic
+      integer i;
+      reg [31 : 0] sum0;
       reg [31 : 0] sum1;
+      reg [31 : 0] maj;
       reg [31 : 0] ch;
+      reg [31 : 0] t1;
+      reg [31 : 0] t2;
+
+      a_rnd = a_reg;
+      b_rnd = b_reg;
+      c_rnd = c_reg;
+      d_rnd = d_reg;
+      e_rnd = e_reg;
+      f_rnd = f_reg;
+      g_rnd = g_reg;
+      h_rnd = h_reg;
+
+      for (i = 0 ; i < ROUNDS_PER_CYCLE ; i = i + 1)
+        begin
+          sum1 = {e_rnd[5  : 0], e_rnd[31 :  6]} ^
+                 {e_rnd[10 : 0], e_rnd[31 : 11]} ^
+                 {e_rnd[24 : 0], e_rnd[31 : 25]};
 
-      sum1 = {e_reg[5  : 0], e_reg[31 :  6]} ^
-             {e_reg[10 : 0], e_reg[31 : 11]} ^
-             {e_reg[24 : 0], e_reg[31 : 25]};
-
-      ch = (e_reg & f_reg) ^ ((~e_reg) & g_reg);
-
-      t1 = h_reg + sum1 + ch + w_data + k_data;
-    end // t1_logic
+          ch = (e_rnd & f_rnd) ^ ((~e_rnd) & g_rnd);
 
+          t1 = h_rnd + sum1 + ch +
+               w_data[(32 * (ROUNDS_PER_CYCLE - 1 - i)) +: 32] +
+               k_data[(32 * (ROUNDS_PER_CYCLE - 1 - i)) +: 32];
 
-  //----------------------------------------------------------------
-  // t2_logic
-  //
-  // The logic for the T2 function
-  //----------------------------------------------------------------
-  always @*
-    begin : t2_logic
-      reg [31 : 0] sum0;
-      reg [31 : 0] maj;
+          sum0 = {a_rnd[1  : 0], a_rnd[31 :  2]} ^
+                 {a_rnd[12 : 0], a_rnd[31 : 13]} ^
+                 {a_rnd[21 : 0], a_rnd[31 : 22]};
 
-      sum0 = {a_reg[1  : 0], a_reg[31 :  2]} ^
-             {a_reg[12 : 0], a_reg[31 : 13]} ^
-             {a_reg[21 : 0], a_reg[31 : 22]};
+          maj = (a_rnd & b_rnd) ^ (a_rnd & c_rnd) ^ (b_rnd & c_rnd);
 
-      maj = (a_reg & b_reg) ^ (a_reg & c_reg) ^ (b_reg & c_reg);
+          t2 = sum0 + maj;
 
-      t2 = sum0 + maj;
-    end // t2_logic
+          h_rnd = g_rnd;
+          g_rnd = f_rnd;
+          f_rnd = e_rnd;
+          e_rnd = d_rnd + t1;
+          d_rnd = c_rnd;
+          c_rnd = b_rnd;
+          b_rnd = a_rnd;
+          a_rnd = t1 + t2;
+        end
+    end // rounds_logic
 
 
   //----------------------------------------------------------------
@@ -404,6 +454,17 @@ module sha256_core(
                   h_new  = SHA224_H0_7;
                 end
             end
+          else if (digest_load)
+            begin
+              a_new  = midstate[255 : 224];
+              b_new  = midstate[223 : 192];
+              c_new  = midstate[191 : 160];
+              d_new  = midstate[159 : 128];
+              e_new  = midstate[127 :  96];
+              f_new  = midstate[95  :  64];
+              g_new  = midstate[63  :  32];
+              h_new  = midstate[31  :   0];
+            end
           else
             begin
               a_new  = H0_reg;
@@ -419,14 +480,14 @@ module sha256_core(
 
       if (state_update)
         begin
-          a_new  = t1 + t2;
-          b_new  = a_reg;
-          c_new  = b_reg;
-          d_new  = c_reg;
-          e_new  = d_reg + t1;
-          f_new  = e_reg;
-          g_new  = f_reg;
-          h_new  = g_reg;
+          a_new  = a_rnd;
+          b_new  = b_rnd;
+          c_new  = c_rnd;
+          d_new  = d_rnd;
+          e_new  = e_rnd;
+          f_new  = f_rnd;
+          g_new  = g_rnd;
+          h_new  = h_rnd;
           a_h_we = 1;
         end
     end // state_logic
@@ -451,7 +512,7 @@ module sha256_core(
 
       if (t_ctr_inc)
         begin
-          t_ctr_new = t_ctr_reg + 1'b1;
+          t_ctr_new = t_ctr_reg + ROUNDS_PER_CYCLE;
           t_ctr_we  = 1;
         end
     end // t_ctr
@@ -466,6 +527,7 @@ module sha256_core(
     begin : sha256_ctrl_fsm
       digest_init      = 0;
       digest_update    = 0;
+      digest_load      = 0;
 
       state_init       = 0;
       state_update     = 0;
@@ -486,61 +548,74 @@ module sha256_core(
       sha256_ctrl_we   = 0;
 
 
-      case (sha256_ctrl_reg)
-        CTRL_IDLE:
-          begin
-            ready_flag = 1;
-
-            if (init)
-              begin
-                digest_init      = 1;
-                w_init           = 1;
-                state_init       = 1;
-                first_block      = 1;
-                t_ctr_rst        = 1;
-                digest_valid_new = 0;
-                digest_valid_we  = 1;
-                sha256_ctrl_new  = CTRL_ROUNDS;
-                sha256_ctrl_we   = 1;
-              end
-
-            if (next)
-              begin
-                w_init           = 1;
-                state_init       = 1;
-                t_ctr_rst        = 1;
-                digest_valid_new = 0;
-                digest_valid_we  = 1;
-                sha256_ctrl_new  = CTRL_ROUNDS;
-                sha256_ctrl_we   = 1;
-              end
-          end
-
-
-        CTRL_ROUNDS:
-          begin
-            w_next       = 1;
-            state_update = 1;
-            t_ctr_inc    = 1;
-
-            if (t_ctr_reg == SHA256_ROUNDS)
-              begin
-                sha256_ctrl_new = CTRL_DONE;
-                sha256_ctrl_we  = 1;
-              end
-          end
-
-
-        CTRL_DONE:
-          begin
-            digest_update    = 1;
-            digest_valid_new = 1;
-            digest_valid_we  = 1;
-
-            sha256_ctrl_new  = CTRL_IDLE;
-            sha256_ctrl_we   = 1;
-          end
-      endcase // case (sha256_ctrl_reg)
+      if (sha256_ctrl_reg == CTRL_IDLE)
+        ready_flag = 1;
+
+      // init, load and next are taken in any state. A block still
+      // being hashed is dropped, so that a busy core may be taken
+      // back (as the manager does to end a search).
+      if (init || load || next)
+        begin
+          sha256_ctrl_new  = CTRL_IDLE;
+          sha256_ctrl_we   = 1;
+
+          if (init)
+            begin
+              digest_init      = 1;
+              w_init           = 1;
+              state_init       = 1;
+              first_block      = 1;
+              t_ctr_rst        = 1;
+              digest_valid_new = 0;
+              digest_valid_we  = 1;
+              sha256_ctrl_new  = CTRL_ROUNDS;
+            end
+
+          // Load a saved intermediate hash value (midstate),
+          // to be chained by next, in the same cycle or later.
+          if (load)
+            begin
+              digest_load      = 1;
+              digest_valid_new = 1;
+              digest_valid_we  = 1;
+            end
+
+          if (next)
+            begin
+              w_init           = 1;
+              state_init       = 1;
+              t_ctr_rst        = 1;
+              digest_valid_new = 0;
+              digest_valid_we  = 1;
+              sha256_ctrl_new  = CTRL_ROUNDS;
+            end
+        end
+      else
+        case (sha256_ctrl_reg)
+          CTRL_ROUNDS:
+            begin
+              w_next       = 1;
+              state_update = 1;
+              t_ctr_inc    = 1;
+
+              if (t_ctr_reg == (SHA256_ROUNDS + 1 - ROUNDS_PER_CYCLE))
+                begin
+                  sha256_ctrl_new = CTRL_DONE;
+                  sha256_ctrl_we  = 1;
+                end
+            end
+
+
+          CTRL_DONE:
+            begin
+              digest_update    = 1;
+              digest_valid_new = 1;
+              digest_valid_we  = 1;
+
+              sha256_ctrl_new  = CTRL_IDLE;
+              sha256_ctrl_we   = 1;
+            end
+        endcase // case (sha256_ctrl_reg)
     end // sha256_ctrl_fsm
 
 endmodule // sha256_core
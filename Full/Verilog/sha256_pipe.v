@@ -0,0 +1,220 @@
+/* ********************************************************************************************* */
+/* * Pipelined SHA-256 Module                                                                  * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+module sha256_pipe#(
+		/* Number of slots sharing the pipeline. Each slot behaves as a sha256_core */
+		parameter SLOTS = 1
+	) (
+		clk,
+		reset_n,
+
+		init,
+		next,
+		load,
+		mode,
+
+		block,
+		midstate,
+
+		ready,
+		digest,
+		digest_valid
+	);
+
+	/* ************************************************************* */
+	/* Same interface as sha256_core, with one round per stage: a    */
+	/* block may start every cycle and its digest is ready 65 cycles */
+	/* later. The message schedule window (16 words) travels along   */
+	/* with the block, shifted by one word per stage.                */
+	/*                                                               */
+	/* init starts a message on a slot and next chains a block to    */
+	/* the last digest of the slot, which load (in the same cycle or */
+	/* before) overwrites with midstate. Only one slot may start a   */
+	/* block per cycle. A slot started or loaded while one of its    */
+	/* own blocks is in the pipeline drops that block, as            */
+	/* sha256_core does.                                             */
+	/* ************************************************************* */
+
+	/* Initial hash values */
+	localparam SHA224_H0 = 256'hc1059ed8367cd5073070dd17f70e5939ffc00b316858151164f98fa7befa4fa4;
+	localparam SHA256_H0 = 256'h6a09e667bb67ae853c6ef372a54ff53a510e527f9b05688c1f83d9ab5be0cd19;
+	/* One stage per round */
+	localparam STAGES = 64;
+
+	/* Usual inputs */
+	input clk;
+	input reset_n;
+
+	/* Control, one bit per slot */
+	input [SLOTS-1:0] init;
+	input [SLOTS-1:0] next;
+	input [SLOTS-1:0] load;
+	input mode;
+
+	input [511:0] block;
+	/* Hash value set by load */
+	input [255:0] midstate;
+
+	output ready;
+	output [(256*SLOTS)-1:0] digest;
+	output [SLOTS-1:0] digest_valid;
+
+	/* Pipeline stages: working variables after the round, hash value to be added at the end, schedule window */
+	/* (word of next round on top) and slot of the block */
+	reg [255:0] state [0:STAGES-1];
+	reg [255:0] hIn [0:STAGES-1];
+	reg [511:0] w [0:STAGES-1];
+	reg [6:0] slot [0:STAGES-1];
+	reg [STAGES-1:0] valid;
+	/* Digests of each slot */
+	reg [255:0] digestReg [0:SLOTS-1];
+	reg [SLOTS-1:0] digestValid;
+	reg [6:0] startSlot;
+	wire [(32*STAGES)-1:0] k;
+	integer i;
+	integer j;
+	integer s;
+	integer t;
+	genvar n;
+
+	/* A block starts on the lowest slot with init or next set */
+	wire start = |(init | next);
+	wire [255:0] startH = init[startSlot]? (mode? SHA256_H0 : SHA224_H0) : load[startSlot]? midstate : digestReg[startSlot];
+
+	/* SHA-256 round */
+	function [255:0] sha256_round;
+		input [255:0] st;
+		input [31:0] wt;
+		input [31:0] kt;
+		reg [31:0] a, b, c, d, e, f, g, h;
+		reg [31:0] t1, t2;
+		begin
+			{a, b, c, d, e, f, g, h} = st;
+			t1 = h + ({e[5:0], e[31:6]} ^ {e[10:0], e[31:11]} ^ {e[24:0], e[31:25]}) + ((e & f) ^ ((~e) & g)) + wt + kt;
+			t2 = ({a[1:0], a[31:2]} ^ {a[12:0], a[31:13]} ^ {a[21:0], a[31:22]}) + ((a & b) ^ (a & c) ^ (b & c));
+			sha256_round = {t1 + t2, a, b, c, d + t1, e, f, g};
+		end
+	endfunction
+
+	/* Message schedule: window shifted by one word, W[t+16] computed from W[t], W[t+1], W[t+9] and W[t+14] */
+	function [511:0] sha256_schedule;
+		input [511:0] win;
+		reg [31:0] w0, w1, w9, w14;
+		begin
+			w0 = win[511:480];
+			w1 = win[479:448];
+			w9 = win[223:192];
+			w14 = win[63:32];
+			sha256_schedule = {win[479:0], ({w14[16:0], w14[31:17]} ^ {w14[18:0], w14[31:19]} ^ {10'h0, w14[31:10]}) + w9 +
+				({w1[6:0], w1[31:7]} ^ {w1[17:0], w1[31:18]} ^ {3'h0, w1[31:3]}) + w0};
+		end
+	endfunction
+
+	/* Final addition of the hash value */
+	function [255:0] sha256_add;
+		input [255:0] hv;
+		input [255:0] st;
+		integer m;
+		begin
+			for(m = 0; m < 8; m = m + 1)
+				sha256_add[(32*m)+:32] = hv[(32*m)+:32] + st[(32*m)+:32];
+		end
+	endfunction
+
+	always @* begin
+		startSlot = 'h0;
+		for(i = SLOTS - 1; i >= 0; i = i - 1) begin
+			if(init[i] || next[i])
+				startSlot = i;
+		end
+	end
+
+	/* Round constants, K[s] on stage s */
+	generate
+		for(n = 0; n < STAGES; n = n + 1) begin: kconst
+			sha256_k_constants kinst(
+				.addr(n),
+				.K(k[((32*STAGES)-1-(32*n))-:32])
+			);
+		end
+
+		for(n = 0; n < SLOTS; n = n + 1) begin: dout
+			assign digest[(256*n)+:256] = digestReg[n];
+		end
+	endgenerate
+
+	assign ready = 'b1;
+	assign digest_valid = digestValid;
+
+	/* Datapath: no reset, blocks are tracked by valid */
+	always @(posedge clk) begin
+		state[0] <= sha256_round(startH, block[511:480], k[(32*STAGES)-1-:32]);
+		hIn[0] <= startH;
+		w[0] <= block;
+		slot[0] <= startSlot;
+
+		for(s = 1; s < STAGES; s = s + 1) begin
+			state[s] <= sha256_round(state[s-1], w[s-1][479:448], k[((32*STAGES)-1-(32*s))-:32]);
+			hIn[s] <= hIn[s-1];
+			w[s] <= sha256_schedule(w[s-1]);
+			slot[s] <= slot[s-1];
+		end
+	end
+
+	always @(posedge clk or negedge reset_n) begin
+		if(!reset_n) begin
+			valid <= 'h0;
+			digestValid <= 'h0;
+			for(j = 0; j < SLOTS; j = j + 1)
+				digestReg[j] <= 'h0;
+		end
+		else begin
+			valid <= {valid[STAGES-2:0], start};
+			for(t = 0; t < (STAGES - 1); t = t + 1) begin
+				if(valid[t] && ((start && (slot[t] == startSlot)) || load[slot[t]]))
+					valid[t+1] <= 'b0;
+			end
+
+			/* Digest of a slot is not valid while it has a block in the pipeline */
+			if(valid[STAGES-1]) begin
+				digestReg[slot[STAGES-1]] <= sha256_add(hIn[STAGES-1], state[STAGES-1]);
+				digestValid[slot[STAGES-1]] <= 'b1;
+			end
+			/* load may come along with next */
+			for(j = 0; j < SLOTS; j = j + 1) begin
+				if(load[j]) begin
+					digestReg[j] <= midstate;
+					digestValid[j] <= 'b1;
+				end
+			end
+
+			if(start)
+				digestValid[startSlot] <= 'b0;
+		end
+	end
+
+endmodule
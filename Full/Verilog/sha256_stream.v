@@ -64,8 +64,10 @@ module sha256_stream
 
       .init(s_tvalid_i & first_block),
       .next(s_tvalid_i & !first_block),
+      .load(1'b0),
 
       .block(s_tdata_i),
+      .midstate(256'h0),
 
       .ready(s_tready_o),
 
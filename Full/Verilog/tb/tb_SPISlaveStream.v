@@ -0,0 +1,198 @@
+/* ********************************************************************************************* */
+/* * SPI Slave Stream Testbench                                                                * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+`timescale 1ns / 1ps
+
+module tb_SPISlaveStream;
+
+	/* ************************************************************* */
+	/* Drives SPISlaveStream as an SPI mode 0 master, MSB first on   */
+	/* the highest lane, with data on both s_sclk edges when DDR is  */
+	/* set. The parallel side echoes every byte received, XORed with */
+	/* 0xA5, which comes back two bytes later on MISO. Checks both   */
+	/* directions on a stream of bytes, then again after a stray     */
+	/* s_sclk cycle (one beat, or two with DDR, since a slip of half */
+	/* a cycle is not undone) has been fixed by a SYNC sequence:     */
+	/* 0xFF bytes and then 0x00 bytes with p_sync high. With 4 lanes */
+	/* and DDR, the stray cycle is a whole byte and framing holds    */
+	/* anyway. Set LANES and DDR with e.g. iverilog -P.              */
+	/* ************************************************************* */
+
+	parameter LANES = 1;
+	parameter DDR = 0;
+	localparam BEATS = 8 / LANES;
+	/* Time between a lane change and the s_sclk edge it is sampled on */
+	localparam SETUP = 10;
+	localparam BYTES = 64;
+	localparam XOR = 8'hA5;
+
+	reg rst_n;
+	reg s_sclk;
+	reg [LANES-1:0] s_mosi;
+	wire [LANES-1:0] s_miso;
+	wire [7:0] p_rx;
+	wire p_rx_toggle;
+	reg p_sync;
+	/* Bytes sent and received on each side */
+	reg [7:0] mosiLog [0:(4*BYTES)-1];
+	reg [7:0] misoLog [0:(4*BYTES)-1];
+	reg [7:0] rxLog [0:(4*BYTES)-1];
+	integer sent;
+	integer received;
+	integer errors;
+	integer i;
+	integer b;
+	integer first;
+	integer rxFirst;
+	integer n;
+	reg [7:0] miso;
+	reg [LANES-1:0] lanes;
+
+	SPISlaveStream #(
+		.LANES(LANES),
+		.DDR(DDR)
+	) dut (
+		.rst_n(rst_n),
+
+		.s_sclk(s_sclk),
+		.s_mosi(s_mosi),
+		.s_miso(s_miso),
+
+		.p_rx(p_rx),
+		.p_rx_toggle(p_rx_toggle),
+		.p_tx(p_rx ^ XOR),
+		.p_sync(p_sync)
+	);
+
+	/* p_rx is set along with p_rx_toggle */
+	always @(p_rx_toggle) begin
+		if(rst_n) begin
+			rxLog[received] = p_rx;
+			received = received + 1;
+		end
+	end
+
+	/* One beat: drive the lanes, then sample MISO right before the edge the slave samples MOSI on. Without DDR, */
+	/* that is the rising edge, and s_sclk goes low again */
+	task beat;
+		input [LANES-1:0] out;
+		output [LANES-1:0] in;
+		begin
+			s_mosi = out;
+			#SETUP;
+			in = s_miso;
+			s_sclk = !s_sclk;
+			#SETUP;
+			if(!DDR)
+				s_sclk = 1'b0;
+		end
+	endtask
+
+	/* Send a byte and log both directions */
+	task send;
+		input [7:0] data;
+		begin
+			for(b = 0; b < BEATS; b = b + 1) begin
+				beat(data[(7-(LANES*b))-:LANES], lanes);
+				miso = {miso, lanes};
+			end
+			mosiLog[sent] = data;
+			misoLog[sent] = miso;
+			sent = sent + 1;
+		end
+	endtask
+
+	/* Check the bytes sent from first on, on both sides: p_rx gave them from rxFirst on, and MISO has them two */
+	/* bytes later */
+	task check;
+		input [8*24-1:0] name;
+		integer errorsBefore;
+		begin
+			errorsBefore = errors;
+			for(i = 0; (first + i) < sent; i = i + 1) begin
+				if(rxLog[rxFirst+i] !== mosiLog[first+i]) begin
+					$display("FAIL: %0s, byte %0d received as %02x (sent %02x)", name, i, rxLog[rxFirst+i], mosiLog[first+i]);
+					errors = errors + 1;
+				end
+				if(((first + i + 2) < sent) && (misoLog[first+i+2] !== (mosiLog[first+i] ^ XOR))) begin
+					$display("FAIL: %0s, byte %0d echoed as %02x (expected %02x)", name, i, misoLog[first+i+2], mosiLog[first+i] ^ XOR);
+					errors = errors + 1;
+				end
+			end
+			if((rxFirst + i) != received) begin
+				$display("FAIL: %0s, %0d bytes received (expected %0d)", name, received - rxFirst, i);
+				errors = errors + 1;
+			end
+			if(errorsBefore == errors)
+				$display("PASS: %0s, %0d bytes", name, i);
+		end
+	endtask
+
+	initial begin
+		rst_n = 1'b0;
+		s_sclk = 1'b0;
+		s_mosi = 'h0;
+		p_sync = 1'b0;
+		sent = 0;
+		received = 0;
+		errors = 0;
+		miso = 8'h0;
+
+		$display("SPISlaveStream, LANES = %0d, DDR = %0d", LANES, DDR);
+		#(4 * SETUP);
+		rst_n = 1'b1;
+		#(4 * SETUP);
+
+		/* Aligned stream */
+		first = sent;
+		rxFirst = received;
+		for(n = 0; n < BYTES; n = n + 1)
+			send((n * 37) + 11);
+		check("stream");
+
+		/* Stray cycle, then SYNC. Bytes are framed again from the first 0x00 byte */
+		beat('h0, lanes);
+		if(DDR)
+			beat('h0, lanes);
+		for(n = 0; n < 4; n = n + 1)
+			send((n * 37) + 11);
+		p_sync = 1'b1;
+		for(n = 0; n < 4; n = n + 1)
+			send(8'hFF);
+		send(8'h00);
+		p_sync = 1'b0;
+		first = sent;
+		rxFirst = received;
+		for(n = 0; n < BYTES; n = n + 1)
+			send((n * 53) + 7);
+		check("after SYNC");
+
+		$display("%0d error(s)", errors);
+		$finish;
+	end
+
+endmodule
@@ -0,0 +1,571 @@
+/* ********************************************************************************************* */
+/* * Top Module Testbench                                                                      * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+
+`timescale 1ns / 1ps
+
+module tb_TOP;
+
+	/* ************************************************************* */
+	/* Drives TOP as the host does, over a one-lane SPI mode 0 bus,  */
+	/* and checks every command of the protocol (see Manager):       */
+	/* status byte, INFO, SHORT back to back, INIT/NEXT/DIGEST, LOAD */
+	/* with NEXT, READ and irq, TSHORT, HKEY with THMAC, TDOUBLE,    */
+	/* BATCH (plain and SHA-256d), CRC mode with a good and a bad    */
+	/* frame, STATS, SEARCH with RESULT (chained to LOAD), a search  */
+	/* ended by LOAD, AKEY with SIGN, and a stray s_sclk cycle fixed */
+	/* by SYNC. Tagged responses are found by their header, as the   */
+	/* host does; the others are checked at their fixed place. The   */
+	/* expected values were computed with Python hashlib, hmac and   */
+	/* OpenSSL. Set the TOP parameters and SCLK_HALF (half s_sclk    */
+	/* period, ns; SYS_CLK is 50 MHz) with e.g. iverilog -P.         */
+	/* ************************************************************* */
+
+	parameter CORES = 1;
+	parameter PIPELINED = 0;
+	parameter ROUNDS_PER_CYCLE = 1;
+	parameter AES = 0;
+	parameter HMAC = 1;
+	parameter SEARCH = 0;
+	parameter STATS = 1;
+	parameter SCLK_HALF = 50;
+	localparam CLK_HALF_PERIOD = 10;
+	localparam LOG = 8192;
+	/* Bytes between the last byte of a command and the first byte of its digest, and after READ */
+	localparam DELAY = 5;
+	localparam READ_DELAY = 1;
+	localparam [7:0] FEATURES = {(STATS != 0), (AES != 0), (SEARCH != 0), 4'hF, (HMAC != 0)};
+	/* Nonces tried by SEARCH at most, and polls of RESULT before it is given up */
+	localparam [31:0] SEARCH_LIMIT = 32'h1000;
+	localparam POLLS = 200;
+
+	localparam [7:0] CMD_NOP = 8'h00;
+	localparam [7:0] CMD_SHORT = 8'h01;
+	localparam [7:0] CMD_INIT = 8'h02;
+	localparam [7:0] CMD_NEXT = 8'h03;
+	localparam [7:0] CMD_DIGEST = 8'h04;
+	localparam [7:0] CMD_TSHORT = 8'h05;
+	localparam [7:0] CMD_INFO = 8'h06;
+	localparam [7:0] CMD_LOAD = 8'h07;
+	localparam [7:0] CMD_HKEY = 8'h08;
+	localparam [7:0] CMD_THMAC = 8'h09;
+	localparam [7:0] CMD_BATCH = 8'h0A;
+	localparam [7:0] CMD_READ = 8'h0B;
+	localparam [7:0] CMD_CRC = 8'h0C;
+	localparam [7:0] CMD_TDOUBLE = 8'h0D;
+	localparam [7:0] CMD_SEARCH = 8'h0E;
+	localparam [7:0] CMD_RESULT = 8'h0F;
+	localparam [7:0] CMD_AKEY = 8'h10;
+	localparam [7:0] CMD_SIGN = 8'h11;
+	localparam [7:0] CMD_STATS = 8'h12;
+	localparam [7:0] CMD_SYNC = 8'hFF;
+
+	localparam [255:0] DATA = 256'h000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f;
+	localparam [255:0] DATA_DIGEST = 256'h630dcd2966c4336691125448bbb25b4ff412a49c732db2c8abc1b8581bd710dd;
+	localparam [255:0] DATA2 = 256'ha5acb3bac1c8cfd6dde4ebf2f900070e151c232a31383f464d545b626970777e;
+	localparam [255:0] DATA2_DIGEST = 256'h2962403b74674406d03caccf2df10c1d5b6f6231a0f4d26f2ca946ebc1d07717;
+	localparam [511:0] MSG_BLOCK1 = 512'h6162636462636465636465666465666765666768666768696768696a68696a6b696a6b6c6a6b6c6d6b6c6d6e6c6d6e6f6d6e6f706e6f70718000000000000000;
+	localparam [511:0] MSG_BLOCK2 = 512'h000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001c0;
+	localparam [255:0] MSG_MID = 256'h85e655d6417a17953363376a624cde5c76e09589cac5f811cc4b32c1f20e533a;
+	localparam [255:0] MSG_DIGEST = 256'h248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1;
+	localparam [255:0] HMAC_IPAD = 256'hc1ec7fb48db601e7df69d45b78ddbce3ed041b06eb2fa7ab7633b6eb72eacd48;
+	localparam [255:0] HMAC_OPAD = 256'h16fc4f842f36fb532b3416e0d65ce7c60db079775c9909b34e9e4557f00b9bf1;
+	localparam [255:0] HMAC_MAC = 256'h1e76dad77dcc049701a4b8c3a3533e27ed7525192c27526dbc85f2d2cd333785;
+	localparam [255:0] DATA_DOUBLE = 256'h2f287b4d3d4910f6cada9e1bd1b4648099e8c52c81aa4a6aebfa6fc86f19834e;
+	localparam [255:0] ENTRY0 = 256'h0104070a0d101316191c1f2225282b2e3134373a3d404346494c4f5255585b5e;
+	localparam [255:0] ENTRY0_DIGEST = 256'h427c4cdfcacf83c8292714515c85ffe3afdab23c883431f7f60fea0738992189;
+	localparam [255:0] ENTRY0_DOUBLE = 256'hb97e590b55136ceabb04d88b21a6fc894da19a5c7a4894efdce49106682c25e3;
+	localparam [255:0] ENTRY1 = 256'h202326292c2f3235383b3e4144474a4d505356595c5f6265686b6e7174777a7d;
+	localparam [255:0] ENTRY1_DIGEST = 256'h4a8c26f4fe17379f9c14cfaa4d35af156ff989c38c5997979ba62d4df7c4ccc4;
+	localparam [255:0] ENTRY1_DOUBLE = 256'h056f4fa722057383a4d60ee913fef27057ef6525f6312acf149f301020b8aa24;
+	localparam [255:0] ENTRY2 = 256'h3f4245484b4e5154575a5d606366696c6f7275787b7e8184878a8d909396999c;
+	localparam [255:0] ENTRY2_DIGEST = 256'ha7bf011c4dcd118e0868e625e659ab2d286f30fe752ac89b93f3e7a758de0634;
+	localparam [255:0] ENTRY2_DOUBLE = 256'hb803d1a1fa2577241963c7449571bcb7629933722f805210541674bf22d88a2f;
+	localparam [255:0] SEARCH_MID = 256'h62a3e55dfedb64df0f2065fc378ce4d379483b7cc81b657db97db26b2ae8ec5c;
+	localparam [511:0] SEARCH_BLOCK = 512'h020d18232e39444f5a65707b86919ca7b2bdc8d3dee9f4ff0a15202b36414c578000000000000000000000000000000000000000000000000000000000000300;
+	localparam [255:0] SEARCH_DIGEST = 256'h00f397e903e9f673e55b9d502ff2e11a6c30d1356fc381deb317eed24e435adb;
+	localparam [31:0] SEARCH_NONCE = 32'h2e3947dc;
+	localparam [31:0] SEARCH_ATTEMPTS = 910;
+	localparam [255:0] AES_KEY = 256'h606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f;
+	localparam [127:0] AES_IV = 128'hf0f1f2f3f4f5f6f7f8f9fafbfcfdfeff;
+	localparam [255:0] ENTRY0_SIGNATURE = 256'hf2274f8a01445dfdf06545f2c5b17f03afa33121efe8de4fd73cba54166ab331;
+	localparam [255:0] ENTRY1_SIGNATURE = 256'h0d2958aa8324004990bbf1bf8af1d2e9cb91c42630f28e1c04d04061b47e01c7;
+
+	reg clk;
+	reg rst_n;
+	reg sclk;
+	reg mosi;
+	wire miso;
+	wire irq;
+	/* Bytes received on MISO, one for each byte sent */
+	reg [7:0] misoLog [0:LOG-1];
+	/* Where the tagged response of each tag starts, all ones if none came */
+	reg [31:0] tagPos [0:127];
+	reg [7:0] rxByte;
+	reg [15:0] crc;
+	reg done;
+	reg [47:0] cycles;
+	reg [47:0] busy;
+	reg [31:0] taken;
+	integer sent;
+	integer errors;
+	integer b;
+	integer i;
+	integer j;
+	integer k;
+	integer q;
+	integer p;
+	integer polls;
+
+	TOP #(
+		.CORES(CORES),
+		.PIPELINED(PIPELINED),
+		.ROUNDS_PER_CYCLE(ROUNDS_PER_CYCLE),
+		.AES(AES),
+		.HMAC(HMAC),
+		.SEARCH(SEARCH),
+		.STATS(STATS)
+	) dut (
+		.SYS_CLK(clk),
+		.PB({3'h7, rst_n}),
+		.USER_LED(),
+
+		.I2C_SCL(sclk),
+		.I2C_SDA(mosi),
+		.GPIO_A(miso),
+
+		.GPIO_01(1'b0),
+		.GPIO_02(1'b0),
+		.GPIO_03(1'b0),
+		.GPIO_04(),
+		.GPIO_05(),
+		.GPIO_06(),
+		.GPIO_07(irq)
+	);
+
+	always #CLK_HALF_PERIOD clk = !clk;
+
+	/* CRC-16 of the protocol, one byte at a time */
+	function [15:0] crc16;
+		input [15:0] crcIn;
+		input [7:0] data;
+		integer n;
+		begin
+			crc16 = crcIn ^ {data, 8'h0};
+			for(n = 0; n < 8; n = n + 1)
+				crc16 = crc16[15]? ((crc16 << 1) ^ 16'h1021) : (crc16 << 1);
+		end
+	endfunction
+
+	/* One s_sclk cycle: MISO is sampled right before the rising edge, on which the slave samples MOSI */
+	task beat;
+		input out;
+		begin
+			mosi = out;
+			#SCLK_HALF;
+			rxByte = {rxByte[6:0], miso};
+			sclk = 1'b1;
+			#SCLK_HALF;
+			sclk = 1'b0;
+		end
+	endtask
+
+	/* Send a byte, log the one received and add it to the running CRC */
+	task send;
+		input [7:0] data;
+		begin
+			for(b = 0; b < 8; b = b + 1)
+				beat(data[7-b]);
+			misoLog[sent] = rxByte;
+			sent = sent + 1;
+			crc = crc16(crc, data);
+		end
+	endtask
+
+	task send32;
+		input [255:0] data;
+		begin
+			for(i = 0; i < 32; i = i + 1)
+				send(data[(255-(8*i))-:8]);
+		end
+	endtask
+
+	task send64;
+		input [511:0] data;
+		begin
+			for(i = 0; i < 64; i = i + 1)
+				send(data[(511-(8*i))-:8]);
+		end
+	endtask
+
+	task nops;
+		input [31:0] n;
+		begin
+			for(j = 0; j < n; j = j + 1)
+				send(CMD_NOP);
+		end
+	endtask
+
+	/* CRC of a frame, sent after its bytes in CRC mode: the running CRC is restarted before the command byte */
+	task sendCrc;
+		reg [15:0] frameCrc;
+		begin
+			frameCrc = crc;
+			send(frameCrc[15:8]);
+			send(frameCrc[7:0]);
+		end
+	endtask
+
+	/* Check len bytes of the log from pos against value (last byte in the lowest bits) */
+	task expect;
+		input [8*40-1:0] name;
+		input [31:0] pos;
+		input [31:0] len;
+		input [511:0] value;
+		begin
+			for(k = 0; (k < len) && (misoLog[pos+k] === value[(8*(len-1-k))+:8]); k = k + 1);
+			if(k == len)
+				$display("PASS: %0s", name);
+			else begin
+				$display("FAIL: %0s, byte %0d received as %02x (expected %02x)", name, k, misoLog[pos+k], value[(8*(len-1-k))+:8]);
+				errors = errors + 1;
+			end
+		end
+	endtask
+
+	/* Check a status byte under mask */
+	task expectStatus;
+		input [8*40-1:0] name;
+		input [31:0] pos;
+		input [7:0] mask;
+		input [7:0] value;
+		begin
+			if((misoLog[pos] & mask) === value)
+				$display("PASS: %0s", name);
+			else begin
+				$display("FAIL: %0s, status %02x (expected %02x under %02x)", name, misoLog[pos], value, mask);
+				errors = errors + 1;
+			end
+		end
+	endtask
+
+	/* Check the CRC of len bytes of the log from pos, followed by their CRC */
+	task expectCrc;
+		input [8*40-1:0] name;
+		input [31:0] pos;
+		input [31:0] len;
+		reg [15:0] check;
+		begin
+			check = 16'hFFFF;
+			for(k = 0; k < (len + 2); k = k + 1)
+				check = crc16(check, misoLog[pos+k]);
+			if(!check)
+				$display("PASS: %0s", name);
+			else begin
+				$display("FAIL: %0s, CRC does not match", name);
+				errors = errors + 1;
+			end
+		end
+	endtask
+
+	/* Walk the log from pos as the host does: a byte with bit 7 set is the header of a tagged response of len bytes */
+	/* (header included), other bytes are status bytes */
+	task parse;
+		input [31:0] pos;
+		input [31:0] len;
+		begin
+			for(k = 0; k < 128; k = k + 1)
+				tagPos[k] = ~32'h0;
+			q = pos;
+			while(q < sent) begin
+				if(misoLog[q][7]) begin
+					tagPos[misoLog[q][6:0]] = q;
+					q = q + len;
+				end
+				else
+					q = q + 1;
+			end
+		end
+	endtask
+
+	/* Check the tagged response of tag, after parse */
+	task expectTag;
+		input [8*40-1:0] name;
+		input [6:0] tag;
+		input [31:0] len;
+		input [511:0] value;
+		begin
+			if(tagPos[tag] == ~32'h0) begin
+				$display("FAIL: %0s, no response", name);
+				errors = errors + 1;
+			end
+			else
+				expect(name, tagPos[tag] + 1, len, value);
+		end
+	endtask
+
+	/* Start a command, keeping its place in the log */
+	task command;
+		input [7:0] cmd;
+		begin
+			crc = 16'hFFFF;
+			p = sent;
+			send(cmd);
+		end
+	endtask
+
+	initial begin
+		clk = 1'b0;
+		rst_n = 1'b0;
+		sclk = 1'b0;
+		mosi = 1'b0;
+		rxByte = 8'h0;
+		crc = 16'hFFFF;
+		sent = 0;
+		errors = 0;
+
+		$display("TOP, CORES = %0d, PIPELINED = %0d, ROUNDS_PER_CYCLE = %0d, AES = %0d, HMAC = %0d, SEARCH = %0d, STATS = %0d, s_sclk %0d kHz",
+			CORES, PIPELINED, ROUNDS_PER_CYCLE, AES, HMAC, SEARCH, STATS, 1000000 / (2 * SCLK_HALF));
+		#(20 * CLK_HALF_PERIOD);
+		rst_n = 1'b1;
+		#(20 * CLK_HALF_PERIOD);
+
+		/* Idle: status byte with nothing to do */
+		nops(4);
+		expectStatus("idle status", 3, 8'hFF, 8'h44);
+
+		/* INFO */
+		command(CMD_INFO);
+		nops(DELAY + 3);
+		expect("INFO", p + 1 + DELAY, 3, {CORES[7:0], FEATURES, 8'h40});
+
+		/* SHORT, two back to back: data of the second one goes in while the first digest comes out */
+		command(CMD_SHORT);
+		send32(DATA);
+		q = p;
+		command(CMD_SHORT);
+		send32(DATA2);
+		nops(DELAY + 32);
+		expect("SHORT", q + 33 + DELAY, 32, DATA_DIGEST);
+		expect("SHORT back to back", p + 33 + DELAY, 32, DATA2_DIGEST);
+
+		/* Two-block message, then the same from the midstate of its first block */
+		command(CMD_INIT);
+		send64(MSG_BLOCK1);
+		command(CMD_NEXT);
+		send64(MSG_BLOCK2);
+		command(CMD_DIGEST);
+		nops(DELAY + 32);
+		expect("INIT, NEXT and DIGEST", p + 1 + DELAY, 32, MSG_DIGEST);
+		command(CMD_LOAD);
+		send32(MSG_MID);
+		command(CMD_NEXT);
+		send64(MSG_BLOCK2);
+		command(CMD_DIGEST);
+		nops(DELAY + 32);
+		expect("LOAD, NEXT and DIGEST", p + 1 + DELAY, 32, MSG_DIGEST);
+
+		/* READ once the digest is done, as told by irq */
+		command(CMD_SHORT);
+		send32(DATA2);
+		nops(DELAY);
+		if(!irq) begin
+			$display("FAIL: irq low with a digest done");
+			errors = errors + 1;
+		end
+		command(CMD_READ);
+		nops(READ_DELAY + 33);
+		expectStatus("READ status", p + 1 + READ_DELAY, 8'hC1, 8'h41);
+		expect("READ", p + 2 + READ_DELAY, 32, DATA2_DIGEST);
+		if(irq) begin
+			$display("FAIL: irq high after READ");
+			errors = errors + 1;
+		end
+
+		/* Tagged requests, one at a time as there may be a single core */
+		command(CMD_TSHORT);
+		send(8'h05);
+		send32(DATA);
+		nops(48);
+		parse(p, 33);
+		expectTag("TSHORT", 5, 32, DATA_DIGEST);
+		if(HMAC) begin
+			command(CMD_HKEY);
+			send32(HMAC_IPAD);
+			send32(HMAC_OPAD);
+			command(CMD_THMAC);
+			send(8'h06);
+			send32(DATA);
+			nops(48);
+			parse(p, 33);
+			expectTag("THMAC", 6, 32, HMAC_MAC);
+		end
+		command(CMD_TDOUBLE);
+		send(8'h07);
+		send32(DATA);
+		nops(48);
+		parse(p, 33);
+		expectTag("TDOUBLE", 7, 32, DATA_DOUBLE);
+
+		/* BATCH, with tags from 0x10 on, then SHA-256d from 0x20 on */
+		command(CMD_BATCH);
+		send(8'h10);
+		send(8'd3);
+		send32(ENTRY0);
+		send32(ENTRY1);
+		send32(ENTRY2);
+		nops(3 * 33 + 16);
+		parse(p, 33);
+		expectTag("BATCH entry 0", 8'h10, 32, ENTRY0_DIGEST);
+		expectTag("BATCH entry 1", 8'h11, 32, ENTRY1_DIGEST);
+		expectTag("BATCH entry 2", 8'h12, 32, ENTRY2_DIGEST);
+		command(CMD_BATCH);
+		send(8'hA0);
+		send(8'd2);
+		send32(ENTRY0);
+		send32(ENTRY1);
+		nops(2 * 33 + 16);
+		parse(p, 33);
+		expectTag("BATCH SHA-256d entry 0", 8'h20, 32, ENTRY0_DOUBLE);
+		expectTag("BATCH SHA-256d entry 1", 8'h21, 32, ENTRY1_DOUBLE);
+
+		/* CRC mode: a good SHORT, a SHORT with a bad CRC, dropped and flagged along with the count of commands taken */
+		command(CMD_CRC);
+		send(8'h01);
+		sendCrc;
+		command(CMD_SHORT);
+		send32(DATA);
+		sendCrc;
+		nops(DELAY + 32 + 2);
+		expect("SHORT in CRC mode", p + 35 + DELAY, 32, DATA_DIGEST);
+		expectCrc("SHORT response CRC", p + 35 + DELAY, 32);
+		command(CMD_SHORT);
+		send32(DATA2);
+		crc = ~crc;
+		sendCrc;
+		nops(DELAY + 32 + 2);
+		command(CMD_READ);
+		nops(READ_DELAY + 33 + 2);
+		expectStatus("bad CRC flagged, one command taken", p + 1 + READ_DELAY, 8'hF9, 8'h59);
+		expect("bad CRC dropped", p + 2 + READ_DELAY, 32, DATA_DIGEST);
+		expectCrc("READ response CRC", p + 1 + READ_DELAY, 33);
+		command(CMD_CRC);
+		send(8'h00);
+		sendCrc;
+		nops(4);
+
+		/* STATS: one command dropped so far */
+		if(STATS) begin
+			command(CMD_STATS);
+			nops(READ_DELAY + 29);
+			cycles = 48'h0;
+			busy = 48'h0;
+			taken = 32'h0;
+			for(k = 0; k < 6; k = k + 1) begin
+				cycles = {cycles, misoLog[p+2+READ_DELAY+k]};
+				busy = {busy, misoLog[p+8+READ_DELAY+k]};
+			end
+			for(k = 0; k < 4; k = k + 1)
+				taken = {taken, misoLog[p+20+READ_DELAY+k]};
+			expect("STATS commands dropped", p + 2 + READ_DELAY + 22, 4, 1);
+			if(!busy || (busy >= (cycles * CORES)) || !taken) begin
+				$display("FAIL: STATS counters, %0d cycles, %0d busy, %0d commands", cycles, busy, taken);
+				errors = errors + 1;
+			end
+			else
+				$display("PASS: STATS counters, %0d cycles, %0d busy, %0d commands", cycles, busy, taken);
+		end
+
+		/* SEARCH chained to LOAD, nonce at byte 4 of the block, 8 zero bits, polled with RESULT */
+		if(SEARCH) begin
+			command(CMD_LOAD);
+			send32(SEARCH_MID);
+			command(CMD_SEARCH);
+			send(8'h84);
+			send(8'd8);
+			for(i = 0; i < 4; i = i + 1)
+				send(SEARCH_LIMIT[(31-(8*i))-:8]);
+			send64(SEARCH_BLOCK);
+			done = 1'b0;
+			for(polls = 0; !done && (polls < POLLS); polls = polls + 1) begin
+				nops(16);
+				command(CMD_RESULT);
+				nops(READ_DELAY + 41);
+				done = misoLog[p+1+READ_DELAY][0];
+			end
+			expectStatus("SEARCH over", p + 1 + READ_DELAY, 8'hC1, 8'h41);
+			expect("RESULT", p + 2 + READ_DELAY, 40, {SEARCH_DIGEST, SEARCH_NONCE, SEARCH_ATTEMPTS});
+
+			/* A search that never ends, stopped by LOAD as the host does before it realigns */
+			command(CMD_SEARCH);
+			send(8'h04);
+			send(8'd255);
+			nops(4);
+			send64(SEARCH_BLOCK);
+			nops(16);
+			command(CMD_LOAD);
+			send32(MSG_MID);
+			command(CMD_NEXT);
+			send64(MSG_BLOCK2);
+			command(CMD_DIGEST);
+			nops(DELAY + 32);
+			expect("LOAD ends SEARCH", p + 1 + DELAY, 32, MSG_DIGEST);
+		end
+
+		/* SIGN: digest and AES-256-CBC signature of each entry */
+		if(AES) begin
+			command(CMD_AKEY);
+			send32(AES_KEY);
+			for(i = 0; i < 16; i = i + 1)
+				send(AES_IV[(127-(8*i))-:8]);
+			command(CMD_SIGN);
+			send(8'h30);
+			send(8'd2);
+			send32(ENTRY0);
+			send32(ENTRY1);
+			nops(2 * 65 + 16);
+			parse(p, 65);
+			expectTag("SIGN entry 0", 8'h30, 64, {ENTRY0_DIGEST, ENTRY0_SIGNATURE});
+			expectTag("SIGN entry 1", 8'h31, 64, {ENTRY1_DIGEST, ENTRY1_SIGNATURE});
+		end
+
+		/* Stray s_sclk cycle in the middle of a SHORT, then SYNC bytes and NOPs realign bytes */
+		beat(1'b0);
+		command(CMD_SHORT);
+		send32(DATA);
+		nops(DELAY + 32);
+		for(i = 0; i < 80; i = i + 1)
+			send(CMD_SYNC);
+		nops(2);
+		command(CMD_SHORT);
+		send32(DATA2);
+		nops(DELAY + 32);
+		expect("SHORT after SYNC", p + 33 + DELAY, 32, DATA2_DIGEST);
+
+		$display("%0d error(s)", errors);
+		$finish;
+	end
+
+endmodule
@@ -0,0 +1,187 @@
+/* ********************************************************************************************* */
+/* * SHA-256 Core Testbench                                                                    * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+`timescale 1ns / 1ps
+
+module tb_sha256_core;
+
+	/* ************************************************************* */
+	/* Hashes the FIPS 180-2 one-block ("abc") and two-block         */
+	/* (448-bit) messages with sha256_core, the second one also from */
+	/* its midstate (load along with next), and checks the digests   */
+	/* and the cycles from init or next until digest_valid: two more */
+	/* than the 64 / ROUNDS_PER_CYCLE cycles of rounds. Then gives   */
+	/* init, and load alone, to a busy core, which must drop the     */
+	/* block it was hashing. Set ROUNDS_PER_CYCLE with e.g.          */
+	/* iverilog -P.                                                  */
+	/* ************************************************************* */
+
+	parameter ROUNDS_PER_CYCLE = 1;
+	localparam CLK_HALF_PERIOD = 2;
+	localparam CLK_PERIOD = 2 * CLK_HALF_PERIOD;
+	localparam LATENCY = 2 + (64 / ROUNDS_PER_CYCLE);
+
+	localparam ONE_BLOCK = 512'h61626380000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000018;
+	localparam ONE_DIGEST = 256'hba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad;
+	localparam TWO_BLOCK_0 = 512'h6162636462636465636465666465666765666768666768696768696a68696a6b696a6b6c6a6b6c6d6b6c6d6e6c6d6e6f6d6e6f706e6f70718000000000000000;
+	localparam TWO_BLOCK_1 = 512'h000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001c0;
+	localparam TWO_MIDSTATE = 256'h85e655d6417a17953363376a624cde5c76e09589cac5f811cc4b32c1f20e533a;
+	localparam TWO_DIGEST = 256'h248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1;
+
+	reg clk;
+	reg reset_n;
+	reg init;
+	reg next;
+	reg load;
+	reg [511:0] block;
+	reg [255:0] midstate;
+	wire ready;
+	wire [255:0] digest;
+	wire digestValid;
+	integer errors;
+	integer cycles;
+
+	sha256_core #(
+		.ROUNDS_PER_CYCLE(ROUNDS_PER_CYCLE)
+	) dut (
+		.clk(clk),
+		.reset_n(reset_n),
+
+		.init(init),
+		.next(next),
+		.load(load),
+		.mode(1'b1),
+
+		.block(block),
+		.midstate(midstate),
+
+		.ready(ready),
+		.digest(digest),
+		.digest_valid(digestValid)
+	);
+
+	always #CLK_HALF_PERIOD clk = !clk;
+
+	/* Start a block (inputs change on falling edges) and wait for its digest, counting cycles */
+	task hash_block;
+		input startInit;
+		input startLoad;
+		input [511:0] startBlock;
+		input [255:0] startMidstate;
+		begin
+			init = startInit;
+			next = !startInit;
+			load = startLoad;
+			block = startBlock;
+			midstate = startMidstate;
+			#CLK_PERIOD;
+			init = 1'b0;
+			next = 1'b0;
+			load = 1'b0;
+			for(cycles = 1; !digestValid && (cycles < 1000); cycles = cycles + 1)
+				#CLK_PERIOD;
+		end
+	endtask
+
+	/* Give init, next or load for one cycle, and let the core run for a few cycles, less than a block takes */
+	task start_block;
+		input startInit;
+		input startNext;
+		input startLoad;
+		input [511:0] startBlock;
+		input [255:0] startMidstate;
+		begin
+			init = startInit;
+			next = startNext;
+			load = startLoad;
+			block = startBlock;
+			midstate = startMidstate;
+			#CLK_PERIOD;
+			init = 1'b0;
+			next = 1'b0;
+			load = 1'b0;
+			#(4 * CLK_PERIOD);
+		end
+	endtask
+
+	/* Check a digest and the cycles taken */
+	task check;
+		input [8*32-1:0] name;
+		input [255:0] expected;
+		begin
+			if((expected == digest) && (LATENCY == cycles) && ready) begin
+				$display("PASS: %0s, %0d cycles", name, cycles);
+			end
+			else begin
+				$display("FAIL: %0s, %0d cycles (expected %0d), digest %064x (expected %064x)", name, cycles, LATENCY, digest, expected);
+				errors = errors + 1;
+			end
+		end
+	endtask
+
+	initial begin
+		clk = 1'b0;
+		reset_n = 1'b0;
+		init = 1'b0;
+		next = 1'b0;
+		load = 1'b0;
+		block = 512'h0;
+		midstate = 256'h0;
+		errors = 0;
+
+		$display("sha256_core, ROUNDS_PER_CYCLE = %0d", ROUNDS_PER_CYCLE);
+		#(2 * CLK_PERIOD);
+		reset_n = 1'b1;
+		#CLK_PERIOD;
+
+		hash_block(1'b1, 1'b0, ONE_BLOCK, 256'h0);
+		check("one block", ONE_DIGEST);
+
+		hash_block(1'b1, 1'b0, TWO_BLOCK_0, 256'h0);
+		check("two blocks, first", TWO_MIDSTATE);
+		hash_block(1'b0, 1'b0, TWO_BLOCK_1, 256'h0);
+		check("two blocks, second", TWO_DIGEST);
+
+		/* Core is left with another digest, so that the midstate must come from load */
+		hash_block(1'b1, 1'b0, ONE_BLOCK, 256'h0);
+		hash_block(1'b0, 1'b1, TWO_BLOCK_1, TWO_MIDSTATE);
+		check("two blocks, from midstate", TWO_DIGEST);
+
+		/* A block given while another one is being hashed drops it, as does load alone */
+		start_block(1'b1, 1'b0, 1'b0, TWO_BLOCK_0, 256'h0);
+		hash_block(1'b1, 1'b0, ONE_BLOCK, 256'h0);
+		check("init while busy", ONE_DIGEST);
+		start_block(1'b1, 1'b0, 1'b0, ONE_BLOCK, 256'h0);
+		start_block(1'b0, 1'b0, 1'b1, 512'h0, TWO_MIDSTATE);
+		hash_block(1'b0, 1'b0, TWO_BLOCK_1, 256'h0);
+		check("load while busy, then next", TWO_DIGEST);
+
+		$display("%0d error(s)", errors);
+		$finish;
+	end
+
+endmodule
@@ -0,0 +1,223 @@
+/* ********************************************************************************************* */
+/* * Pipelined SHA-256 Core Testbench                                                          * */
+/* * Authors:                                                                                  * */
+/* *     André Bannwart Perina                                                                 * */
+/* *     Luciano Falqueto                                                                      * */
+/* *     Wallison de Oliveira                                                                  * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina, Luciano Falqueto and Wallison de Oliveira             * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+`timescale 1ns / 1ps
+
+module tb_sha256_pipe;
+
+	/* ************************************************************* */
+	/* Starts four blocks in a row on the four slots of sha256_pipe: */
+	/* the FIPS 180-2 one-block ("abc") message on slots 0 and 3 and */
+	/* the first block of the two-block (448-bit) message on slots 1 */
+	/* and 2. The second block then follows on slot 1 with next and  */
+	/* on slot 3 with load (of the first digest) and next, while     */
+	/* slot 2 starts over. Checks the digests, that each is valid 65 */
+	/* cycles after its block started, and that the digest of the   */
+	/* slot left alone is untouched. Last, slots are started again,  */
+	/* or loaded, with a block of their own in the pipeline, which   */
+	/* must be dropped.                                              */
+	/* ************************************************************* */
+
+	localparam SLOTS = 4;
+	localparam CLK_HALF_PERIOD = 2;
+	localparam CLK_PERIOD = 2 * CLK_HALF_PERIOD;
+	localparam LATENCY = 65;
+
+	localparam ONE_BLOCK = 512'h61626380000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000018;
+	localparam ONE_DIGEST = 256'hba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad;
+	localparam TWO_BLOCK_0 = 512'h6162636462636465636465666465666765666768666768696768696a68696a6b696a6b6c6a6b6c6d6b6c6d6e6c6d6e6f6d6e6f706e6f70718000000000000000;
+	localparam TWO_BLOCK_1 = 512'h000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001c0;
+	localparam TWO_MIDSTATE = 256'h85e655d6417a17953363376a624cde5c76e09589cac5f811cc4b32c1f20e533a;
+	localparam TWO_DIGEST = 256'h248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1;
+
+	reg clk;
+	reg reset_n;
+	reg [SLOTS-1:0] init;
+	reg [SLOTS-1:0] next;
+	reg [SLOTS-1:0] load;
+	reg [511:0] block;
+	reg [255:0] midstate;
+	wire ready;
+	wire [(256*SLOTS)-1:0] digest;
+	wire [SLOTS-1:0] digestValid;
+	integer errors;
+	integer cycles;
+	/* Cycle each slot got a new digest at (-1 if none), counted from the first block of the test, and digests */
+	/* valid on the last cycle */
+	integer validAt [0:SLOTS-1];
+	reg [SLOTS-1:0] lastValid;
+	integer i;
+
+	sha256_pipe #(
+		.SLOTS(SLOTS)
+	) dut (
+		.clk(clk),
+		.reset_n(reset_n),
+
+		.init(init),
+		.next(next),
+		.load(load),
+		.mode(1'b1),
+
+		.block(block),
+		.midstate(midstate),
+
+		.ready(ready),
+		.digest(digest),
+		.digest_valid(digestValid)
+	);
+
+	always #CLK_HALF_PERIOD clk = !clk;
+
+	/* Advance a cycle (inputs change on falling edges) and note the slots whose digest got valid */
+	task step;
+		begin
+			#CLK_PERIOD;
+			cycles = cycles + 1;
+			for(i = 0; i < SLOTS; i = i + 1) begin
+				if(digestValid[i] && !lastValid[i])
+					validAt[i] = cycles;
+			end
+			lastValid = digestValid;
+		end
+	endtask
+
+	/* Start counting cycles from the next block */
+	task restart;
+		begin
+			cycles = 0;
+			lastValid = digestValid;
+			for(i = 0; i < SLOTS; i = i + 1)
+				validAt[i] = -1;
+		end
+	endtask
+
+	/* Start a block on a slot, for a single cycle */
+	task start_block;
+		input integer startSlot;
+		input startInit;
+		input startLoad;
+		input [511:0] startBlock;
+		input [255:0] startMidstate;
+		begin
+			init = startInit << startSlot;
+			next = (!startInit) << startSlot;
+			load = startLoad << startSlot;
+			block = startBlock;
+			midstate = startMidstate;
+			step;
+			init = 'h0;
+			next = 'h0;
+			load = 'h0;
+		end
+	endtask
+
+	/* Wait until all slots have a digest */
+	task wait_digests;
+		begin
+			while((!(&digestValid)) && (cycles < 1000))
+				step;
+		end
+	endtask
+
+	/* Check the digest of a slot and the cycle it got valid at */
+	task check;
+		input integer checkSlot;
+		input [255:0] expected;
+		input integer expectedAt;
+		begin
+			if((expected == digest[(256*checkSlot)+:256]) && (expectedAt == validAt[checkSlot]) && ready) begin
+				$display("PASS: slot %0d, valid at cycle %0d", checkSlot, validAt[checkSlot]);
+			end
+			else begin
+				$display("FAIL: slot %0d, valid at cycle %0d (expected %0d), digest %064x (expected %064x)", checkSlot, validAt[checkSlot], expectedAt,
+					digest[(256*checkSlot)+:256], expected);
+				errors = errors + 1;
+			end
+		end
+	endtask
+
+	initial begin
+		clk = 1'b0;
+		reset_n = 1'b0;
+		init = 'h0;
+		next = 'h0;
+		load = 'h0;
+		block = 512'h0;
+		midstate = 256'h0;
+		errors = 0;
+		cycles = 0;
+
+		$display("sha256_pipe, SLOTS = %0d", SLOTS);
+		#(2 * CLK_PERIOD);
+		reset_n = 1'b1;
+		#CLK_PERIOD;
+
+		/* One block per cycle */
+		restart;
+		start_block(0, 1'b1, 1'b0, ONE_BLOCK, 256'h0);
+		start_block(1, 1'b1, 1'b0, TWO_BLOCK_0, 256'h0);
+		start_block(2, 1'b1, 1'b0, TWO_BLOCK_0, 256'h0);
+		start_block(3, 1'b1, 1'b0, ONE_BLOCK, 256'h0);
+		wait_digests;
+		check(0, ONE_DIGEST, LATENCY);
+		check(1, TWO_MIDSTATE, LATENCY + 1);
+		check(2, TWO_MIDSTATE, LATENCY + 2);
+		check(3, ONE_DIGEST, LATENCY + 3);
+
+		/* Second blocks: slot 1 chains its own digest, slot 3 is given one by load (its own is another), with an */
+		/* unrelated block in between (slot 2). Slot 0 is left alone */
+		restart;
+		start_block(1, 1'b0, 1'b0, TWO_BLOCK_1, 256'h0);
+		start_block(2, 1'b1, 1'b0, ONE_BLOCK, 256'h0);
+		start_block(3, 1'b0, 1'b1, TWO_BLOCK_1, TWO_MIDSTATE);
+		wait_digests;
+		check(0, ONE_DIGEST, -1);
+		check(1, TWO_DIGEST, LATENCY);
+		check(2, ONE_DIGEST, LATENCY + 1);
+		check(3, TWO_DIGEST, LATENCY + 2);
+
+		/* A slot started or loaded again drops its block still in the pipeline: slot 0 gets load alone and then */
+		/* next, slot 1 starts over */
+		restart;
+		start_block(0, 1'b1, 1'b0, ONE_BLOCK, 256'h0);
+		start_block(1, 1'b1, 1'b0, TWO_BLOCK_0, 256'h0);
+		load = 'h1;
+		midstate = TWO_MIDSTATE;
+		step;
+		load = 'h0;
+		start_block(0, 1'b0, 1'b0, TWO_BLOCK_1, 256'h0);
+		start_block(1, 1'b1, 1'b0, ONE_BLOCK, 256'h0);
+		wait_digests;
+		check(0, TWO_DIGEST, LATENCY + 3);
+		check(1, ONE_DIGEST, LATENCY + 4);
+
+		$display("%0d error(s)", errors);
+		$finish;
+	end
+
+endmodule